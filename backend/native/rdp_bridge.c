@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <errno.h>
 #include <dlfcn.h>
 #include <time.h>
@@ -34,6 +35,7 @@
 #include <freerdp/client/rdpgfx.h>
 #include <freerdp/client/channels.h>
 #include <freerdp/event.h>
+#include <freerdp/transport_io.h>
 #include <freerdp/codec/planar.h>
 #include <freerdp/codec/progressive.h>
 #include <freerdp/codec/color.h>
@@ -41,6 +43,7 @@
 #include <opus/opus.h>
 #include <winpr/crt.h>
 #include <winpr/synch.h>
+#include <winpr/sysinfo.h>
 #include <winpr/thread.h>
 #include <winpr/collections.h>
 #include <freerdp/codec/region.h>
@@ -66,6 +69,15 @@
 #define RDP_MAX_SESSIONS_MIN 2
 #define RDP_MAX_SESSIONS_MAX 1000
 
+/* Absolute pointer positions remembered for dropping server echoes, and how
+ * long one stays an echo candidate (older matches are genuine server warps) */
+#define RDP_POINTER_ECHO_HISTORY 16
+#define RDP_POINTER_ECHO_WINDOW_MS 1000
+
+/* Input mailbox slots only key/button releases may use, so a flood of moves
+ * or presses can never strand a key or button down on the server */
+#define RDP_INPUT_RELEASE_RESERVE 64
+
 /* Forward declaration of internal FreeRDP cache structures.
  * These are internal (FREERDP_LOCAL) in FreeRDP but we need them for
  * pointer caching since DeactivateClientDecoding=TRUE skips the normal
@@ -86,6 +98,13 @@ typedef struct _BridgeCache {
     void* nine_grid;           /* rdpNineGridCache* - unused by us */
 } BridgeCache;
 
+/* Input mailbox slot. seq == position: free for the producer claiming that
+ * position; seq == position + 1: record published, ready to drain. */
+typedef struct {
+    _Atomic uint32_t seq;
+    RdpInputRecord rec;
+} InputSlot;
+
 /* Extended client context */
 typedef struct {
     rdpClientContext common;        /* Must be first */
@@ -94,6 +113,14 @@ typedef struct {
     RdpState state;
     char error_msg[MAX_ERROR_LEN];
     
+    /* Connect-phase timing (ms since rdp_connect started, 0 = not reached).
+     * Phases before connect_ms are written by the connecting thread inside
+     * freerdp_connect(); connect_ms and the GFX phases under gfx_mutex. */
+    uint64_t connect_start_ms;
+    RdpConnectTiming connect_timing;
+    rdpTransportIo transport_io;    /* FreeRDP's I/O callbacks, wrapped for timing */
+    uint32_t reconnect_count;       /* Successful auto-reconnects (gfx_mutex) */
+    
     /* Frame dimensions (tracked for resize detection) */
     int frame_width;
     int frame_height;
@@ -111,7 +138,6 @@ typedef struct {
     bool gfx_active;                /* GFX pipeline successfully initialized */
     bool gfx_disconnecting;         /* Connection is being torn down - don't call GDI */
     RdpGfxCodecId gfx_codec;        /* Negotiated codec */
-    bool gfx_pipeline_needs_init;   /* Deferred GFX pipeline init flag */
     bool gfx_pipeline_ready;        /* GFX pipeline ready for events */
     
     /* GFX surfaces */
@@ -121,6 +147,27 @@ typedef struct {
     uint32_t last_completed_frame_id; /* Last frame ID that completed (EndFrame called) */
     uint32_t frame_cmd_count;       /* Commands received in current frame */
     bool gfx_frame_in_progress;     /* True between StartFrame and EndFrame */
+    bool send_paused;               /* WebSocket send buffer above high-water mark */
+    uint32_t send_backlog_frames;   /* Frames still buffered for the browser */
+    
+    /* Detached session with no browser (rdp_set_headless). GFX events are
+     * dropped before any decode/encode work and frames are acked at once.
+     * Switches are requested under gfx_mutex and applied by rdp_poll. */
+    atomic_bool headless;
+    bool headless_requested;
+    bool graphics_resync_pending;   /* Re-queue GFX state and repaint (rdp_request_refresh) */
+    bool output_suppressed;         /* Suppress Output sent on this connection (rdp_poll thread) */
+    uint32_t headless_frames_acked;
+    uint32_t gfx_caps_version;      /* Last CAPS_CONFIRM, re-sent on resync */
+    uint32_t gfx_caps_flags;
+    
+    /* GFX cache slots the server holds, and the subset the browser lacks
+     * because their SurfaceToCache never reached it (dropped while headless).
+     * A repaint cannot rebuild cache content. Guarded by gfx_event_mutex. */
+    uint8_t gfx_cache_held[RDP_GFX_CACHE_SLOTS / 8 + 1];
+    uint8_t gfx_cache_missing[RDP_GFX_CACHE_SLOTS / 8 + 1];
+    uint32_t gfx_cache_held_count;
+    uint32_t gfx_cache_missing_count;
     pthread_mutex_t gfx_mutex;
     
     /* Audio playback */
@@ -172,6 +219,40 @@ typedef struct {
     int gfx_event_count;
     pthread_mutex_t gfx_event_mutex;
     
+    /* Input mailbox: bounded lock-free MPSC ring. Any thread may post via
+     * rdp_send_*; only rdp_poll (the thread driving the connection) drains
+     * it, so all injection happens on the I/O thread. */
+    InputSlot input_slots[RDP_INPUT_QUEUE_MAX];
+    _Atomic uint32_t input_head;    /* Next position producers claim */
+    _Atomic uint32_t input_tail;    /* Next position to drain (written by poll thread only) */
+    atomic_int input_signalled;     /* input_event already set since last drain */
+    atomic_int input_release_lost;  /* A release found even the reserve full */
+    uint64_t input_keys_down[8];    /* Injected scancodes held, bit (ext << 8 | code) (poll thread) */
+    uint16_t input_buttons_down;    /* Injected RDP_MOUSE_FLAG_BUTTON* held (poll thread) */
+    HANDLE input_event;             /* Wakes rdp_poll when input is posted */
+    int32_t pointer_x;              /* Last absolute pointer position (poll thread), */
+    int32_t pointer_y;              /* base for relative input without server support */
+    uint32_t pointer_history[RDP_POINTER_ECHO_HISTORY]; /* Recently injected (x << 16 | y) */
+    uint64_t pointer_history_ms[RDP_POINTER_ECHO_HISTORY]; /* Injection time per entry */
+    int pointer_history_pos;
+    
+    /* Browser cursor cache mirror: content hash per slot (0 = empty) and
+     * LRU stamps. Touched only from pointer callbacks on the poll thread. */
+    uint64_t pointer_client_hash[RDP_POINTER_CLIENT_CACHE];
+    uint32_t pointer_client_used[RDP_POINTER_CLIENT_CACHE];
+    uint32_t pointer_client_tick;
+    
+    /* Current cursor, queued again for a browser on resync (poll thread).
+     * pointer_current_data is NULL for system cursors. */
+    uint8_t* pointer_current_data;
+    uint32_t pointer_current_size;
+    uint32_t pointer_current_width;
+    uint32_t pointer_current_height;
+    uint32_t pointer_current_hotspot_x;
+    uint32_t pointer_current_hotspot_y;
+    uint64_t pointer_current_hash;
+    uint8_t pointer_current_system;  /* 0 = hidden, 1 = default */
+    
 } BridgeContext;
 
 /* Forward declarations */
@@ -204,8 +285,10 @@ static UINT gfx_on_cache_import_reply(RdpgfxClientContext* context, const RDPGFX
 static UINT gfx_on_open(RdpgfxClientContext* context, BOOL* do_caps_advertise, BOOL* do_frame_acks);
 
 /* GFX event queue helpers */
-static void gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event);
+static bool gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event);
 static void gfx_free_event_data(RdpGfxEvent* event);
+static void gfx_drop_oldest_event(BridgeContext* ctx);
+static void gfx_drop_events(BridgeContext* ctx, uint32_t queue_depth);
 
 /* WebP tile encoding helper */
 static void queue_webp_tile(BridgeContext* ctx, uint16_t surface_id,
@@ -220,20 +303,18 @@ static bool transcode_avc444(BridgeContext* ctx,
                              const uint8_t* chroma_data, uint32_t chroma_size,
                              uint8_t** out_data, uint32_t* out_size);
 
-/* Deferred GDI pipeline initialization - call from main thread */
-static void maybe_init_gfx_pipeline(BridgeContext* bctx);
+/* Input queue helpers */
+static int input_enqueue(BridgeContext* ctx, const RdpInputRecord* records, int count);
+static void input_flush(BridgeContext* ctx);
+static bool pointer_is_echo(BridgeContext* ctx, uint32_t x, uint32_t y);
 
-/* Global audio context structure for plugin communication.
- * This is a regular global (not thread-local) because the rdpsnd plugin
- * runs in a different thread from the main Python thread, and we need
- * both threads to access the same buffer.
- * 
- * MULTI-SESSION NOTE: This global is protected by g_connect_mutex during the
- * connect phase. Each session has its own audio buffer; this global just
- * serves as a handoff mechanism to the plugin during Open callback.
+/* Legacy audio context handoff for plugins that cannot resolve their session.
+ * The rdpsnd bridge plugin looks its session up by rdpContext at Open time
+ * (rdp_lookup_session_by_rdpcontext), so connects never touch this global
+ * and run fully in parallel. It is only filled by rdp_set_audio_context().
  * 
- * For multi-session support, write_pos and read_pos are POINTERS to the
- * actual positions in the BridgeContext. */
+ * write_pos and read_pos are POINTERS to the actual positions in the
+ * BridgeContext. */
 static struct {
     uint8_t* opus_buffer;
     size_t opus_buffer_size;
@@ -245,8 +326,13 @@ static struct {
     volatile int* initialized;      /* POINTER to BridgeContext.opus_initialized */
 } g_audio_ctx;
 
-/* Mutex to protect the connect phase (g_audio_ctx handoff to plugin) */
-static pthread_mutex_t g_connect_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Milliseconds since rdp_connect() started, at least 1 so 0 means "not reached" */
+static uint32_t connect_elapsed_ms(BridgeContext* ctx)
+{
+    uint64_t elapsed = GetTickCount64() - ctx->connect_start_ms;
+    if (elapsed == 0) return 1;
+    return elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+}
 
 /* Mutex for thread-safe logging to stderr */
 static pthread_mutex_t g_log_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -680,15 +766,76 @@ static void log_caps_confirm(UINT32 version, UINT32 flags)
  * Session Lifecycle
  * ============================================================================ */
 
-RdpSession* rdp_create(
-    const char* host,
-    uint16_t port,
-    const char* username,
-    const char* password,
-    const char* domain,
-    uint32_t width,
-    uint32_t height,
-    uint32_t bpp)
+/* Free a context built by bridge_context_new(), connected or not: the
+ * BridgeContext resources first, then the FreeRDP context itself. Every
+ * path that drops a context (rdp_destroy, failed rdp_create, pool shrink)
+ * goes through here. */
+static void bridge_context_free(rdpContext* context)
+{
+    BridgeContext* ctx = (BridgeContext*)context;
+    
+    /* Cleanup transcoder */
+    cleanup_transcoder(ctx);
+    
+    pthread_mutex_destroy(&ctx->audio_mutex);
+    pthread_mutex_destroy(&ctx->opus_mutex);
+    pthread_mutex_destroy(&ctx->gfx_mutex);
+    pthread_mutex_destroy(&ctx->gfx_event_mutex);
+    if (ctx->input_event) {
+        CloseHandle(ctx->input_event);
+        ctx->input_event = NULL;
+    }
+    
+    /* Free audio resources */
+    if (ctx->opus_encoder) {
+        opus_encoder_destroy(ctx->opus_encoder);
+        ctx->opus_encoder = NULL;
+    }
+    if (ctx->audio_buffer) {
+        free(ctx->audio_buffer);
+        ctx->audio_buffer = NULL;
+    }
+    if (ctx->opus_buffer) {
+        free(ctx->opus_buffer);
+        ctx->opus_buffer = NULL;
+    }
+    free(ctx->pointer_current_data);
+    ctx->pointer_current_data = NULL;
+    
+    /* Free any pending GFX event data (allocated buffers in unread events) */
+    if (ctx->gfx_events) {
+        while (ctx->gfx_event_count > 0) {
+            RdpGfxEvent* event = &ctx->gfx_events[ctx->gfx_event_read_idx];
+            gfx_free_event_data(event);
+            ctx->gfx_event_read_idx = (ctx->gfx_event_read_idx + 1) % ctx->gfx_events_capacity;
+            ctx->gfx_event_count--;
+        }
+        free(ctx->gfx_events);
+        ctx->gfx_events = NULL;
+    }
+    
+    /* Free planar decoder (may already be freed in bridge_post_disconnect, but safe to check) */
+    if (ctx->planar_decoder) {
+        freerdp_bitmap_planar_context_free(ctx->planar_decoder);
+        ctx->planar_decoder = NULL;
+    }
+    
+    /* Ensure GDI resources are freed (may already be freed by bridge_post_disconnect).
+     * This is a safety net for server-initiated disconnects where PostDisconnect
+     * callback might not be called or might be called with incomplete cleanup. */
+    freerdp* instance = context->instance;
+    if (instance && context->gdi) {
+        fprintf(stderr, "[rdp_bridge] bridge_context_free: forcing gdi_free (gdi was still allocated)\n");
+        gdi_free(instance);
+    }
+    
+    freerdp_client_context_free(context);
+}
+
+/* Build an unconnected context with buffers allocated and every
+ * session-independent setting applied. Host, credentials and desktop size
+ * are filled in by rdp_create(). */
+static rdpContext* bridge_context_new(void)
 {
     rdpContext* context = NULL;
     freerdp* instance = NULL;
@@ -715,6 +862,27 @@ RdpSession* rdp_create(
     pthread_mutex_init(&ctx->opus_mutex, NULL);
     pthread_mutex_init(&ctx->gfx_mutex, NULL);
     pthread_mutex_init(&ctx->gfx_event_mutex, NULL);
+    for (uint32_t i = 0; i < RDP_INPUT_QUEUE_MAX; i++) {
+        atomic_init(&ctx->input_slots[i].seq, i);
+    }
+    atomic_init(&ctx->input_head, 0);
+    atomic_init(&ctx->input_tail, 0);
+    atomic_init(&ctx->input_release_lost, 0);
+    memset(ctx->input_keys_down, 0, sizeof(ctx->input_keys_down));
+    ctx->input_buttons_down = 0;
+    atomic_init(&ctx->input_signalled, 0);
+    atomic_init(&ctx->headless, false);
+    ctx->input_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    ctx->pointer_x = 0;
+    ctx->pointer_y = 0;
+    memset(ctx->pointer_history, 0xFF, sizeof(ctx->pointer_history));
+    memset(ctx->pointer_history_ms, 0, sizeof(ctx->pointer_history_ms));
+    ctx->pointer_history_pos = 0;
+    memset(ctx->pointer_client_hash, 0, sizeof(ctx->pointer_client_hash));
+    memset(ctx->pointer_client_used, 0, sizeof(ctx->pointer_client_used));
+    ctx->pointer_client_tick = 0;
+    ctx->pointer_current_data = NULL;
+    ctx->pointer_current_system = 1;
     ctx->audio_initialized = false;
     ctx->audio_buffer = NULL;
     ctx->audio_buffer_size = 0;
@@ -750,8 +918,8 @@ RdpSession* rdp_create(
     ctx->opus_channels = 2;
     ctx->opus_initialized = 0;
     
-    /* NOTE: g_audio_ctx is now set in rdp_connect() under g_connect_mutex lock
-     * to ensure thread-safe handoff to the plugin during connect */
+    /* No audio handoff needed here: the rdpsnd plugin finds this session
+     * through the registry by rdpContext when its Open callback runs */
     
     /* Set callbacks */
     instance->PreConnect = bridge_pre_connect;
@@ -764,26 +932,6 @@ RdpSession* rdp_create(
     /* Configure settings */
     settings = context->settings;
     
-    /* Connection */
-    if (!freerdp_settings_set_string(settings, FreeRDP_ServerHostname, host)) goto fail;
-    if (!freerdp_settings_set_uint32(settings, FreeRDP_ServerPort, port)) goto fail;
-    
-    /* Credentials */
-    if (username && *username) {
-        if (!freerdp_settings_set_string(settings, FreeRDP_Username, username)) goto fail;
-    }
-    if (password && *password) {
-        if (!freerdp_settings_set_string(settings, FreeRDP_Password, password)) goto fail;
-    }
-    if (domain && *domain) {
-        if (!freerdp_settings_set_string(settings, FreeRDP_Domain, domain)) goto fail;
-    }
-    
-    /* Display settings */
-    if (!freerdp_settings_set_uint32(settings, FreeRDP_DesktopWidth, width)) goto fail;
-    if (!freerdp_settings_set_uint32(settings, FreeRDP_DesktopHeight, height)) goto fail;
-    if (!freerdp_settings_set_uint32(settings, FreeRDP_ColorDepth, bpp)) goto fail;
-    
     /* WIRE-THROUGH MODE: Enable SoftwareGdi but with DeactivateClientDecoding.
      * 
      * SoftwareGdi=TRUE: FreeRDP expects this for proper internal state management.
@@ -834,9 +982,6 @@ RdpSession* rdp_create(
     if (!freerdp_settings_set_bool(settings, FreeRDP_AudioCapture, FALSE)) goto fail;
     if (!freerdp_settings_set_bool(settings, FreeRDP_RemoteConsoleAudio, FALSE)) goto fail;
     
-    /* Log all settings for troubleshooting - and also send to the gfx_queue */
-    log_settings(settings, "rdp_create");
-
     /* Add rdpsnd to STATIC channel collection with sys:bridge */
     {
         ADDIN_ARGV* args = freerdp_addin_argv_new(2, (const char*[]){"rdpsnd", "sys:bridge"});
@@ -905,6 +1050,151 @@ RdpSession* rdp_create(
     if (!freerdp_settings_set_bool(settings, FreeRDP_SupportDisplayControl, TRUE)) goto fail;
     if (!freerdp_settings_set_bool(settings, FreeRDP_DynamicResolutionUpdate, TRUE)) goto fail;
     
+    /* Auto-reconnect: keep the server's ARC cookie so a dropped transport
+     * resumes the same logon session instead of a fresh login */
+    if (!freerdp_settings_set_bool(settings, FreeRDP_AutoReconnectionEnabled, TRUE)) goto fail;
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_AutoReconnectMaxRetries,
+                                     RDP_AUTO_RECONNECT_MAX_RETRIES)) goto fail;
+    
+    return context;
+    
+fail:
+    if (context) {
+        bridge_context_free(context);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Pre-warmed Context Pool
+ * 
+ * rdp_create() takes a ready context from here when one is available, so
+ * allocation and settings setup stay off the connect path. Contexts are
+ * handed out once and never returned: a disconnected FreeRDP context keeps
+ * transport and channel state, so rdp_pool_fill() builds fresh ones.
+ * ============================================================================ */
+
+static rdpContext* g_pool[RDP_POOL_SIZE_MAX];
+static int g_pool_count = 0;
+static int g_pool_target = 0;
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int rdp_pool_set_size(int size)
+{
+    rdpContext* excess[RDP_POOL_SIZE_MAX];
+    int excess_count = 0;
+    
+    if (size < 0) size = 0;
+    if (size > RDP_POOL_SIZE_MAX) size = RDP_POOL_SIZE_MAX;
+    
+    pthread_mutex_lock(&g_pool_mutex);
+    g_pool_target = size;
+    while (g_pool_count > g_pool_target) {
+        excess[excess_count++] = g_pool[--g_pool_count];
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    
+    for (int i = 0; i < excess_count; i++) {
+        bridge_context_free(excess[i]);
+    }
+    return size;
+}
+
+int rdp_pool_fill(void)
+{
+    int added = 0;
+    
+    for (;;) {
+        pthread_mutex_lock(&g_pool_mutex);
+        bool full = g_pool_count >= g_pool_target;
+        pthread_mutex_unlock(&g_pool_mutex);
+        if (full) break;
+        
+        /* Build outside the lock so rdp_create() is never blocked by a refill */
+        rdpContext* context = bridge_context_new();
+        if (!context) {
+            fprintf(stderr, "[rdp_bridge] ERROR: Failed to pre-warm session context\n");
+            return added > 0 ? added : -1;
+        }
+        
+        pthread_mutex_lock(&g_pool_mutex);
+        if (g_pool_count < g_pool_target) {
+            g_pool[g_pool_count++] = context;
+            context = NULL;
+            added++;
+        }
+        pthread_mutex_unlock(&g_pool_mutex);
+        
+        if (context) {
+            /* Pool shrank while we were building */
+            bridge_context_free(context);
+            break;
+        }
+    }
+    
+    return added;
+}
+
+int rdp_pool_available(void)
+{
+    pthread_mutex_lock(&g_pool_mutex);
+    int count = g_pool_count;
+    pthread_mutex_unlock(&g_pool_mutex);
+    return count;
+}
+
+RdpSession* rdp_create(
+    const char* host,
+    uint16_t port,
+    const char* username,
+    const char* password,
+    const char* domain,
+    uint32_t width,
+    uint32_t height,
+    uint32_t bpp)
+{
+    rdpContext* context = NULL;
+    rdpSettings* settings = NULL;
+    
+    pthread_mutex_lock(&g_pool_mutex);
+    if (g_pool_count > 0) {
+        context = g_pool[--g_pool_count];
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+    
+    if (!context) {
+        context = bridge_context_new();
+        if (!context) {
+            return NULL;
+        }
+    }
+    
+    BridgeContext* ctx = (BridgeContext*)context;
+    settings = context->settings;
+    
+    /* Connection */
+    if (!freerdp_settings_set_string(settings, FreeRDP_ServerHostname, host)) goto fail;
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_ServerPort, port)) goto fail;
+    
+    /* Credentials */
+    if (username && *username) {
+        if (!freerdp_settings_set_string(settings, FreeRDP_Username, username)) goto fail;
+    }
+    if (password && *password) {
+        if (!freerdp_settings_set_string(settings, FreeRDP_Password, password)) goto fail;
+    }
+    if (domain && *domain) {
+        if (!freerdp_settings_set_string(settings, FreeRDP_Domain, domain)) goto fail;
+    }
+    
+    /* Display settings */
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_DesktopWidth, width)) goto fail;
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_DesktopHeight, height)) goto fail;
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_ColorDepth, bpp)) goto fail;
+    
+    /* Log all settings for troubleshooting - and also send to the gfx_queue */
+    log_settings(settings, "rdp_create");
+
     /* Register session in the registry for multi-user audio isolation */
     int reg_result = session_registry_add(context, ctx);
     if (reg_result == -2) {
@@ -923,7 +1213,7 @@ RdpSession* rdp_create(
     
 fail:
     if (context) {
-        freerdp_client_context_free(context);
+        bridge_context_free(context);
     }
     return NULL;
 }
@@ -938,26 +1228,20 @@ int rdp_connect(RdpSession* session)
     
     ctx->state = RDP_STATE_CONNECTING;
     
-    /* Lock to protect g_audio_ctx handoff to the plugin during connect.
-     * The plugin's Open callback reads g_audio_ctx, so we must ensure
-     * no other session overwrites it during our connect operation. */
-    pthread_mutex_lock(&g_connect_mutex);
+    /* No process-wide lock: each session is registered by rdpContext in
+     * rdp_create(), which is all the rdpsnd plugin needs to find its buffer */
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    memset(&ctx->connect_timing, 0, sizeof(ctx->connect_timing));
+    ctx->connect_start_ms = GetTickCount64();
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    BOOL connected = freerdp_connect(instance);
     
-    /* Set up the global audio context to point to THIS session's buffer.
-     * The plugin will read this during its Open callback.
-     * Use POINTERS for write_pos, read_pos, initialized so the plugin
-     * can update the actual values in BridgeContext. */
-    g_audio_ctx.opus_buffer = ctx->opus_buffer;
-    g_audio_ctx.opus_buffer_size = ctx->opus_buffer_size;
-    g_audio_ctx.opus_write_pos = &ctx->opus_write_pos;
-    g_audio_ctx.opus_read_pos = &ctx->opus_read_pos;
-    g_audio_ctx.opus_mutex = &ctx->opus_mutex;
-    g_audio_ctx.sample_rate = ctx->opus_sample_rate;
-    g_audio_ctx.channels = ctx->opus_channels;
-    g_audio_ctx.initialized = &ctx->opus_initialized;
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    ctx->connect_timing.connect_ms = connect_elapsed_ms(ctx);
+    pthread_mutex_unlock(&ctx->gfx_mutex);
     
-    if (!freerdp_connect(instance)) {
-        pthread_mutex_unlock(&g_connect_mutex);
+    if (!connected) {
         UINT32 error = freerdp_get_last_error(context);
         snprintf(ctx->error_msg, MAX_ERROR_LEN, 
                  "Connection failed: 0x%08X", error);
@@ -965,17 +1249,32 @@ int rdp_connect(RdpSession* session)
         return -1;
     }
     
-    /* Set up audio context for the RDPSND bridge plugin AFTER connecting.
-     * The plugin is loaded by FreeRDP during freerdp_connect(), so we need
-     * to call rdp_set_audio_context after the plugin is available. */
-    rdp_set_audio_context(session);
-    
-    pthread_mutex_unlock(&g_connect_mutex);
-    
     ctx->state = RDP_STATE_CONNECTED;
     return 0;
 }
 
+int rdp_get_connect_timing(RdpSession* session, RdpConnectTiming* timing)
+{
+    if (!session || !timing) return -1;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    *timing = ctx->connect_timing;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    return 0;
+}
+
+uint32_t rdp_get_reconnect_count(RdpSession* session)
+{
+    if (!session) return 0;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    uint32_t count = ctx->reconnect_count;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    return count;
+}
+
 RdpState rdp_get_state(RdpSession* session)
 {
     if (!session) return RDP_STATE_DISCONNECTED;
@@ -1005,7 +1304,7 @@ void rdp_disconnect(RdpSession* session)
      * ERROR state can occur when server terminates connection - we still need
      * to call freerdp_disconnect to trigger PostDisconnect cleanup callback. */
     if (ctx->state == RDP_STATE_CONNECTED || ctx->state == RDP_STATE_CONNECTING || 
-        ctx->state == RDP_STATE_ERROR) {
+        ctx->state == RDP_STATE_ERROR || ctx->state == RDP_STATE_RECONNECTING) {
         fprintf(stderr, "[rdp_bridge] Calling freerdp_disconnect\n");
         freerdp_disconnect(instance);
     } else {
@@ -1018,7 +1317,6 @@ void rdp_destroy(RdpSession* session)
 {
     if (!session) return;
     rdpContext* context = (rdpContext*)session;
-    BridgeContext* ctx = (BridgeContext*)context;
     
     fprintf(stderr, "[rdp_bridge] rdp_destroy: freeing session resources\n");
     
@@ -1027,57 +1325,7 @@ void rdp_destroy(RdpSession* session)
     
     rdp_disconnect(session);
     
-    /* Cleanup transcoder */
-    cleanup_transcoder(ctx);
-    
-    pthread_mutex_destroy(&ctx->audio_mutex);
-    pthread_mutex_destroy(&ctx->opus_mutex);
-    pthread_mutex_destroy(&ctx->gfx_mutex);
-    pthread_mutex_destroy(&ctx->gfx_event_mutex);
-    
-    /* Free audio resources */
-    if (ctx->opus_encoder) {
-        opus_encoder_destroy(ctx->opus_encoder);
-        ctx->opus_encoder = NULL;
-    }
-    if (ctx->audio_buffer) {
-        free(ctx->audio_buffer);
-        ctx->audio_buffer = NULL;
-    }
-    if (ctx->opus_buffer) {
-        free(ctx->opus_buffer);
-        ctx->opus_buffer = NULL;
-    }
-    
-    /* Free any pending GFX event data (allocated buffers in unread events) */
-    if (ctx->gfx_events) {
-        while (ctx->gfx_event_count > 0) {
-            RdpGfxEvent* event = &ctx->gfx_events[ctx->gfx_event_read_idx];
-            gfx_free_event_data(event);
-            ctx->gfx_event_read_idx = (ctx->gfx_event_read_idx + 1) % ctx->gfx_events_capacity;
-            ctx->gfx_event_count--;
-        }
-        free(ctx->gfx_events);
-        ctx->gfx_events = NULL;
-    }
-    
-    /* Free planar decoder (may already be freed in bridge_post_disconnect, but safe to check) */
-    if (ctx->planar_decoder) {
-        freerdp_bitmap_planar_context_free(ctx->planar_decoder);
-        ctx->planar_decoder = NULL;
-    }
-    
-    /* Ensure GDI resources are freed (may already be freed by bridge_post_disconnect).
-     * This is a safety net for server-initiated disconnects where PostDisconnect
-     * callback might not be called or might be called with incomplete cleanup. */
-    freerdp* instance = context->instance;
-    if (instance && context->gdi) {
-        fprintf(stderr, "[rdp_bridge] rdp_destroy: forcing gdi_free (gdi was still allocated)\n");
-        gdi_free(instance);
-    }
-    
-    fprintf(stderr, "[rdp_bridge] rdp_destroy: calling freerdp_client_context_free\n");
-    freerdp_client_context_free(context);
+    bridge_context_free(context);
     
     /* Force glibc to return freed memory to the OS */
     malloc_trim(0);
@@ -1096,8 +1344,55 @@ typedef struct {
     rdpPointer base;        /* Must be first - inherited from rdpPointer */
     uint8_t* bgra_data;     /* Pre-converted BGRA32 image */
     uint32_t bgra_size;     /* Size of bgra_data */
+    uint64_t hash;          /* Content hash (image + size + hotspot), never 0 */
 } BridgePointer;
 
+/* FNV-1a 64-bit over the converted cursor, its size and hotspot */
+static uint64_t pointer_content_hash(const rdpPointer* pointer, const uint8_t* data, uint32_t size)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const uint32_t dims[4] = { pointer->width, pointer->height, pointer->xPos, pointer->yPos };
+    const uint8_t* p = (const uint8_t*)dims;
+    
+    for (size_t i = 0; i < sizeof(dims); i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    }
+    return h ? h : 1;
+}
+
+/* Find the browser cache slot holding this cursor, or pick the least
+ * recently used one to replace. Returns the slot; *hit tells whether the
+ * browser already has the bitmap. A miss only claims the slot once its
+ * POINTER_SET is queued (pointer_client_store). */
+static uint16_t pointer_client_slot(BridgeContext* bctx, uint64_t hash, bool* hit)
+{
+    int victim = 0;
+    
+    bctx->pointer_client_tick++;
+    for (int i = 0; i < RDP_POINTER_CLIENT_CACHE; i++) {
+        if (bctx->pointer_client_hash[i] == hash) {
+            bctx->pointer_client_used[i] = bctx->pointer_client_tick;
+            *hit = true;
+            return (uint16_t)i;
+        }
+        if (bctx->pointer_client_used[i] < bctx->pointer_client_used[victim]) {
+            victim = i;
+        }
+    }
+    
+    *hit = false;
+    return (uint16_t)victim;
+}
+
+static void pointer_client_store(BridgeContext* bctx, uint16_t slot, uint64_t hash)
+{
+    bctx->pointer_client_hash[slot] = hash;
+    bctx->pointer_client_used[slot] = bctx->pointer_client_tick;
+}
+
 /* Pointer::New - Convert cursor data to BGRA32 */
 static BOOL bridge_pointer_new(rdpContext* context, rdpPointer* pointer)
 {
@@ -1124,6 +1419,7 @@ static BOOL bridge_pointer_new(rdpContext* context, rdpPointer* pointer)
         return FALSE;
     }
     
+    bp->hash = pointer_content_hash(pointer, bp->bgra_data, bp->bgra_size);
     return TRUE;
 }
 
@@ -1137,37 +1433,91 @@ static void bridge_pointer_free(rdpContext* context, rdpPointer* pointer)
     }
 }
 
-/* Pointer::Set - Queue cursor bitmap for frontend */
-static BOOL bridge_pointer_set(rdpContext* context, const rdpPointer* pointer)
+/* Queue a cursor bitmap, or only its cache slot if the browser already has
+ * identical pixels */
+static BOOL queue_pointer_bitmap(BridgeContext* bctx, uint32_t width, uint32_t height,
+                                 uint32_t hotspot_x, uint32_t hotspot_y,
+                                 const uint8_t* bgra, uint32_t size, uint64_t hash)
 {
-    BridgeContext* bctx = (BridgeContext*)context;
-    const BridgePointer* bp = (const BridgePointer*)pointer;
+    bool hit = false;
+    uint16_t slot = pointer_client_slot(bctx, hash, &hit);
     
-    if (!bp || !bp->bgra_data) return FALSE;
+    if (hit) {
+        RdpGfxEvent event = {0};
+        event.type = RDP_GFX_EVENT_POINTER_CACHED;
+        event.pointer_cache_id = slot;
+        gfx_queue_event(bctx, &event);
+        return TRUE;
+    }
     
     /* Copy BGRA data for event queue (Python will free) */
-    uint8_t* data_copy = (uint8_t*)malloc(bp->bgra_size);
+    uint8_t* data_copy = (uint8_t*)malloc(size);
     if (!data_copy) return FALSE;
-    memcpy(data_copy, bp->bgra_data, bp->bgra_size);
+    memcpy(data_copy, bgra, size);
     
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_POINTER_SET;
-    event.pointer_width = pointer->width;
-    event.pointer_height = pointer->height;
-    event.pointer_hotspot_x = pointer->xPos;
-    event.pointer_hotspot_y = pointer->yPos;
+    event.pointer_width = width;
+    event.pointer_height = height;
+    event.pointer_hotspot_x = hotspot_x;
+    event.pointer_hotspot_y = hotspot_y;
     event.pointer_data = data_copy;
-    event.pointer_data_size = bp->bgra_size;
+    event.pointer_data_size = size;
+    event.pointer_cache_id = slot;
     
-    gfx_queue_event(bctx, &event);
+    if (gfx_queue_event(bctx, &event)) {
+        pointer_client_store(bctx, slot, hash);
+    }
     return TRUE;
 }
 
+/* Remember the current cursor for resync (bp NULL = system cursor) */
+static void pointer_remember(BridgeContext* bctx, const BridgePointer* bp, uint8_t system_type)
+{
+    if (bp && bctx->pointer_current_data && bctx->pointer_current_hash == bp->hash) {
+        return;
+    }
+    
+    free(bctx->pointer_current_data);
+    bctx->pointer_current_data = NULL;
+    bctx->pointer_current_system = system_type;
+    if (!bp) return;
+    
+    /* Without a copy the resync falls back to the default cursor */
+    bctx->pointer_current_data = (uint8_t*)malloc(bp->bgra_size);
+    if (!bctx->pointer_current_data) return;
+    memcpy(bctx->pointer_current_data, bp->bgra_data, bp->bgra_size);
+    bctx->pointer_current_size = bp->bgra_size;
+    bctx->pointer_current_width = bp->base.width;
+    bctx->pointer_current_height = bp->base.height;
+    bctx->pointer_current_hotspot_x = bp->base.xPos;
+    bctx->pointer_current_hotspot_y = bp->base.yPos;
+    bctx->pointer_current_hash = bp->hash;
+}
+
+/* Pointer::Set - Queue cursor bitmap for frontend, or only its cache slot
+ * if the browser already has identical pixels (hover toggles between a
+ * handful of cursors, each up to 384x384x4 bytes) */
+static BOOL bridge_pointer_set(rdpContext* context, const rdpPointer* pointer)
+{
+    BridgeContext* bctx = (BridgeContext*)context;
+    const BridgePointer* bp = (const BridgePointer*)pointer;
+    
+    if (!bp || !bp->bgra_data) return FALSE;
+    
+    pointer_remember(bctx, bp, 1);
+    return queue_pointer_bitmap(bctx, pointer->width, pointer->height,
+                                pointer->xPos, pointer->yPos,
+                                bp->bgra_data, bp->bgra_size, bp->hash);
+}
+
 /* Pointer::SetNull - Hide cursor */
 static BOOL bridge_pointer_set_null(rdpContext* context)
 {
     BridgeContext* bctx = (BridgeContext*)context;
     
+    pointer_remember(bctx, NULL, 0);
+    
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_POINTER_SYSTEM;
     event.pointer_system_type = 0;  /* Null/hidden */
@@ -1181,6 +1531,8 @@ static BOOL bridge_pointer_set_default(rdpContext* context)
 {
     BridgeContext* bctx = (BridgeContext*)context;
     
+    pointer_remember(bctx, NULL, 1);
+    
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_POINTER_SYSTEM;
     event.pointer_system_type = 1;  /* Default system cursor */
@@ -1194,6 +1546,16 @@ static BOOL bridge_pointer_set_position(rdpContext* context, UINT32 x, UINT32 y)
 {
     BridgeContext* bctx = (BridgeContext*)context;
     
+    /* Echo of a position we injected (the browser already drew it, and it
+     * may be older than input since sent) - don't stream it */
+    if (pointer_is_echo(bctx, x, y)) {
+        return TRUE;
+    }
+    
+    /* Server warped the cursor: relative fallback continues from here */
+    bctx->pointer_x = (int32_t)x;
+    bctx->pointer_y = (int32_t)y;
+    
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_POINTER_POSITION;
     event.pointer_x = (uint16_t)x;
@@ -1468,49 +1830,186 @@ static BOOL bridge_update_pointer_cached(rdpContext* context,
 }
 
 /* ============================================================================
- * Deferred GDI Pipeline Initialization
+ * Event Processing & Frame Capture
  * ============================================================================ */
 
-static void maybe_init_gfx_pipeline(BridgeContext* bctx)
+/* Queue the GFX state a browser without surfaces needs before the repaint:
+ * capabilities, settings, a graphics reset and each live surface with its
+ * output mapping. The bitmap cache cannot be rebuilt (nothing is decoded
+ * here), see rdp_gfx_cache_resumable. */
+static void queue_graphics_state(BridgeContext* ctx)
 {
-    /* Check if deferred initialization is needed */
-    pthread_mutex_lock(&bctx->gfx_mutex);
-    bool needs_init = bctx->gfx_pipeline_needs_init && !bctx->gfx_pipeline_ready;
-    RdpgfxClientContext* gfx = bctx->gfx;
-    pthread_mutex_unlock(&bctx->gfx_mutex);
+    rdpContext* context = (rdpContext*)ctx;
+    RdpGfxSurface surfaces[RDP_MAX_GFX_SURFACES];
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    bool active = ctx->gfx_active;
+    uint32_t caps_version = ctx->gfx_caps_version;
+    uint32_t caps_flags = ctx->gfx_caps_flags;
+    uint32_t width = (uint32_t)ctx->frame_width;
+    uint32_t height = (uint32_t)ctx->frame_height;
+    memcpy(surfaces, ctx->surfaces, sizeof(surfaces));
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    /* Before the pipeline is up the server sends all of this itself */
+    if (!active || !caps_version) return;
+    
+    RdpGfxEvent event = {0};
+    event.type = RDP_GFX_EVENT_CAPS_CONFIRM;
+    event.gfx_version = caps_version;
+    event.gfx_flags = caps_flags;
+    gfx_queue_event(ctx, &event);
+    
+    queue_init_settings(ctx, context->settings);
+    
+    memset(&event, 0, sizeof(event));
+    event.type = RDP_GFX_EVENT_RESET_GRAPHICS;
+    event.width = width;
+    event.height = height;
+    gfx_queue_event(ctx, &event);
     
-    if (!needs_init || !gfx) {
+    for (int i = 0; i < RDP_MAX_GFX_SURFACES; i++) {
+        if (!surfaces[i].active) continue;
+        
+        memset(&event, 0, sizeof(event));
+        event.type = RDP_GFX_EVENT_CREATE_SURFACE;
+        event.surface_id = surfaces[i].surface_id;
+        event.width = surfaces[i].width;
+        event.height = surfaces[i].height;
+        event.pixel_format = surfaces[i].pixel_format;
+        gfx_queue_event(ctx, &event);
+        
+        if (surfaces[i].mapped_to_output) {
+            memset(&event, 0, sizeof(event));
+            event.type = RDP_GFX_EVENT_MAP_SURFACE;
+            event.surface_id = surfaces[i].surface_id;
+            event.x = surfaces[i].output_x;
+            event.y = surfaces[i].output_y;
+            gfx_queue_event(ctx, &event);
+        }
+    }
+}
+
+/* Queue the current cursor for a browser whose cursor cache may be empty:
+ * forget what the mirror says it holds, so no PCUR names a missing shape */
+static void queue_pointer_state(BridgeContext* ctx)
+{
+    memset(ctx->pointer_client_hash, 0, sizeof(ctx->pointer_client_hash));
+    memset(ctx->pointer_client_used, 0, sizeof(ctx->pointer_client_used));
+    
+    if (ctx->pointer_current_data) {
+        queue_pointer_bitmap(ctx, ctx->pointer_current_width, ctx->pointer_current_height,
+                             ctx->pointer_current_hotspot_x, ctx->pointer_current_hotspot_y,
+                             ctx->pointer_current_data, ctx->pointer_current_size,
+                             ctx->pointer_current_hash);
         return;
     }
     
-    /* Check if FreeRDP set up the FrameAcknowledge callback */
-    if (!gfx->FrameAcknowledge) {
-        fprintf(stderr, "[rdp_bridge] WARNING: FrameAcknowledge callback is NULL - acks won't be sent!\n");
+    RdpGfxEvent event = {0};
+    event.type = RDP_GFX_EVENT_POINTER_SYSTEM;
+    event.pointer_system_type = ctx->pointer_current_system;
+    gfx_queue_event(ctx, &event);
+}
+
+/* Suppress Output PDU (MS-RDPBCGR 2.2.11.3): stop or resume display updates.
+ * Resuming makes the server repaint the whole desktop. */
+static bool bridge_suppress_output(BridgeContext* ctx, bool suppress)
+{
+    rdpContext* context = (rdpContext*)ctx;
+    rdpUpdate* update = context->update;
+    
+    ctx->output_suppressed = suppress;
+    if (!freerdp_settings_get_bool(context->settings, FreeRDP_SuppressOutput) ||
+        !update || !update->SuppressOutput) {
+        return false;
     }
     
-    /* PURE GFX MODE: Do NOT call gdi_graphics_pipeline_init()!
-     * 
-     * Per RDPEGFX spec, when GFX is active we handle graphics ONLY via GFX callbacks.
-     * gdi_graphics_pipeline_init registers GDI handlers that expect to run on the
-     * main thread and call gdi_OutputUpdate(), causing crashes on the GFX thread.
-     * 
-     * In wire-through mode, we:
-     * 1. Queue GFX events (tiles, fills, copies) for Python to stream to frontend
-     * 2. Frontend renders directly - no backend pixel buffers needed
-     * 3. Send FrameAcknowledge ourselves
-     */
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    RECTANGLE_16 area = { 0, 0, (UINT16)(ctx->frame_width - 1), (UINT16)(ctx->frame_height - 1) };
+    pthread_mutex_unlock(&ctx->gfx_mutex);
     
-    pthread_mutex_lock(&bctx->gfx_mutex);
-    bctx->gfx_pipeline_needs_init = false;
-    bctx->gfx_pipeline_ready = true;
-    pthread_mutex_unlock(&bctx->gfx_mutex);
+    return update->SuppressOutput(context, suppress ? 0 : 1, suppress ? NULL : &area);
+}
+
+/* Apply rdp_set_headless() / rdp_request_refresh() on the poll thread, so
+ * queued GFX state cannot interleave with events from FreeRDP callbacks */
+static void bridge_apply_output_state(BridgeContext* ctx)
+{
+    rdpContext* context = (rdpContext*)ctx;
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    bool headless = ctx->headless_requested;
+    bool resync = ctx->graphics_resync_pending;
+    ctx->graphics_resync_pending = false;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    bool repainted = false;
+    if (headless != atomic_load(&ctx->headless)) {
+        atomic_store(&ctx->headless, headless);
+        if (headless) {
+            /* The browser that would have shown these is gone */
+            gfx_drop_events(ctx, RDP_GFX_QUEUE_DEPTH_SUSPEND);
+        } else {
+            resync = true;
+        }
+        fprintf(stderr, "[rdp_bridge] %s headless mode\n", headless ? "Entering" : "Leaving");
+    }
     
-    /* GFX callbacks are already set in bridge_on_channel_connected */
+    if (resync) {
+        /* Anything still queued was meant for the browser's old state.
+         * Only a headless session asks the server to stop sending frames. */
+        gfx_drop_events(ctx, headless ? RDP_GFX_QUEUE_DEPTH_SUSPEND : 0);
+        queue_graphics_state(ctx);
+        queue_pointer_state(ctx);
+    }
+    
+    /* Also re-sent after an auto-reconnect (new connection, new server
+     * state). Allowing output again repaints the whole desktop. */
+    if (headless != ctx->output_suppressed) {
+        repainted = bridge_suppress_output(ctx, headless) && !headless;
+    }
+    
+    if (resync && !repainted && context->update && context->update->RefreshRect) {
+        pthread_mutex_lock(&ctx->gfx_mutex);
+        RECTANGLE_16 area = { 0, 0, (UINT16)(ctx->frame_width - 1), (UINT16)(ctx->frame_height - 1) };
+        pthread_mutex_unlock(&ctx->gfx_mutex);
+        context->update->RefreshRect(context, 1, &area);
+    }
 }
 
-/* ============================================================================
- * Event Processing & Frame Capture
- * ============================================================================ */
+/* Reconnect after a transport failure, reusing this context.
+ * client_auto_reconnect_ex() gives up on logon errors and only retries
+ * network failures; it presents the server's auto-reconnect cookie, so the
+ * existing Windows session is resumed without a new logon. PostDisconnect
+ * and PostConnect run again for the new connection. Runs on the caller's
+ * connect thread, never inside rdp_poll. */
+int rdp_reconnect(RdpSession* session)
+{
+    if (!session) return -1;
+    
+    rdpContext* context = (rdpContext*)session;
+    BridgeContext* ctx = (BridgeContext*)context;
+    
+    if (ctx->state != RDP_STATE_RECONNECTING) return -1;
+    
+    fprintf(stderr, "[rdp_bridge] Transport lost (error=0x%08X), attempting auto-reconnect\n",
+            freerdp_get_last_error(context));
+    
+    if (!client_auto_reconnect_ex(context->instance, NULL)) {
+        fprintf(stderr, "[rdp_bridge] Auto-reconnect failed\n");
+        snprintf(ctx->error_msg, MAX_ERROR_LEN,
+                 "Reconnect failed: 0x%08X", freerdp_get_last_error(context));
+        ctx->state = RDP_STATE_ERROR;
+        return -1;
+    }
+    
+    ctx->state = RDP_STATE_CONNECTED;
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    uint32_t count = ++ctx->reconnect_count;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    fprintf(stderr, "[rdp_bridge] Auto-reconnect succeeded (%u so far)\n", count);
+    return 0;
+}
 
 int rdp_poll(RdpSession* session, int timeout_ms)
 {
@@ -1519,26 +2018,38 @@ int rdp_poll(RdpSession* session, int timeout_ms)
     rdpContext* context = (rdpContext*)session;
     BridgeContext* ctx = (BridgeContext*)context;
     
+    if (ctx->state == RDP_STATE_RECONNECTING) {
+        return RDP_POLL_TRANSPORT_LOST;
+    }
     if (ctx->state != RDP_STATE_CONNECTED) {
         return -1;
     }
     
+    /* Send input queued since the last poll before anything else */
+    input_flush(ctx);
+    
+    /* Headless switches and refreshes go out between FreeRDP callbacks */
+    bridge_apply_output_state(ctx);
+    
+    /* Send backpressure: while the WebSocket is backed up the streamer stops
+     * draining GFX events, but channels (audio, input, keepalives) are still
+     * serviced. The server is throttled by the frame acks it is not getting
+     * and by the backlog added to their queueDepth. */
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    bool send_paused = ctx->send_paused;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
     /* WIRE-THROUGH MODE: Check GFX event queue for pending data. */
     pthread_mutex_lock(&ctx->gfx_event_mutex);
     int gfx_pending = ctx->gfx_event_count;
     pthread_mutex_unlock(&ctx->gfx_event_mutex);
     
-    if (gfx_pending > 0) {
+    if (gfx_pending > 0 && !send_paused) {
         return 1;
     }
     
-    /* Handle pending resize - use display control channel if available.
-     * IMPORTANT: Don't process resize during GFX pipeline init to avoid race conditions. */
-    pthread_mutex_lock(&ctx->gfx_mutex);
-    bool gfx_initializing = ctx->gfx_pipeline_needs_init && !ctx->gfx_pipeline_ready;
-    pthread_mutex_unlock(&ctx->gfx_mutex);
-    
-    if (ctx->resize_pending && !gfx_initializing) {
+    /* Handle pending resize - use display control channel if available */
+    if (ctx->resize_pending) {
         ctx->resize_pending = false;
         
         uint32_t new_width = ctx->pending_width;
@@ -1569,9 +2080,6 @@ int rdp_poll(RdpSession* session, int timeout_ms)
         }
     }
     
-    /* Deferred GDI pipeline initialization (safe from main thread) */
-    maybe_init_gfx_pipeline(ctx);
-    
     /* Get file descriptors for select/poll */
     HANDLE handles[MAXIMUM_WAIT_OBJECTS] = { 0 };
     DWORD nCount = freerdp_get_event_handles(context, handles, ARRAYSIZE(handles));
@@ -1581,6 +2089,11 @@ int rdp_poll(RdpSession* session, int timeout_ms)
         return -1;
     }
     
+    /* Wake on queued input as well as socket/channel activity */
+    if (ctx->input_event && nCount < ARRAYSIZE(handles)) {
+        handles[nCount++] = ctx->input_event;
+    }
+    
     /* Wait for events */
     DWORD waitStatus = WaitForMultipleObjects(nCount, handles, FALSE, (DWORD)timeout_ms);
     
@@ -1588,6 +2101,8 @@ int rdp_poll(RdpSession* session, int timeout_ms)
         return 0; /* No events, not an error */
     }
     
+    input_flush(ctx);
+    
     /* Check if connection is still valid */
     if (!freerdp_check_event_handles(context)) {
         UINT32 error = freerdp_get_last_error(context);
@@ -1595,14 +2110,16 @@ int rdp_poll(RdpSession* session, int timeout_ms)
         if (error != FREERDP_ERROR_SUCCESS) {
             snprintf(ctx->error_msg, MAX_ERROR_LEN, 
                      "Event handling error: 0x%08X", error);
-            ctx->state = RDP_STATE_ERROR;
             
             /* Mark as disconnecting to prevent GDI handler calls from other threads */
             pthread_mutex_lock(&ctx->gfx_mutex);
             ctx->gfx_disconnecting = true;
             pthread_mutex_unlock(&ctx->gfx_mutex);
             
-            return -1;
+            /* The handshakes of a reconnect would block this poll thread for
+             * seconds; the caller runs rdp_reconnect() on its connect pool */
+            ctx->state = RDP_STATE_RECONNECTING;
+            return RDP_POLL_TRANSPORT_LOST;
         }
     }
     
@@ -1647,51 +2164,317 @@ uint32_t rdp_gfx_get_last_completed_frame(RdpSession* session)
  * Input Handling
  * ============================================================================ */
 
-void rdp_send_mouse(RdpSession* session, uint16_t flags, int x, int y)
+/* Post one record to the mailbox (any thread). Returns false if full. */
+static bool input_push(BridgeContext* ctx, const RdpInputRecord* rec)
 {
-    if (!session) return;
+    uint32_t pos = atomic_load_explicit(&ctx->input_head, memory_order_relaxed);
     
-    rdpContext* context = (rdpContext*)session;
-    BridgeContext* ctx = (BridgeContext*)context;
+    for (;;) {
+        InputSlot* slot = &ctx->input_slots[pos & (RDP_INPUT_QUEUE_MAX - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        
+        if (diff == 0) {
+            /* Slot free: claim the position, then publish the record */
+            if (atomic_compare_exchange_weak_explicit(&ctx->input_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->rec = *rec;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            /* Lost the race - pos was reloaded by the CAS */
+        } else if (diff < 0) {
+            return false;   /* Consumer has not freed this slot yet: full */
+        } else {
+            pos = atomic_load_explicit(&ctx->input_head, memory_order_relaxed);
+        }
+    }
+}
+
+/* Take the next published record (poll thread only) */
+static bool input_pop(BridgeContext* ctx, RdpInputRecord* out)
+{
+    uint32_t pos = atomic_load_explicit(&ctx->input_tail, memory_order_relaxed);
+    InputSlot* slot = &ctx->input_slots[pos & (RDP_INPUT_QUEUE_MAX - 1)];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
     
-    if (ctx->state != RDP_STATE_CONNECTED) return;
+    if (seq != pos + 1) return false;   /* Empty, or claimed but not yet published */
     
-    rdpInput* input = context->input;
-    if (input && input->MouseEvent) {
-        input->MouseEvent(input, flags, (UINT16)x, (UINT16)y);
+    *out = slot->rec;
+    atomic_store_explicit(&slot->seq, pos + RDP_INPUT_QUEUE_MAX, memory_order_release);
+    atomic_store_explicit(&ctx->input_tail, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+/* True for records that end a key or button press */
+static bool input_is_release(const RdpInputRecord* rec)
+{
+    switch (rec->kind) {
+        case RDP_INPUT_SCANCODE:
+        case RDP_INPUT_UNICODE:
+            return (rec->flags & RDP_KBD_FLAG_RELEASE) != 0;
+        case RDP_INPUT_MOUSE:
+        case RDP_INPUT_MOUSE_REL:
+            return (rec->flags & (RDP_MOUSE_FLAG_BUTTON1 | RDP_MOUSE_FLAG_BUTTON2 |
+                                  RDP_MOUSE_FLAG_BUTTON3)) != 0 &&
+                   (rec->flags & RDP_MOUSE_FLAG_DOWN) == 0;
+        default:
+            return false;
     }
 }
 
-void rdp_send_keyboard(RdpSession* session, uint16_t flags, uint16_t scancode)
+/* Post records to the mailbox and wake rdp_poll. Only the first post after a
+ * drain pays for SetEvent. Once the mailbox is down to its release reserve,
+ * other records are dropped but releases still go in; a release that finds
+ * the mailbox completely full makes the next drain release every held key
+ * and button. Returns the number of records accepted. */
+static int input_enqueue(BridgeContext* ctx, const RdpInputRecord* records, int count)
 {
-    if (!session) return;
+    int accepted = 0;
     
-    rdpContext* context = (rdpContext*)session;
-    BridgeContext* ctx = (BridgeContext*)context;
+    for (int i = 0; i < count; i++) {
+        const RdpInputRecord* rec = &records[i];
+        if (input_is_release(rec)) {
+            if (input_push(ctx, rec)) {
+                accepted++;
+            } else {
+                atomic_store(&ctx->input_release_lost, 1);
+            }
+            continue;
+        }
+        
+        uint32_t used = atomic_load_explicit(&ctx->input_head, memory_order_relaxed) -
+                        atomic_load_explicit(&ctx->input_tail, memory_order_relaxed);
+        if (used < RDP_INPUT_QUEUE_MAX - RDP_INPUT_RELEASE_RESERVE && input_push(ctx, rec)) {
+            accepted++;
+        }
+    }
+    if ((accepted > 0 || atomic_load(&ctx->input_release_lost)) &&
+        !atomic_exchange(&ctx->input_signalled, 1)) {
+        SetEvent(ctx->input_event);
+    }
+    
+    return accepted;
+}
+
+/* Append a drained record to the flush batch. A pure move directly after a
+ * pure move of the same kind only updates its position (absolute) or adds to
+ * its delta (relative); everything else is kept exact. */
+static void input_batch_append(RdpInputRecord* batch, int* count, const RdpInputRecord* rec)
+{
+    if (rec->flags == RDP_MOUSE_FLAG_MOVE && *count > 0) {
+        RdpInputRecord* last = &batch[*count - 1];
+        if (last->kind == rec->kind && last->flags == RDP_MOUSE_FLAG_MOVE) {
+            if (rec->kind == RDP_INPUT_MOUSE) {
+                last->a = rec->a;
+                last->b = rec->b;
+                return;
+            }
+            if (rec->kind == RDP_INPUT_MOUSE_REL) {
+                int32_t dx = (int16_t)last->a + (int16_t)rec->a;
+                int32_t dy = (int16_t)last->b + (int16_t)rec->b;
+                if (dx >= INT16_MIN && dx <= INT16_MAX &&
+                    dy >= INT16_MIN && dy <= INT16_MAX) {
+                    last->a = (uint16_t)(int16_t)dx;
+                    last->b = (uint16_t)(int16_t)dy;
+                    return;
+                }
+            }
+        }
+    }
+    batch[(*count)++] = *rec;
+}
+
+/* Remember an injected absolute position (poll thread only) */
+static void pointer_history_add(BridgeContext* ctx, int32_t x, int32_t y)
+{
+    ctx->pointer_x = x;
+    ctx->pointer_y = y;
+    ctx->pointer_history[ctx->pointer_history_pos] = ((uint32_t)(uint16_t)x << 16) | (uint16_t)y;
+    ctx->pointer_history_ms[ctx->pointer_history_pos] = GetTickCount64();
+    ctx->pointer_history_pos = (ctx->pointer_history_pos + 1) % RDP_POINTER_ECHO_HISTORY;
+}
+
+/* True if (x, y) is a position we injected within the echo window - the
+ * server is echoing our own input, and if newer input followed, the echo is
+ * also stale. Each injection absorbs one echo, so a later server warp to the
+ * same spot (e.g. a snap-to-button) is still streamed. */
+static bool pointer_is_echo(BridgeContext* ctx, uint32_t x, uint32_t y)
+{
+    uint32_t key = ((x & 0xFFFF) << 16) | (y & 0xFFFF);
+    uint64_t now = GetTickCount64();
+    for (int i = 0; i < RDP_POINTER_ECHO_HISTORY; i++) {
+        if (ctx->pointer_history[i] == key &&
+            now - ctx->pointer_history_ms[i] <= RDP_POINTER_ECHO_WINDOW_MS) {
+            ctx->pointer_history[i] = UINT32_MAX;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Track which injected keys and buttons are held (poll thread only) */
+static void input_track_held(BridgeContext* ctx, const RdpInputRecord* rec)
+{
+    if (rec->kind == RDP_INPUT_SCANCODE) {
+        uint32_t bit = ((rec->flags & RDP_KBD_FLAG_EXTENDED) ? 0x100 : 0) | (rec->a & 0xFF);
+        if (rec->flags & RDP_KBD_FLAG_RELEASE) {
+            ctx->input_keys_down[bit >> 6] &= ~(1ULL << (bit & 63));
+        } else {
+            ctx->input_keys_down[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    } else if (rec->kind == RDP_INPUT_MOUSE || rec->kind == RDP_INPUT_MOUSE_REL) {
+        uint16_t buttons = rec->flags & (RDP_MOUSE_FLAG_BUTTON1 | RDP_MOUSE_FLAG_BUTTON2 |
+                                         RDP_MOUSE_FLAG_BUTTON3);
+        if (rec->flags & RDP_MOUSE_FLAG_DOWN) {
+            ctx->input_buttons_down |= buttons;
+        } else {
+            ctx->input_buttons_down &= ~buttons;
+        }
+    }
+}
+
+/* A release was lost to a full mailbox: release everything still held rather
+ * than leave a key or button stuck down on the server */
+static void input_release_all(BridgeContext* ctx, rdpInput* input)
+{
+    fprintf(stderr, "[rdp_bridge] Warning: Input mailbox overflowed on a release, releasing all held keys and buttons\n");
     
-    if (ctx->state != RDP_STATE_CONNECTED) return;
+    for (uint32_t bit = 0; bit < 512; bit++) {
+        if (!(ctx->input_keys_down[bit >> 6] & (1ULL << (bit & 63)))) continue;
+        if (input->KeyboardEvent) {
+            input->KeyboardEvent(input, RDP_KBD_FLAG_RELEASE |
+                                 ((bit & 0x100) ? RDP_KBD_FLAG_EXTENDED : 0), bit & 0xFF);
+        }
+    }
+    memset(ctx->input_keys_down, 0, sizeof(ctx->input_keys_down));
     
-    rdpInput* input = context->input;
-    if (input && input->KeyboardEvent) {
-        input->KeyboardEvent(input, flags, scancode);
+    static const uint16_t buttons[] = {
+        RDP_MOUSE_FLAG_BUTTON1, RDP_MOUSE_FLAG_BUTTON2, RDP_MOUSE_FLAG_BUTTON3
+    };
+    for (size_t i = 0; i < ARRAYSIZE(buttons); i++) {
+        if ((ctx->input_buttons_down & buttons[i]) && input->MouseEvent) {
+            input->MouseEvent(input, buttons[i], (UINT16)ctx->pointer_x, (UINT16)ctx->pointer_y);
+        }
     }
+    ctx->input_buttons_down = 0;
 }
 
-void rdp_send_unicode(RdpSession* session, uint16_t flags, uint16_t code)
+/* Drain the mailbox and send its input. Called only from rdp_poll (the I/O
+ * thread), so injection never races FreeRDP's own transport use. */
+static void input_flush(BridgeContext* ctx)
 {
-    if (!session) return;
+    RdpInputRecord batch[RDP_INPUT_QUEUE_MAX];
+    RdpInputRecord rec;
+    int count = 0;
     
-    rdpContext* context = (rdpContext*)session;
-    BridgeContext* ctx = (BridgeContext*)context;
+    /* Re-arm the wake-up before draining: a producer posting after this
+     * point sets the event again, so nothing is left behind unsignalled.
+     * The exchange also acquires everything published before the last post. */
+    ResetEvent(ctx->input_event);
+    atomic_exchange(&ctx->input_signalled, 0);
+    
+    while (count < RDP_INPUT_QUEUE_MAX && input_pop(ctx, &rec)) {
+        input_batch_append(batch, &count, &rec);
+    }
     
-    if (ctx->state != RDP_STATE_CONNECTED) return;
+    bool release_lost = atomic_exchange(&ctx->input_release_lost, 0) != 0;
+    if (count == 0 && !release_lost) return;
     
+    rdpContext* context = (rdpContext*)ctx;
     rdpInput* input = context->input;
-    if (input && input->UnicodeKeyboardEvent) {
-        input->UnicodeKeyboardEvent(input, flags, code);
+    if (!input) return;
+    
+    bool server_relative = freerdp_settings_get_bool(context->settings, FreeRDP_HasRelativeMouseEvent);
+    
+    for (int i = 0; i < count; i++) {
+        const RdpInputRecord* rec = &batch[i];
+        input_track_held(ctx, rec);
+        switch (rec->kind) {
+            case RDP_INPUT_MOUSE:
+                pointer_history_add(ctx, rec->a, rec->b);
+                if (input->MouseEvent) {
+                    input->MouseEvent(input, rec->flags, rec->a, rec->b);
+                }
+                break;
+            case RDP_INPUT_MOUSE_REL: {
+                int16_t dx = (int16_t)rec->a;
+                int16_t dy = (int16_t)rec->b;
+                if (rec->flags & (RDP_MOUSE_FLAG_WHEEL | RDP_MOUSE_FLAG_HWHEEL)) {
+                    /* Relative PDUs cannot carry rotation: send a plain wheel
+                     * event (no MOVE flag) at the last known position */
+                    if (input->MouseEvent) {
+                        input->MouseEvent(input, rec->flags,
+                                          (UINT16)ctx->pointer_x, (UINT16)ctx->pointer_y);
+                    }
+                    break;
+                }
+                if (server_relative) {
+                    freerdp_input_send_rel_mouse_event(input, rec->flags, dx, dy);
+                    break;
+                }
+                /* No server support: integrate into an absolute position */
+                int32_t max_x = ctx->frame_width > 0 ? ctx->frame_width - 1 : 0;
+                int32_t max_y = ctx->frame_height > 0 ? ctx->frame_height - 1 : 0;
+                int32_t px = ctx->pointer_x + dx;
+                int32_t py = ctx->pointer_y + dy;
+                pointer_history_add(ctx, px < 0 ? 0 : (px > max_x ? max_x : px),
+                                         py < 0 ? 0 : (py > max_y ? max_y : py));
+                if (input->MouseEvent) {
+                    input->MouseEvent(input, rec->flags | RDP_MOUSE_FLAG_MOVE,
+                                      (UINT16)ctx->pointer_x, (UINT16)ctx->pointer_y);
+                }
+                break;
+            }
+            case RDP_INPUT_SCANCODE:
+                if (input->KeyboardEvent) {
+                    input->KeyboardEvent(input, rec->flags, rec->a);
+                }
+                break;
+            case RDP_INPUT_UNICODE:
+                if (input->UnicodeKeyboardEvent) {
+                    input->UnicodeKeyboardEvent(input, rec->flags, rec->a);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    if (release_lost) {
+        input_release_all(ctx, input);
     }
 }
 
+int rdp_send_input_batch(RdpSession* session, const RdpInputRecord* records, int count)
+{
+    if (!session || !records || count <= 0) return 0;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    
+    if (ctx->state != RDP_STATE_CONNECTED) return -1;
+    
+    return input_enqueue(ctx, records, count);
+}
+
+void rdp_send_mouse(RdpSession* session, uint16_t flags, int x, int y)
+{
+    RdpInputRecord rec = { RDP_INPUT_MOUSE, flags, (uint16_t)x, (uint16_t)y };
+    rdp_send_input_batch(session, &rec, 1);
+}
+
+void rdp_send_keyboard(RdpSession* session, uint16_t flags, uint16_t scancode)
+{
+    RdpInputRecord rec = { RDP_INPUT_SCANCODE, flags, scancode, 0 };
+    rdp_send_input_batch(session, &rec, 1);
+}
+
+void rdp_send_unicode(RdpSession* session, uint16_t flags, uint16_t code)
+{
+    RdpInputRecord rec = { RDP_INPUT_UNICODE, flags, code, 0 };
+    rdp_send_input_batch(session, &rec, 1);
+}
+
 /* ============================================================================
  * Resize
  * ============================================================================ */
@@ -1724,14 +2507,96 @@ int rdp_resize(RdpSession* session, uint32_t width, uint32_t height)
     return 0;
 }
 
+/* ============================================================================
+ * Connect Timing I/O Hooks
+ * 
+ * FreeRDP has no per-phase connect callbacks, so the transport I/O callbacks
+ * are wrapped: TCPConnect and TLSConnect returning mark those phases, and
+ * every PDU read or written while connecting samples the connection state
+ * machine to see when NLA and licensing are over.
+ * ============================================================================ */
+
+static void connect_track_state(BridgeContext* ctx)
+{
+    if (ctx->state != RDP_STATE_CONNECTING) return;
+    
+    CONNECTION_STATE state = freerdp_get_state(&ctx->common.context);
+    
+    /* Past NLA (or plain TLS/RDP security) once MCS has started */
+    if (!ctx->connect_timing.nla_ms && state >= CONNECTION_STATE_MCS_CREATE_REQUEST) {
+        ctx->connect_timing.nla_ms = connect_elapsed_ms(ctx);
+    }
+    if (!ctx->connect_timing.license_ms && state > CONNECTION_STATE_LICENSING) {
+        ctx->connect_timing.license_ms = connect_elapsed_ms(ctx);
+    }
+}
+
+static int bridge_io_tcp_connect(rdpContext* context, rdpSettings* settings,
+                                 const char* hostname, int port, DWORD timeout)
+{
+    BridgeContext* ctx = (BridgeContext*)context;
+    int sockfd = ctx->transport_io.TCPConnect(context, settings, hostname, port, timeout);
+    
+    if (sockfd >= 0 && !ctx->connect_timing.tcp_ms) {
+        ctx->connect_timing.tcp_ms = connect_elapsed_ms(ctx);
+    }
+    return sockfd;
+}
+
+static BOOL bridge_io_tls_connect(rdpTransport* transport)
+{
+    BridgeContext* ctx = (BridgeContext*)transport_get_context(transport);
+    BOOL ok = ctx->transport_io.TLSConnect(transport);
+    
+    if (ok && !ctx->connect_timing.tls_ms) {
+        ctx->connect_timing.tls_ms = connect_elapsed_ms(ctx);
+    }
+    return ok;
+}
+
+static int bridge_io_read_pdu(rdpTransport* transport, wStream* s)
+{
+    BridgeContext* ctx = (BridgeContext*)transport_get_context(transport);
+    int rc = ctx->transport_io.ReadPdu(transport, s);
+    
+    connect_track_state(ctx);
+    return rc;
+}
+
+static int bridge_io_write_pdu(rdpTransport* transport, wStream* s)
+{
+    BridgeContext* ctx = (BridgeContext*)transport_get_context(transport);
+    
+    /* Before writing: the state already reflects the PDU being answered */
+    connect_track_state(ctx);
+    return ctx->transport_io.WritePdu(transport, s);
+}
+
 /* ============================================================================
  * FreeRDP Callbacks
  * ============================================================================ */
 
 static BOOL bridge_pre_connect(freerdp* instance)
 {
+    BridgeContext* ctx = (BridgeContext*)instance->context;
     rdpSettings* settings = instance->context->settings;
     
+    ctx->connect_timing.pre_connect_ms = connect_elapsed_ms(ctx);
+    
+    /* Wrap the transport I/O callbacks to time TCP, TLS, NLA and licensing */
+    const rdpTransportIo* io = freerdp_get_io_callbacks(instance->context);
+    if (io) {
+        ctx->transport_io = *io;
+        rdpTransportIo timed = *io;
+        timed.TCPConnect = bridge_io_tcp_connect;
+        timed.TLSConnect = bridge_io_tls_connect;
+        timed.ReadPdu = bridge_io_read_pdu;
+        timed.WritePdu = bridge_io_write_pdu;
+        if (!freerdp_set_io_callbacks(instance->context, &timed)) {
+            fprintf(stderr, "[rdp_bridge] WARNING: Could not install connect timing I/O hooks\n");
+        }
+    }
+    
     /* Ensure we have proper settings */
     if (!freerdp_settings_get_string(settings, FreeRDP_ServerHostname)) {
         fprintf(stderr, "[rdp_bridge] ERROR: No server hostname set\n");
@@ -1754,6 +2619,8 @@ static BOOL bridge_post_connect(freerdp* instance)
     rdpContext* context = instance->context;
     rdpSettings* settings = context->settings;
     
+    ctx->connect_timing.post_connect_ms = connect_elapsed_ms(ctx);
+    
     /* Check if channels object exists */
     if (!context->channels) {
         fprintf(stderr, "[rdp_bridge] WARNING: Channels object is NULL!\n");
@@ -1765,9 +2632,12 @@ static BOOL bridge_post_connect(freerdp* instance)
      * DeactivateClientDecoding=TRUE, the heavy codec decoding is skipped.
      * The GDI framebuffer is allocated, but we don't use it for actual decoding -
      * all graphics flow as encoded events to the frontend.
+     * 
+     * PostConnect runs again after an auto-reconnect. PostDisconnect normally
+     * freed GDI and the planar decoder by then; keep them if it did not.
      */
     fprintf(stderr, "[rdp_bridge] PostConnect: gdi=%p before gdi_init\n", (void*)context->gdi);
-    if (!gdi_init(instance, PIXEL_FORMAT_BGRA32)) {
+    if (!context->gdi && !gdi_init(instance, PIXEL_FORMAT_BGRA32)) {
         fprintf(stderr, "[rdp_bridge] gdi_init failed\n");
         return FALSE;
     }
@@ -1775,6 +2645,15 @@ static BOOL bridge_post_connect(freerdp* instance)
     fprintf(stderr, "[rdp_bridge] PostConnect: GDI initialized (gdi=%p, cache=%p)\n",
             (void*)context->gdi, (void*)context->cache);
     
+    if (!ctx->planar_decoder) {
+        ctx->planar_decoder = freerdp_bitmap_planar_context_new(0, 64, 64);
+    }
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    ctx->gfx_disconnecting = false;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    ctx->output_suppressed = false;
+    
     /* Register pointer/cursor callbacks for remote cursor support.
      * context->graphics is allocated during freerdp_context_new(), independently of GDI. */
     {
@@ -1821,7 +2700,10 @@ static BOOL bridge_post_connect(freerdp* instance)
     }
     
     /* Subscribe to channel events to capture GFX DVC when it connects.
-     * This must be done in PostConnect - the working version had it here. */
+     * This must be done in PostConnect - the working version had it here.
+     * Unsubscribe first so a reconnect never registers the handlers twice. */
+    PubSub_UnsubscribeChannelConnected(context->pubSub, bridge_on_channel_connected);
+    PubSub_UnsubscribeChannelDisconnected(context->pubSub, bridge_on_channel_disconnected);
     PubSub_SubscribeChannelConnected(context->pubSub, bridge_on_channel_connected);
     PubSub_SubscribeChannelDisconnected(context->pubSub, bridge_on_channel_disconnected);
     
@@ -1891,7 +2773,6 @@ static void bridge_post_disconnect(freerdp* instance)
     pthread_mutex_lock(&ctx->gfx_mutex);
     ctx->gfx_active = false;
     ctx->gfx_pipeline_ready = false;
-    ctx->gfx_pipeline_needs_init = false;
     ctx->gfx_frame_in_progress = false;
     pthread_mutex_unlock(&ctx->gfx_mutex);
     
@@ -1951,11 +2832,14 @@ static void bridge_on_channel_connected(void* ctx, const ChannelConnectedEventAr
         pthread_mutex_unlock(&bctx->opus_mutex);
     }
     else if (strcmp(e->name, RDPGFX_DVC_CHANNEL_NAME) == 0) {
-        /* GFX pipeline connected - save context and set deferred init flag.
+        /* GFX pipeline connected - save context and mark the pipeline ready.
          * 
-         * We do NOT call gdi_graphics_pipeline_init() here because it causes
-         * thread-safety issues (GDI reinit in different thread).
-         * Instead, we set a flag and initialize from the main poll thread.
+         * PURE GFX MODE: We do NOT call gdi_graphics_pipeline_init() here.
+         * It registers GDI handlers that call gdi_OutputUpdate() and crash on
+         * the GFX thread. Nothing else needs the poll thread, so the pipeline
+         * is ready as soon as our callbacks are installed below and the
+         * server's CapsConfirm/ResetGraphics are queued without waiting for
+         * another rdp_poll round.
          */
         RdpgfxClientContext* gfx = (RdpgfxClientContext*)e->pInterface;
         bctx->gfx = gfx;
@@ -1975,10 +2859,9 @@ static void bridge_on_channel_connected(void* ctx, const ChannelConnectedEventAr
              * This provides proper backpressure - if the browser is slow to decode,
              * ACKs will be delayed and the server will throttle its frame rate. */
             
-            pthread_mutex_lock(&bctx->gfx_mutex);
-            bctx->gfx_active = true;
-            bctx->gfx_pipeline_needs_init = true;  /* Deferred init in main thread */
-            pthread_mutex_unlock(&bctx->gfx_mutex);
+            if (!gfx->FrameAcknowledge) {
+                fprintf(stderr, "[rdp_bridge] WARNING: FrameAcknowledge callback is NULL - acks won't be sent!\n");
+            }
             
             /* Set up ALL GFX callbacks for proper protocol handling.
              * Missing callbacks can cause the server to abort the connection.
@@ -2008,6 +2891,12 @@ static void bridge_on_channel_connected(void* ctx, const ChannelConnectedEventAr
             
             /* OnOpen: disable automatic frame ACKs - browser controls flow */
             gfx->OnOpen = gfx_on_open;
+            
+            pthread_mutex_lock(&bctx->gfx_mutex);
+            bctx->gfx_active = true;
+            bctx->gfx_pipeline_ready = true;
+            bctx->connect_timing.gfx_ready_ms = connect_elapsed_ms(bctx);
+            pthread_mutex_unlock(&bctx->gfx_mutex);
         }
     }
 }
@@ -2398,6 +3287,22 @@ static UINT gfx_on_caps_confirm(RdpgfxClientContext* context, const RDPGFX_CAPS_
     /* Log the confirmed capabilities */
     log_caps_confirm(version, flags);
     
+    pthread_mutex_lock(&bctx->gfx_mutex);
+    if (!bctx->connect_timing.gfx_caps_ms) {
+        bctx->connect_timing.gfx_caps_ms = connect_elapsed_ms(bctx);
+    }
+    bctx->gfx_caps_version = version;
+    bctx->gfx_caps_flags = flags;
+    pthread_mutex_unlock(&bctx->gfx_mutex);
+    
+    /* A new GFX channel starts with an empty server-side cache */
+    pthread_mutex_lock(&bctx->gfx_event_mutex);
+    memset(bctx->gfx_cache_held, 0, sizeof(bctx->gfx_cache_held));
+    memset(bctx->gfx_cache_missing, 0, sizeof(bctx->gfx_cache_missing));
+    bctx->gfx_cache_held_count = 0;
+    bctx->gfx_cache_missing_count = 0;
+    pthread_mutex_unlock(&bctx->gfx_event_mutex);
+    
     /* Queue CAPS_CONFIRM event for frontend */
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_CAPS_CONFIRM;
@@ -2705,6 +3610,29 @@ static UINT gfx_on_surface_to_surface(RdpgfxClientContext* context,
     return CHANNEL_RC_OK;
 }
 
+/* Track a cache slot (caller holds gfx_event_mutex). held: the server may
+ * draw from it; missing: the browser never got its content. */
+static void gfx_cache_set(BridgeContext* ctx, uint16_t slot, bool held, bool missing)
+{
+    if (slot >= RDP_GFX_CACHE_SLOTS) return;
+    
+    uint8_t bit = (uint8_t)(1u << (slot & 7));
+    bool was_held = (ctx->gfx_cache_held[slot >> 3] & bit) != 0;
+    bool was_missing = (ctx->gfx_cache_missing[slot >> 3] & bit) != 0;
+    missing = held && missing;
+    
+    if (held != was_held) {
+        ctx->gfx_cache_held[slot >> 3] ^= bit;
+        if (held) ctx->gfx_cache_held_count++;
+        else ctx->gfx_cache_held_count--;
+    }
+    if (missing != was_missing) {
+        ctx->gfx_cache_missing[slot >> 3] ^= bit;
+        if (missing) ctx->gfx_cache_missing_count++;
+        else ctx->gfx_cache_missing_count--;
+    }
+}
+
 static UINT gfx_on_surface_to_cache(RdpgfxClientContext* context,
                                      const RDPGFX_SURFACE_TO_CACHE_PDU* cache)
 {
@@ -2738,7 +3666,11 @@ static UINT gfx_on_surface_to_cache(RdpgfxClientContext* context,
     event.bitmap_data = NULL;  /* Frontend extracts from its surface */
     event.bitmap_size = 0;
     
-    gfx_queue_event(bctx, &event);
+    bool queued = gfx_queue_event(bctx, &event);
+    
+    pthread_mutex_lock(&bctx->gfx_event_mutex);
+    gfx_cache_set(bctx, cache->cacheSlot, true, !queued);
+    pthread_mutex_unlock(&bctx->gfx_event_mutex);
     
     return CHANNEL_RC_OK;
 }
@@ -2789,6 +3721,11 @@ static UINT gfx_on_evict_cache(RdpgfxClientContext* context,
     
     gfx_queue_event(bctx, &event);
     
+    /* The server will not draw from it again; a stale browser copy is harmless */
+    pthread_mutex_lock(&bctx->gfx_event_mutex);
+    gfx_cache_set(bctx, evict->cacheSlot, false, false);
+    pthread_mutex_unlock(&bctx->gfx_event_mutex);
+    
     return CHANNEL_RC_OK;
 }
 
@@ -2941,7 +3878,8 @@ static UINT gfx_on_surface_command(RdpgfxClientContext* context, const RDPGFX_SU
     bool disconnecting = bctx->gfx_disconnecting;
     pthread_mutex_unlock(&bctx->gfx_mutex);
     
-    if (disconnecting) {
+    /* Headless: nobody will see this, skip decode, WebP and transcode work */
+    if (disconnecting || atomic_load(&bctx->headless)) {
         return CHANNEL_RC_OK;
     }
     
@@ -3204,8 +4142,19 @@ static UINT gfx_on_end_frame(RdpgfxClientContext* context, const RDPGFX_END_FRAM
     bctx->gfx_frame_in_progress = false;
     /* Update last_completed_frame_id so Python knows a frame finished */
     bctx->last_completed_frame_id = end->frameId;
+    if (!bctx->connect_timing.first_frame_ms) {
+        bctx->connect_timing.first_frame_ms = connect_elapsed_ms(bctx);
+    }
     pthread_mutex_unlock(&bctx->gfx_mutex);
     
+    /* Headless: no browser will ack this frame, so ack it here and tell the
+     * server not to wait for acknowledgements (MS-RDPEGFX 2.2.3.3) */
+    if (atomic_load(&bctx->headless)) {
+        rdp_gfx_send_frame_ack((RdpSession*)bctx, end->frameId,
+                               ++bctx->headless_frames_acked, RDP_GFX_QUEUE_DEPTH_SUSPEND);
+        return CHANNEL_RC_OK;
+    }
+    
     /* Queue END_FRAME event for Python wire format streaming */
     RdpGfxEvent event = {0};
     event.type = RDP_GFX_EVENT_END_FRAME;
@@ -3329,14 +4278,21 @@ int rdp_gfx_send_frame_ack(RdpSession* session, uint32_t frame_id, uint32_t tota
     ack.frameId = frame_id;
     ack.totalFramesDecoded = total_frames_decoded;
     
-    /* Use actual browser queue depth for adaptive server-side rate control */
-    ack.queueDepth = queue_depth;
-    
-    /* Update our tracking */
+    /* Use actual browser queue depth for adaptive server-side rate control.
+     * Frames still sitting in the WebSocket send buffer are not decoded yet
+     * either, so they count towards the depth the server sees. */
     pthread_mutex_lock(&ctx->gfx_mutex);
     ctx->last_completed_frame_id = frame_id;
+    uint32_t backlog = ctx->send_backlog_frames;
     pthread_mutex_unlock(&ctx->gfx_mutex);
     
+    if (queue_depth == RDP_GFX_QUEUE_DEPTH_SUSPEND) {
+        ack.queueDepth = queue_depth;
+    } else {
+        uint64_t depth = (uint64_t)queue_depth + backlog;
+        ack.queueDepth = depth >= 0xFFFFFFFF ? 0xFFFFFFFE : (uint32_t)depth;
+    }
+    
     /* Send the ACK to the server */
     UINT status = gfx->FrameAcknowledge(gfx, &ack);
     
@@ -3349,6 +4305,68 @@ int rdp_gfx_send_frame_ack(RdpSession* session, uint32_t frame_id, uint32_t tota
     return 0;
 }
 
+void rdp_set_headless(RdpSession* session, bool headless)
+{
+    if (!session) return;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    ctx->headless_requested = headless;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    if (ctx->input_event) {
+        SetEvent(ctx->input_event);
+    }
+}
+
+bool rdp_gfx_cache_resumable(RdpSession* session, bool cache_lost)
+{
+    if (!session) return false;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    
+    pthread_mutex_lock(&ctx->gfx_event_mutex);
+    uint32_t lacking = cache_lost ? ctx->gfx_cache_held_count : ctx->gfx_cache_missing_count;
+    pthread_mutex_unlock(&ctx->gfx_event_mutex);
+    
+    return lacking == 0;
+}
+
+int rdp_request_refresh(RdpSession* session)
+{
+    if (!session) return -1;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    if (ctx->state != RDP_STATE_CONNECTED) return -1;
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    ctx->graphics_resync_pending = true;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    if (ctx->input_event) {
+        SetEvent(ctx->input_event);
+    }
+    return 0;
+}
+
+void rdp_set_send_backpressure(RdpSession* session, bool paused, uint32_t backlog_frames)
+{
+    if (!session) return;
+    
+    BridgeContext* ctx = (BridgeContext*)session;
+    
+    pthread_mutex_lock(&ctx->gfx_mutex);
+    ctx->send_paused = paused;
+    ctx->send_backlog_frames = backlog_frames;
+    pthread_mutex_unlock(&ctx->gfx_mutex);
+    
+    /* Let rdp_poll hand back queued events right away */
+    if (!paused && ctx->input_event) {
+        SetEvent(ctx->input_event);
+    }
+}
+
 /* ============================================================================
  * WebP Tile Encoding Helper
  * ============================================================================ */
@@ -3497,10 +4515,18 @@ static const char* gfx_event_type_name(int type) {
     }
 }
 
-/* Internal helper: queue a GFX event (caller must NOT hold gfx_event_mutex) */
-static void gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event)
+/* Internal helper: queue a GFX event (caller must NOT hold gfx_event_mutex).
+ * Takes ownership of the event's data; returns false if it was dropped. */
+static bool gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event)
 {
-    if (!ctx || !event || !ctx->gfx_events) return;
+    if (!ctx || !event) return false;
+    
+    /* Headless: drop instead of queueing (the queue owns the event's data) */
+    if (!ctx->gfx_events || atomic_load(&ctx->headless)) {
+        RdpGfxEvent dropped = *event;
+        gfx_free_event_data(&dropped);
+        return false;
+    }
     
     pthread_mutex_lock(&ctx->gfx_event_mutex);
     
@@ -3533,19 +4559,13 @@ static void gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event)
                         new_capacity, (int)(new_capacity * sizeof(RdpGfxEvent) / 1024));
             } else {
                 /* Allocation failed - drop oldest event */
-                RdpGfxEvent* dropped = &ctx->gfx_events[ctx->gfx_event_read_idx];
-                fprintf(stderr, "[GFX] WARNING: Queue grow failed! Dropping event type=%d (%s) frame=%u\n",
-                        dropped->type, gfx_event_type_name(dropped->type), dropped->frame_id);
-                ctx->gfx_event_read_idx = (ctx->gfx_event_read_idx + 1) % ctx->gfx_events_capacity;
-                ctx->gfx_event_count--;
+                fprintf(stderr, "[GFX] WARNING: Queue grow failed!\n");
+                gfx_drop_oldest_event(ctx);
             }
         } else {
             /* At max capacity - drop oldest event */
-            RdpGfxEvent* dropped = &ctx->gfx_events[ctx->gfx_event_read_idx];
-            fprintf(stderr, "[GFX] WARNING: Queue at max (%d)! Dropping event type=%d (%s) frame=%u\n",
-                    RDP_MAX_GFX_EVENTS, dropped->type, gfx_event_type_name(dropped->type), dropped->frame_id);
-            ctx->gfx_event_read_idx = (ctx->gfx_event_read_idx + 1) % ctx->gfx_events_capacity;
-            ctx->gfx_event_count--;
+            fprintf(stderr, "[GFX] WARNING: Queue at max (%d)!\n", RDP_MAX_GFX_EVENTS);
+            gfx_drop_oldest_event(ctx);
         }
     }
     
@@ -3554,6 +4574,46 @@ static void gfx_queue_event(BridgeContext* ctx, const RdpGfxEvent* event)
     ctx->gfx_event_count++;
     
     pthread_mutex_unlock(&ctx->gfx_event_mutex);
+    return true;
+}
+
+/* Make room in a full queue (caller holds gfx_event_mutex). A dropped cursor
+ * bitmap never reaches the browser, so its cache slot is forgotten too. */
+static void gfx_drop_oldest_event(BridgeContext* ctx)
+{
+    RdpGfxEvent* dropped = &ctx->gfx_events[ctx->gfx_event_read_idx];
+    fprintf(stderr, "[GFX] Dropping event type=%d (%s) frame=%u\n",
+            dropped->type, gfx_event_type_name(dropped->type), dropped->frame_id);
+    if (dropped->type == RDP_GFX_EVENT_POINTER_SET &&
+        dropped->pointer_cache_id < RDP_POINTER_CLIENT_CACHE) {
+        ctx->pointer_client_hash[dropped->pointer_cache_id] = 0;
+    }
+    if (dropped->type == RDP_GFX_EVENT_SURFACE_TO_CACHE) {
+        gfx_cache_set(ctx, dropped->cache_slot, true, true);
+    }
+    gfx_free_event_data(dropped);
+    ctx->gfx_event_read_idx = (ctx->gfx_event_read_idx + 1) % ctx->gfx_events_capacity;
+    ctx->gfx_event_count--;
+}
+
+/* Drop queued events no browser will receive. Frames among them are
+ * acknowledged with queue_depth so the server does not count them as in
+ * flight. */
+static void gfx_drop_events(BridgeContext* ctx, uint32_t queue_depth)
+{
+    RdpGfxEvent event;
+    
+    while (rdp_gfx_get_event((RdpSession*)ctx, &event) == 0) {
+        if (event.type == RDP_GFX_EVENT_END_FRAME) {
+            rdp_gfx_send_frame_ack((RdpSession*)ctx, event.frame_id,
+                                   ++ctx->headless_frames_acked, queue_depth);
+        } else if (event.type == RDP_GFX_EVENT_SURFACE_TO_CACHE) {
+            pthread_mutex_lock(&ctx->gfx_event_mutex);
+            gfx_cache_set(ctx, event.cache_slot, true, true);
+            pthread_mutex_unlock(&ctx->gfx_event_mutex);
+        }
+        gfx_free_event_data(&event);
+    }
 }
 
 int rdp_gfx_has_events(RdpSession* session)
@@ -21,12 +21,22 @@ extern "C" {
 #define RDP_GFX_EVENTS_INITIAL 2048   /* Initial GFX event queue size (~295 KB) */
 #define RDP_GFX_EVENTS_GROW 1024      /* Grow queue in 1024-slot increments */
 #define RDP_MAX_GFX_EVENTS 16384      /* Max GFX event queue size (~2.3 MB) */
+#define RDP_POINTER_CLIENT_CACHE 32   /* Cursor bitmaps the browser keeps per session */
+#define RDP_GFX_QUEUE_DEPTH_SUSPEND 0xFFFFFFFF  /* Frame ack queueDepth: acks suspended */
+#define RDP_GFX_CACHE_SLOTS 25600     /* Largest MaxCacheSlots a server may use (MS-RDPEGFX) */
 
 /* Session registry limits (compile-time defaults, runtime configurable) */
 #define RDP_MAX_SESSIONS_DEFAULT 100
 #define RDP_MAX_SESSIONS_MIN 2
 #define RDP_MAX_SESSIONS_MAX 1000
 
+/* Pre-warmed context pool (runtime configurable, 0 disables) */
+#define RDP_POOL_SIZE_DEFAULT 2
+#define RDP_POOL_SIZE_MAX 64
+
+/* Auto-reconnect attempts after a network error (Auto-Reconnect Cookie) */
+#define RDP_AUTO_RECONNECT_MAX_RETRIES 5
+
 /* Mouse button flags (compatible with FreeRDP PTR_FLAGS_*) */
 #define RDP_MOUSE_FLAG_MOVE     0x0800
 #define RDP_MOUSE_FLAG_BUTTON1  0x1000  /* Left */
@@ -43,14 +53,34 @@ extern "C" {
 #define RDP_KBD_FLAG_EXTENDED   0x0100
 #define RDP_KBD_FLAG_EXTENDED1  0x0200
 
+/* Input record kinds (match the browser's INPT wire records) */
+#define RDP_INPUT_MOUSE         1
+#define RDP_INPUT_SCANCODE      2
+#define RDP_INPUT_UNICODE       3
+#define RDP_INPUT_MOUSE_REL     4     /* a/b carry signed 16-bit deltas (zero for wheel) */
+
+#define RDP_INPUT_QUEUE_MAX     1024  /* Pending input records per session (power of two) */
+
 /* Session states */
 typedef enum {
     RDP_STATE_DISCONNECTED = 0,
     RDP_STATE_CONNECTING,
     RDP_STATE_CONNECTED,
-    RDP_STATE_ERROR
+    RDP_STATE_ERROR,
+    RDP_STATE_RECONNECTING      /* Transport lost, waiting for rdp_reconnect() */
 } RdpState;
 
+/* rdp_poll() result: the transport failed and may be resumed with rdp_reconnect() */
+#define RDP_POLL_TRANSPORT_LOST -2
+
+/* Input record for batched injection (8 bytes, natural alignment) */
+typedef struct {
+    uint8_t kind;       /* RDP_INPUT_* */
+    uint16_t flags;     /* RDP_MOUSE_FLAG_* or RDP_KBD_FLAG_* */
+    uint16_t a;         /* x or int16 dx (mouse), scancode or UTF-16 code unit (keyboard) */
+    uint16_t b;         /* y or int16 dy (mouse), unused for keyboard */
+} RdpInputRecord;
+
 /* Rectangle structure (used for GFX frame positioning) */
 typedef struct {
     int32_t x;
@@ -114,6 +144,7 @@ typedef enum {
     RDP_GFX_EVENT_POINTER_POSITION, /* Cursor position update (16) */
     RDP_GFX_EVENT_POINTER_SYSTEM,   /* System pointer (null/default) (17) */
     RDP_GFX_EVENT_POINTER_SET,      /* Set/show a cursor (bitmap data) (18) */
+    RDP_GFX_EVENT_POINTER_CACHED,   /* Show a cursor the browser already holds (19) */
 } RdpGfxEventType;
 
 /* GFX event for Python consumption */
@@ -159,8 +190,25 @@ typedef struct {
     uint8_t pointer_system_type;    /* 0=null/hidden, 1=default (for POINTER_SYSTEM) */
     uint8_t* pointer_data;          /* BGRA32 cursor image (caller frees) */
     uint32_t pointer_data_size;     /* Size of pointer_data in bytes */
+    uint16_t pointer_cache_id;      /* Browser cursor cache slot (POINTER_SET stores, POINTER_CACHED uses) */
 } RdpGfxEvent;
 
+/* Connect-phase timestamps in ms since rdp_connect() started (0 = not reached).
+ * Fields are in the order the phases complete; the gap between two reached
+ * phases is the time spent in the later one. */
+typedef struct {
+    uint32_t pre_connect_ms;        /* PreConnect: channels loaded, before TCP */
+    uint32_t tcp_ms;                /* TCP connection established */
+    uint32_t tls_ms;                /* TLS handshake done */
+    uint32_t nla_ms;                /* NLA/CredSSP done (MCS connect started) */
+    uint32_t license_ms;            /* Licensing done */
+    uint32_t post_connect_ms;       /* PostConnect: capability exchange done */
+    uint32_t connect_ms;            /* freerdp_connect() returned (success or failure) */
+    uint32_t gfx_ready_ms;          /* RDPGFX channel connected, pipeline ready */
+    uint32_t gfx_caps_ms;           /* Server confirmed GFX capabilities */
+    uint32_t first_frame_ms;        /* First GFX EndFrame queued for the browser */
+} RdpConnectTiming;
+
 /* Opaque session handle */
 typedef struct RdpSession RdpSession;
 
@@ -186,9 +234,38 @@ int rdp_set_max_sessions(int limit);
  */
 int rdp_get_max_sessions(void);
 
+/**
+ * Set the number of pre-warmed session contexts to keep ready
+ * 
+ * Pooled contexts are allocated and configured but not connected or
+ * registered, so they do not count towards the session limit. Shrinking
+ * frees the excess immediately; growing takes effect on rdp_pool_fill().
+ * 
+ * @param size      Target pool size, clamped to [0, RDP_POOL_SIZE_MAX]
+ * @return          The applied size
+ */
+int rdp_pool_set_size(int size);
+
+/**
+ * Build contexts until the pool reaches its target size
+ * 
+ * Blocking; call from a worker thread after startup and after each
+ * rdp_create() that consumed a pooled context.
+ * 
+ * @return          Number of contexts added, -1 if none could be built
+ */
+int rdp_pool_fill(void);
+
+/**
+ * Get the number of pre-warmed contexts currently available
+ */
+int rdp_pool_available(void);
+
 /**
  * Create a new RDP session (does not connect yet)
  * 
+ * Takes a pre-warmed context from the pool when one is available.
+ * 
  * @param host      RDP server hostname or IP
  * @param port      RDP port (usually 3389)
  * @param username  Login username
@@ -213,11 +290,31 @@ RdpSession* rdp_create(
 /**
  * Connect to the RDP server
  * 
+ * Blocks for the whole handshake. Takes no process-wide lock, so sessions
+ * can connect in parallel from separate threads.
+ * 
  * @param session   Session handle from rdp_create()
  * @return          0 on success, negative error code on failure
  */
 int rdp_connect(RdpSession* session);
 
+/**
+ * Get connect-phase timings of the last rdp_connect() call
+ * 
+ * The GFX phases are filled in after rdp_connect() returns, as rdp_poll
+ * processes the graphics channel; call again to pick them up.
+ * 
+ * @param session   Session handle
+ * @param timing    Output timings
+ * @return          0 on success, -1 on invalid arguments
+ */
+int rdp_get_connect_timing(RdpSession* session, RdpConnectTiming* timing);
+
+/**
+ * Get the number of successful RDP-side auto-reconnects of a session
+ */
+uint32_t rdp_get_reconnect_count(RdpSession* session);
+
 /**
  * Get current session state
  */
@@ -234,12 +331,32 @@ const char* rdp_get_error(RdpSession* session);
 /**
  * Poll for events and process frame updates
  * 
+ * When the RDP transport fails, the session moves to RDP_STATE_RECONNECTING
+ * and RDP_POLL_TRANSPORT_LOST is returned (again on every call until
+ * rdp_reconnect() runs). Reconnecting is left to the caller because it
+ * blocks for whole handshakes.
+ * 
  * @param session       Session handle
  * @param timeout_ms    Maximum time to wait for events (0 = non-blocking)
- * @return              1 if new frame available, 0 if no update, negative on error
+ * @return              1 if new frame available, 0 if no update,
+ *                      RDP_POLL_TRANSPORT_LOST, or -1 on a fatal error
  */
 int rdp_poll(RdpSession* session, int timeout_ms);
 
+/**
+ * Reconnect a session whose transport was lost (blocking)
+ * 
+ * Reuses the context and presents the server's auto-reconnect cookie, so the
+ * existing Windows session is resumed without a new logon (up to
+ * RDP_AUTO_RECONNECT_MAX_RETRIES attempts; logon errors are not retried).
+ * The server then resends its graphics state on the new connection.
+ * 
+ * @param session   Session handle in RDP_STATE_RECONNECTING
+ * @return          0 when connected again, -1 on failure (session is in
+ *                  RDP_STATE_ERROR, see rdp_get_error)
+ */
+int rdp_reconnect(RdpSession* session);
+
 /**
  * Check if a GFX frame is currently being processed
  * 
@@ -289,6 +406,30 @@ void rdp_send_keyboard(RdpSession* session, uint16_t flags, uint16_t scancode);
  */
 void rdp_send_unicode(RdpSession* session, uint16_t flags, uint16_t code);
 
+/**
+ * Queue a batch of input records for injection
+ * 
+ * Records are posted to the session's lock-free input mailbox (safe from
+ * any thread) and sent from the rdp_poll thread, in order; posting wakes a
+ * waiting rdp_poll. When draining, a pure move (flags == RDP_MOUSE_FLAG_MOVE)
+ * directly following another pure move replaces it (absolute) or adds to it
+ * (relative); button transitions, wheel rotations and keys are never merged.
+ * 
+ * Relative records use the MS-RDPBCGR relative pointer event when the
+ * server advertises it, otherwise they are accumulated into an absolute
+ * position clamped to the desktop.
+ * 
+ * The last slots of the queue are reserved for key and button releases: when
+ * it is nearly full, moves and presses are dropped but releases still go in.
+ * 
+ * @param session   Session handle
+ * @param records   Input records
+ * @param count     Number of records
+ * @return Number of records accepted (less than count if the queue is full),
+ *         or -1 if the session is not connected
+ */
+int rdp_send_input_batch(RdpSession* session, const RdpInputRecord* records, int count);
+
 /**
  * Resize the RDP session
  * 
@@ -368,10 +509,11 @@ typedef struct {
 } RdpAudioContext;
 
 /**
- * Set the audio context for the RDPSND bridge plugin
+ * Set the audio context for the RDPSND bridge plugin (legacy)
  * 
- * Must be called before rdp_connect() to allow the dynamically loaded
- * rdpsnd_bridge.so plugin to access the audio buffer.
+ * Not needed for rdpsnd_bridge.so, which resolves its session by rdpContext
+ * when the audio device opens. Kept for plugins that only read the
+ * process-wide handoff via rdp_get_current_audio_context().
  * 
  * @param session   Session handle
  */
@@ -497,6 +639,65 @@ uint16_t rdp_gfx_get_primary_surface(RdpSession* session);
  */
 int rdp_gfx_send_frame_ack(RdpSession* session, uint32_t frame_id, uint32_t total_frames_decoded, uint32_t queue_depth);
 
+/**
+ * Report WebSocket send-buffer pressure from the streamer
+ * 
+ * While paused the streamer stops draining GFX events; rdp_poll keeps
+ * servicing the connection and all channels (audio, input, keepalives) and
+ * no longer returns early for pending events. The server slows down on the
+ * frame acks it is not getting, and backlog_frames (frames still buffered for
+ * the browser) is added to the queueDepth of every frame acknowledge.
+ * 
+ * @param session        Session handle
+ * @param paused         true above the high-water mark, false once drained
+ * @param backlog_frames Estimated frames waiting in the send buffer
+ */
+void rdp_set_send_backpressure(RdpSession* session, bool paused, uint32_t backlog_frames);
+
+/**
+ * Run a session with no browser attached (or attach one again)
+ * 
+ * While headless, GFX events are dropped before any decode, WebP or
+ * transcode work, every frame is acknowledged at once with
+ * RDP_GFX_QUEUE_DEPTH_SUSPEND, and the server is asked to stop sending
+ * display updates (Suppress Output PDU) when it supports that.
+ * 
+ * Leaving headless mode queues the current GFX state (capabilities,
+ * settings, a graphics reset and the live surfaces) for the new browser
+ * and lets the server repaint the desktop. Applied by the next rdp_poll.
+ * 
+ * @param session   Session handle
+ * @param headless  true while no browser is attached
+ */
+void rdp_set_headless(RdpSession* session, bool headless);
+
+/**
+ * Check whether a repaint can give an attaching browser a complete picture
+ * 
+ * The bridge cannot rebuild GFX cache content (it never holds surface
+ * pixels), so a repaint is only correct if the browser has every cache slot
+ * the server may still draw from with CacheToSurface.
+ * 
+ * @param session       Session handle
+ * @param cache_lost    true if the browser has none of the cache (page reload,
+ *                      or messages it missed are unknown)
+ * @return              true if rdp_set_headless(false) / rdp_request_refresh
+ *                      will leave the browser consistent
+ */
+bool rdp_gfx_cache_resumable(RdpSession* session, bool cache_lost);
+
+/**
+ * Re-queue the current GFX state and ask the server to repaint the desktop
+ * 
+ * For a browser that attaches without any surfaces (e.g. after a page
+ * reload). The current cursor is queued again as well. Applied by the next
+ * rdp_poll.
+ * 
+ * @param session   Session handle
+ * @return          0 on success, -1 if the session is not connected
+ */
+int rdp_request_refresh(RdpSession* session);
+
 /* ============================================================================
  * GFX Event Queue API (for wire format streaming)
  * ============================================================================ */
@@ -20,10 +20,12 @@
 #include <opus/opus.h>
 
 /* ============================================================================
- * Thread-Local Context Passing
+ * Session Context Lookup
  * 
- * Since this plugin is dynamically loaded by FreeRDP, we use thread-local
- * storage to pass the BridgeContext pointer from the main library.
+ * Since this plugin is dynamically loaded by FreeRDP, it finds its session's
+ * audio buffer through rdp_bridge.so: the rdpContext captured at load time is
+ * looked up with rdp_lookup_session_by_rdpcontext() when the device opens.
+ * The thread-local handoff below is kept as a legacy fallback.
  * ============================================================================ */
 
 /* Opaque audio context - matches what rdp_bridge.c provides
@@ -101,6 +103,9 @@ typedef struct {
     /* Back-pointer to audio context */
     AudioContext* audio_ctx;
     
+    /* Owning connection, used to find the session's buffer at Open time */
+    rdpContext* rdpcontext;
+    
 } rdpsndBridgePlugin;
 
 /* ============================================================================
@@ -234,12 +239,27 @@ static BOOL rdpsnd_bridge_open(rdpsndDevicePlugin* device,
     bridge->format = *format;
     bridge->latency = latency;
     
-    /* Get audio context - first check thread-local, then try to fetch from rdp_bridge.so.
+    /* Resolve the audio context of the session that owns this connection.
      * IMPORTANT: We COPY the context values at Open time, not just store a pointer,
-     * because the global g_audio_ctx is reused for each connecting session. */
-    AudioContext* src_ctx = g_current_audio_ctx;
+     * because rdp_get_session_audio_context() returns a thread-local struct. */
+    AudioContext* src_ctx = NULL;
+    if (bridge->rdpcontext) {
+        typedef void* (*lookup_fn)(void*);
+        lookup_fn lookup = (lookup_fn)dlsym(RTLD_DEFAULT, "rdp_lookup_session_by_rdpcontext");
+        lookup_fn get_session_ctx = (lookup_fn)dlsym(RTLD_DEFAULT, "rdp_get_session_audio_context");
+        if (lookup && get_session_ctx) {
+            void* session = lookup(bridge->rdpcontext);
+            if (session) {
+                src_ctx = (AudioContext*)get_session_ctx(session);
+            }
+        }
+    }
+    
+    /* Legacy fallbacks: thread-local handoff, then the process-wide context */
+    if (!src_ctx) {
+        src_ctx = g_current_audio_ctx;
+    }
     if (!src_ctx) {
-        /* Try to get context from rdp_bridge.so via dlsym */
         typedef void* (*get_ctx_fn)(void);
         get_ctx_fn get_ctx = (get_ctx_fn)dlsym(RTLD_DEFAULT, "rdp_get_current_audio_context");
         if (get_ctx) {
@@ -562,6 +582,8 @@ FREERDP_ENTRY_POINT(UINT VCAPITYPE freerdp_rdpsnd_client_subsystem_entry(
     bridge->device.Close = rdpsnd_bridge_close;
     bridge->device.Free = rdpsnd_bridge_free;
     
+    bridge->rdpcontext = freerdp_rdpsnd_get_context(pEntryPoints->rdpsnd);
+    
     /* Register with rdpsnd */
     pEntryPoints->pRegisterRdpsndDevice(pEntryPoints->rdpsnd, &bridge->device);
     
@@ -14,13 +14,18 @@ import json
 import logging
 import os
 import struct
+import time
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor
 from ctypes import (
     POINTER, Structure, c_bool, c_char_p, c_int, c_int32, c_uint8,
     c_uint16, c_uint32, c_void_p
 )
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Optional
+from typing import Optional, Tuple
+
+from websockets.exceptions import ConnectionClosed
 
 # Import wire format for new binary protocol
 from wire_format import (
@@ -31,7 +36,8 @@ from wire_format import (
     build_reset_graphics, parse_frame_ack, get_message_type,
     build_caps_confirm, build_init_settings,
     build_clearcodec_tile,
-    build_pointer_position, build_pointer_system, build_pointer_set
+    build_pointer_position, build_pointer_system, build_pointer_set,
+    build_pointer_cached, build_batch
 )
 
 # Import security policy for connection validation
@@ -73,6 +79,10 @@ RDP_STATE_DISCONNECTED = 0
 RDP_STATE_CONNECTING = 1
 RDP_STATE_CONNECTED = 2
 RDP_STATE_ERROR = 3
+RDP_STATE_RECONNECTING = 4
+
+# rdp_poll result: transport lost, resume it with rdp_reconnect
+RDP_POLL_TRANSPORT_LOST = -2
 
 # Audio frame magic header (PCM - legacy)
 AUDIO_FRAME_MAGIC = b'AUDI'
@@ -97,12 +107,200 @@ RDP_GFX_CODEC_AVC444v2 = 0x000E
 RDP_GFX_CODEC_PROGRESSIVE = 0x000C
 RDP_GFX_CODEC_PROGRESSIVE_V2 = 0x000D
 
+# Frame ack queueDepth telling the server not to wait for acks (MS-RDPEGFX 2.2.3.3)
+RDP_GFX_QUEUE_DEPTH_SUSPEND = 0xFFFFFFFF
+
 # Resolution limits - minimum and maximum allowed screen dimensions
 RDP_MIN_WIDTH = 640
 RDP_MAX_WIDTH = 4096
 RDP_MIN_HEIGHT = 480
 RDP_MAX_HEIGHT = 2304
 
+# Send-buffer flow control: stop draining GFX events once this many bytes are
+# queued in the WebSocket transport, resume below the low-water mark
+DEFAULT_SEND_HIGH_WATER = 1024 * 1024
+SEND_LOW_WATER_RATIO = 4  # low water = high water / 4
+MIN_SEND_HIGH_WATER = 64 * 1024
+
+
+def get_send_water_marks() -> Tuple[int, int]:
+    """(high, low) send-buffer marks from WS_SEND_HIGH_WATER"""
+    try:
+        high = max(MIN_SEND_HIGH_WATER, int(os.environ.get('WS_SEND_HIGH_WATER', DEFAULT_SEND_HIGH_WATER)))
+    except ValueError:
+        logger.warning("Invalid WS_SEND_HIGH_WATER, using default")
+        high = DEFAULT_SEND_HIGH_WATER
+    return high, high // SEND_LOW_WATER_RATIO
+
+# rdp_connect blocks for the whole handshake (TCP, TLS, NLA, licensing,
+# capabilities). Connects run on their own thread pool so a login storm
+# neither queues behind the default executor nor starves rdp_poll calls.
+DEFAULT_CONNECT_WORKERS = 64
+
+_connect_executor: Optional[ThreadPoolExecutor] = None
+_connects_in_progress = 0
+
+# Pre-warmed native contexts (rdp_pool_*): rdp_create takes a ready one and
+# the pool is topped up in the background on the connect executor
+DEFAULT_POOL_SIZE = 2
+_pool_lib = None
+_pool_refill_running = False
+
+
+# Session resume: a browser that drops without sending 'disconnect' has this
+# long to come back with its resume token before the RDP session is closed.
+# Binary messages it may have missed are kept until their frame is acked.
+DEFAULT_RECONNECT_GRACE = 30  # seconds, 0 disables resume
+DEFAULT_REPLAY_MAX_BYTES = 8 * 1024 * 1024
+REPLAY_CURSOR_MAX = 64
+REPLAY_FRAMES_MAX = 1024
+# After the grace period a detached session may keep running headless (no
+# GFX decode/encode, output suppressed) until a browser attaches again.
+DEFAULT_DETACHED_TIMEOUT = 0  # seconds, 0 closes the session when grace ends
+
+# Audio and pointer positions are never replayed (and may arrive as lossy
+# WebTransport datagrams); cursor shapes travel apart from GFX so they are
+# counted separately
+RESUME_UNCOUNTED_MAGICS = frozenset((Magic.OPUS, Magic.AUDI, Magic.PPOS))
+RESUME_CURSOR_MAGICS = frozenset((Magic.PSYS, Magic.PSET, Magic.PCUR))
+
+
+def _get_connect_executor() -> ThreadPoolExecutor:
+    global _connect_executor
+    if _connect_executor is None:
+        try:
+            workers = int(os.environ.get('RDP_CONNECT_WORKERS', DEFAULT_CONNECT_WORKERS))
+        except ValueError:
+            logger.warning("Invalid RDP_CONNECT_WORKERS, using default")
+            workers = DEFAULT_CONNECT_WORKERS
+        _connect_executor = ThreadPoolExecutor(
+            max_workers=max(1, workers), thread_name_prefix='rdp-connect'
+        )
+    return _connect_executor
+
+
+def schedule_pool_refill(lib) -> None:
+    """Top the pre-warmed context pool back up without blocking the caller"""
+    global _pool_lib, _pool_refill_running
+    _pool_lib = lib
+    if _pool_refill_running:
+        return
+    _pool_refill_running = True
+    
+    def _done(future):
+        global _pool_refill_running
+        _pool_refill_running = False
+        if future.exception():
+            logger.warning(f"Session pool refill failed: {future.exception()}")
+        elif future.result() < 0:
+            logger.warning("Session pool refill could not build any context")
+    
+    future = asyncio.get_event_loop().run_in_executor(_get_connect_executor(), lib.rdp_pool_fill)
+    future.add_done_callback(_done)
+
+
+def get_connect_stats() -> dict:
+    """Process-wide connect state (exposed on /metrics)"""
+    return {
+        'connects_in_progress': _connects_in_progress,
+        'pool_available': _pool_lib.rdp_pool_available() if _pool_lib else 0,
+    }
+
+
+class ReplayBuffer:
+    """Binary messages a resuming browser may have missed.
+    
+    GFX and cursor messages are numbered per class; on resume the browser
+    reports how many of each it received and everything after that is sent
+    again. GFX messages are released once the frame they belong to has been
+    acknowledged; cursor messages are a short ring (the next pointer update
+    resyncs the shape anyway).
+    """
+    
+    def __init__(self, max_bytes: int):
+        self.gfx_sent = 0
+        self.cursor_sent = 0
+        self._gfx = deque()  # (seq, message)
+        self._gfx_bytes = 0
+        self._cursor = deque(maxlen=REPLAY_CURSOR_MAX)
+        self._frame_ends = {}  # frame_id -> gfx seq following its END_FRAME
+        self._max_bytes = max_bytes
+    
+    @property
+    def size(self) -> int:
+        return self._gfx_bytes
+    
+    def record(self, message: bytes):
+        magic = bytes(message[:4])
+        if magic in RESUME_UNCOUNTED_MAGICS:
+            return
+        if magic in RESUME_CURSOR_MAGICS:
+            self._cursor.append((self.cursor_sent, message))
+            self.cursor_sent += 1
+            return
+        self._gfx.append((self.gfx_sent, message))
+        self.gfx_sent += 1
+        self._gfx_bytes += len(message)
+        # Over budget the oldest messages go; resuming past them then fails
+        while self._gfx_bytes > self._max_bytes and self._gfx:
+            _, dropped = self._gfx.popleft()
+            self._gfx_bytes -= len(dropped)
+    
+    def mark_frame_end(self, frame_id: int):
+        """Everything recorded so far belongs to frame_id or earlier"""
+        self._frame_ends[frame_id] = self.gfx_sent
+        if len(self._frame_ends) > REPLAY_FRAMES_MAX:
+            del self._frame_ends[next(iter(self._frame_ends))]
+    
+    def acknowledge(self, frame_id: int):
+        """Release the messages of an acknowledged frame and all before it"""
+        end = self._frame_ends.pop(frame_id, None)
+        if end is None:
+            return
+        for older in [fid for fid, seq in self._frame_ends.items() if seq <= end]:
+            del self._frame_ends[older]
+        while self._gfx and self._gfx[0][0] < end:
+            _, released = self._gfx.popleft()
+            self._gfx_bytes -= len(released)
+    
+    def unacknowledged(self) -> list:
+        """Frame ids sent (or held for a resume) but not acknowledged yet"""
+        return list(self._frame_ends)
+    
+    def restart(self, gfx_sent: int, cursor_sent: int):
+        """Drop everything held and continue numbering from the given counts"""
+        self.gfx_sent = gfx_sent
+        self.cursor_sent = cursor_sent
+        self._gfx.clear()
+        self._gfx_bytes = 0
+        self._cursor.clear()
+        self._frame_ends.clear()
+    
+    def pending(self, gfx_received: int, cursor_received: int) -> Optional[list]:
+        """Messages to resend after the given counts, None if no longer held"""
+        if gfx_received > self.gfx_sent or cursor_received > self.cursor_sent:
+            return None
+        oldest = self._gfx[0][0] if self._gfx else self.gfx_sent
+        if gfx_received < oldest:
+            return None
+        # A partial cursor replay would leave PCURs naming unsent PSETs
+        oldest_cursor = self._cursor[0][0] if self._cursor else self.cursor_sent
+        if cursor_received < oldest_cursor:
+            return None
+        messages = [msg for seq, msg in self._gfx if seq >= gfx_received]
+        messages += [msg for seq, msg in self._cursor if seq >= cursor_received]
+        return messages
+
+
+class RdpInputRecord(Structure):
+    """Input record for rdp_send_input_batch (matches C RdpInputRecord, 8 bytes)"""
+    _fields_ = [
+        ('kind', c_uint8),
+        ('flags', c_uint16),
+        ('a', c_uint16),
+        ('b', c_uint16),
+    ]
+
 
 class RdpRect(Structure):
     """Rectangle structure for GFX frame positioning (matches C struct)"""
@@ -114,6 +312,22 @@ class RdpRect(Structure):
     ]
 
 
+class RdpConnectTiming(Structure):
+    """Connect-phase timings in ms since rdp_connect started (matches C struct)"""
+    _fields_ = [
+        ('pre_connect_ms', c_uint32),
+        ('tcp_ms', c_uint32),
+        ('tls_ms', c_uint32),
+        ('nla_ms', c_uint32),
+        ('license_ms', c_uint32),
+        ('post_connect_ms', c_uint32),
+        ('connect_ms', c_uint32),
+        ('gfx_ready_ms', c_uint32),
+        ('gfx_caps_ms', c_uint32),
+        ('first_frame_ms', c_uint32),
+    ]
+
+
 class RdpGfxSurface(Structure):
     """GFX surface descriptor (matches C struct)"""
     _fields_ = [
@@ -148,6 +362,37 @@ RDP_GFX_EVENT_INIT_SETTINGS = 15
 RDP_GFX_EVENT_POINTER_POSITION = 16
 RDP_GFX_EVENT_POINTER_SYSTEM = 17
 RDP_GFX_EVENT_POINTER_SET = 18
+RDP_GFX_EVENT_POINTER_CACHED = 19
+
+# Small per-frame control events whose runs are packed into a deflated BTCH.
+# Codec payloads are incompressible and join the frame container as-is.
+GFX_BATCHABLE_EVENTS = frozenset((
+    RDP_GFX_EVENT_START_FRAME,
+    RDP_GFX_EVENT_END_FRAME,
+    RDP_GFX_EVENT_SOLID_FILL,
+    RDP_GFX_EVENT_SURFACE_TO_SURFACE,
+    RDP_GFX_EVENT_CACHE_TO_SURFACE,
+    RDP_GFX_EVENT_SURFACE_TO_CACHE,
+    RDP_GFX_EVENT_EVICT_CACHE,
+))
+
+# Session setup messages go out as soon as they are drained instead of with
+# the rest of the frame, so the browser configures its decoders and canvas
+# in parallel with the first frame still arriving
+GFX_SETUP_EVENTS = frozenset((
+    RDP_GFX_EVENT_CAPS_CONFIRM,
+    RDP_GFX_EVENT_INIT_SETTINGS,
+    RDP_GFX_EVENT_RESET_GRAPHICS,
+))
+
+# Pointer messages are handled on the browser main thread, never inside the
+# frame container that goes to the GFX worker
+GFX_POINTER_EVENTS = frozenset((
+    RDP_GFX_EVENT_POINTER_POSITION,
+    RDP_GFX_EVENT_POINTER_SYSTEM,
+    RDP_GFX_EVENT_POINTER_SET,
+    RDP_GFX_EVENT_POINTER_CACHED,
+))
 
 
 class RdpGfxEvent(Structure):
@@ -192,6 +437,7 @@ class RdpGfxEvent(Structure):
         ('pointer_system_type', c_uint8), # System pointer type (0=NULL, 1=DEFAULT)
         ('pointer_data', c_void_p),       # BGRA cursor bitmap data
         ('pointer_data_size', c_uint32),  # Size of cursor data
+        ('pointer_cache_id', c_uint16),   # Browser cursor cache slot (POINTER_SET/POINTER_CACHED)
     ]
 
 
@@ -262,7 +508,7 @@ class NativeLibrary:
             try:
                 # Use RTLD_GLOBAL so symbols are visible to plugins loaded by FreeRDP
                 # The rdpsnd bridge plugin uses dlsym(RTLD_DEFAULT, ...) to find
-                # rdp_get_current_audio_context() exported by this library
+                # rdp_lookup_session_by_rdpcontext() exported by this library
                 self._lib = ctypes.CDLL(path, mode=ctypes.RTLD_GLOBAL)
                 logger.info(f"Loaded native library from: {path}")
                 break
@@ -292,6 +538,26 @@ class NativeLibrary:
         lib.rdp_connect.argtypes = [c_void_p]
         lib.rdp_connect.restype = c_int
         
+        # rdp_get_connect_timing
+        lib.rdp_get_connect_timing.argtypes = [c_void_p, POINTER(RdpConnectTiming)]
+        lib.rdp_get_connect_timing.restype = c_int
+        
+        # rdp_get_reconnect_count
+        lib.rdp_get_reconnect_count.argtypes = [c_void_p]
+        lib.rdp_get_reconnect_count.restype = c_uint32
+        
+        # rdp_set_headless
+        lib.rdp_set_headless.argtypes = [c_void_p, c_bool]
+        lib.rdp_set_headless.restype = None
+        
+        # rdp_request_refresh
+        lib.rdp_request_refresh.argtypes = [c_void_p]
+        lib.rdp_request_refresh.restype = c_int
+        
+        # rdp_gfx_cache_resumable
+        lib.rdp_gfx_cache_resumable.argtypes = [c_void_p, c_bool]
+        lib.rdp_gfx_cache_resumable.restype = c_bool
+        
         # rdp_get_state
         lib.rdp_get_state.argtypes = [c_void_p]
         lib.rdp_get_state.restype = c_int
@@ -304,6 +570,10 @@ class NativeLibrary:
         lib.rdp_poll.argtypes = [c_void_p, c_int]
         lib.rdp_poll.restype = c_int
         
+        # rdp_reconnect
+        lib.rdp_reconnect.argtypes = [c_void_p]
+        lib.rdp_reconnect.restype = c_int
+        
         # rdp_gfx_frame_in_progress
         lib.rdp_gfx_frame_in_progress.argtypes = [c_void_p]
         lib.rdp_gfx_frame_in_progress.restype = c_bool
@@ -324,6 +594,10 @@ class NativeLibrary:
         lib.rdp_send_unicode.argtypes = [c_void_p, c_uint16, c_uint16]
         lib.rdp_send_unicode.restype = None
         
+        # rdp_send_input_batch
+        lib.rdp_send_input_batch.argtypes = [c_void_p, POINTER(RdpInputRecord), c_int]
+        lib.rdp_send_input_batch.restype = c_int
+        
         # rdp_resize
         lib.rdp_resize.argtypes = [c_void_p, c_uint32, c_uint32]
         lib.rdp_resize.restype = c_int
@@ -397,6 +671,10 @@ class NativeLibrary:
         lib.rdp_gfx_send_frame_ack.argtypes = [c_void_p, c_uint32, c_uint32, c_uint32]
         lib.rdp_gfx_send_frame_ack.restype = c_int
         
+        # rdp_set_send_backpressure - WebSocket send-buffer state from the streamer
+        lib.rdp_set_send_backpressure.argtypes = [c_void_p, c_bool, c_uint32]
+        lib.rdp_set_send_backpressure.restype = None
+        
         # GFX event queue API (for wire format streaming)
         # rdp_gfx_has_events
         lib.rdp_gfx_has_events.argtypes = [c_void_p]
@@ -423,8 +701,17 @@ class NativeLibrary:
         lib.rdp_get_max_sessions.argtypes = []
         lib.rdp_get_max_sessions.restype = c_int
         
+        # Pre-warmed context pool
+        lib.rdp_pool_set_size.argtypes = [c_int]
+        lib.rdp_pool_set_size.restype = c_int
+        lib.rdp_pool_fill.argtypes = []
+        lib.rdp_pool_fill.restype = c_int
+        lib.rdp_pool_available.argtypes = []
+        lib.rdp_pool_available.restype = c_int
+        
         # Initialize session registry with configurable limit
         self._init_session_registry()
+        self._init_session_pool()
     
     def _init_session_registry(self):
         """Initialize the session registry with configurable limit from RDP_MAX_SESSIONS env var"""
@@ -466,6 +753,16 @@ class NativeLibrary:
         else:
             logger.error("Failed to initialize session registry")
     
+    def _init_session_pool(self):
+        """Set the pre-warmed context pool size from RDP_POOL_SIZE (0 disables)"""
+        pool_size_str = os.environ.get('RDP_POOL_SIZE', '')
+        try:
+            pool_size = int(pool_size_str) if pool_size_str else DEFAULT_POOL_SIZE
+        except ValueError:
+            logger.warning(f"RDP_POOL_SIZE='{pool_size_str}' is not a valid integer, using default {DEFAULT_POOL_SIZE}")
+            pool_size = DEFAULT_POOL_SIZE
+        self._lib.rdp_pool_set_size(pool_size)
+    
     def __getattr__(self, name):
         """Proxy attribute access to the underlying library"""
         return getattr(self._lib, name)
@@ -498,9 +795,43 @@ class RDPBridge:
         # Audio settings
         self._audio_enabled = True
         self._audio_buffer_size = 8192  # PCM buffer size for reading
+        
+        # Control event batching (deflate only pays off on the batched runs)
+        self._batch_compression = os.environ.get('WS_BATCH_COMPRESSION', '1').lower() in ('1', 'true', 'yes')
+        
+        # Send-buffer flow control (see _update_send_backpressure)
+        self._send_high_water, self._send_low_water = get_send_water_marks()
+        self._send_paused = False
+        self._send_buffer_bytes = 0
+        self._send_pause_count = 0
+        self._send_paused_since = 0.0
+        self._send_paused_total = 0.0
+        self._frame_bytes_avg = 0.0  # EWMA of bytes per frame message
+        self._reported_backpressure = (False, 0)
+        
+        # Connect-phase timings from the native library (exposed on /metrics)
+        self._connect_timing: dict = {}
+        
+        # Session resume (see server.py): while detached there is no browser,
+        # nothing is sent and GFX events stay queued natively
+        try:
+            self.reconnect_grace = max(0.0, float(os.environ.get('RDP_RECONNECT_GRACE', DEFAULT_RECONNECT_GRACE)))
+        except ValueError:
+            logger.warning("Invalid RDP_RECONNECT_GRACE, using default")
+            self.reconnect_grace = float(DEFAULT_RECONNECT_GRACE)
+        self._replay = ReplayBuffer(DEFAULT_REPLAY_MAX_BYTES) if self.reconnect_grace > 0 else None
+        try:
+            self.detached_timeout = max(0.0, float(os.environ.get('RDP_DETACHED_TIMEOUT', DEFAULT_DETACHED_TIMEOUT)))
+        except ValueError:
+            logger.warning("Invalid RDP_DETACHED_TIMEOUT, using default")
+            self.detached_timeout = float(DEFAULT_DETACHED_TIMEOUT)
+        self.detached = False
+        self.headless = False
+        self.resume_token: Optional[str] = None
     
     async def connect(self) -> bool:
         """Connect to the RDP server"""
+        global _connects_in_progress
         try:
             # Clamp initial dimensions to allowed range
             self.config.width = max(RDP_MIN_WIDTH, min(self.config.width, RDP_MAX_WIDTH))
@@ -537,8 +868,9 @@ class RDPBridge:
                 logger.error(f"Failed to load native library: {e}")
                 return False
             
-            # Create session
-            self._session = self._lib.rdp_create(
+            # Create session (takes a pre-warmed context when the pool has one)
+            self._session = await asyncio.get_event_loop().run_in_executor(
+                _get_connect_executor(), self._lib.rdp_create,
                 self.config.host.encode('utf-8'),
                 self.config.port,
                 self.config.username.encode('utf-8') if self.config.username else b'',
@@ -548,16 +880,23 @@ class RDPBridge:
                 self.config.height,
                 self.config.color_depth
             )
+            schedule_pool_refill(self._lib)
             
             if not self._session:
                 logger.error("Failed to create RDP session")
                 return False
             
-            # Connect (this may block briefly)
+            # Connect (blocks for the handshake; other sessions connect in parallel)
             logger.info(f"Connecting to {self.config.host}:{self.config.port}...")
-            result = await asyncio.get_event_loop().run_in_executor(
-                None, self._lib.rdp_connect, self._session
-            )
+            _connects_in_progress += 1
+            try:
+                result = await asyncio.get_event_loop().run_in_executor(
+                    _get_connect_executor(), self._lib.rdp_connect, self._session
+                )
+            finally:
+                _connects_in_progress -= 1
+            
+            self._record_connect_timing()
             
             if result != 0:
                 error = self._lib.rdp_get_error(self._session)
@@ -567,7 +906,12 @@ class RDPBridge:
                 self._session = None
                 return False
             
-            logger.info("RDP connection established")
+            timing = self._connect_timing
+            logger.info(
+                f"RDP connection established in {timing.get('connect_ms', 0)}ms "
+                f"(pre-connect {timing.get('pre_connect_ms', 0)}ms, "
+                f"post-connect {timing.get('post_connect_ms', 0)}ms)"
+            )
             self.running = True
             
             # Start frame streaming
@@ -641,6 +985,9 @@ class RDPBridge:
             logger.warning("Cannot send frame ACK: session not active")
             return False
         
+        if self._replay:
+            self._replay.acknowledge(frame_id)
+        
         try:
             result = self._lib.rdp_gfx_send_frame_ack(self._session, frame_id, total_frames_decoded, queue_depth)
             return result == 0
@@ -819,13 +1166,264 @@ class RDPBridge:
                     event.pointer_height,
                     event.pointer_hotspot_x,
                     event.pointer_hotspot_y,
+                    event.pointer_cache_id,
                     bgra_data
                 )
             return None
+        elif event.type == RDP_GFX_EVENT_POINTER_CACHED:
+            # Cursor the browser already holds - no pixels
+            return build_pointer_cached(event.pointer_cache_id)
         else:
             # Unhandled event type
             return None
     
+    def _pack_control_run(self, run: list, frame_messages: list):
+        """Move a run of consecutive control messages into the frame.
+        
+        A single message is kept unwrapped; longer runs become one (possibly
+        deflated) BTCH. The run list is cleared afterwards.
+        """
+        if not run:
+            return
+        if len(run) == 1:
+            frame_messages.append(run[0])
+        else:
+            frame_messages.append(build_batch(run, self._batch_compression))
+        run.clear()
+    
+    async def _send_frame_messages(self, frame_messages: list):
+        """Send everything drained for one frame as a single WebSocket message.
+        
+        The outer BTCH is never compressed: it mostly carries codec payloads,
+        and the control runs inside it are already deflated.
+        """
+        if not frame_messages:
+            return
+        if len(frame_messages) == 1:
+            message = frame_messages[0]
+        else:
+            message = build_batch(frame_messages, compress=False)
+        frame_messages.clear()
+        
+        # Average frame size turns buffered bytes into a frame backlog estimate
+        if self._frame_bytes_avg == 0.0:
+            self._frame_bytes_avg = float(len(message))
+        else:
+            self._frame_bytes_avg += (len(message) - self._frame_bytes_avg) * 0.1
+        
+        await self._send_binary(message)
+    
+    async def _send_binary(self, message: bytes):
+        """Send a binary message, keeping it for replay when resume is enabled.
+        
+        With resume enabled a dead connection is not an error here: the
+        message is already in the replay buffer and server.py detaches the
+        session once the connection handler exits. Headless sessions have
+        nobody to send to and nothing worth replaying.
+        """
+        if self.headless:
+            return
+        if self._replay is None:
+            await self.websocket.send(message)
+            return
+        self._replay.record(message)
+        if self.detached:
+            return
+        try:
+            await self.websocket.send(message)
+        except (ConnectionClosed, ConnectionError):
+            pass
+    
+    def _send_buffer_size(self) -> int:
+        """Bytes queued in the client transport but not yet written to the socket"""
+        transport = getattr(self.websocket, 'transport', None)
+        if transport is None:
+            return 0
+        try:
+            return transport.get_write_buffer_size()
+        except Exception:
+            return 0
+    
+    def _update_send_backpressure(self) -> bool:
+        """Check the send buffer against the high/low-water marks.
+        
+        While paused the streamer stops draining GFX events (the native side
+        keeps servicing audio, input and keepalives); the buffered frame count
+        is added to frame-ack queue depth. The transport only buffers this
+        much because server.py raises its write limit above the high-water
+        mark (websockets' send() otherwise drains at 32 KiB).
+        
+        Returns:
+            True while sending is paused
+        """
+        if self.detached:
+            # No browser: stop draining (headless sessions drop GFX output natively)
+            if self._reported_backpressure != (True, 0) and self._session and self._lib:
+                self._lib.rdp_set_send_backpressure(self._session, True, 0)
+                self._reported_backpressure = (True, 0)
+            return True
+        
+        size = self._send_buffer_size()
+        self._send_buffer_bytes = size
+        
+        if self._send_paused:
+            if size <= self._send_low_water:
+                self._send_paused = False
+                self._send_paused_total += time.monotonic() - self._send_paused_since
+                logger.debug(f"Send buffer drained ({size} bytes), resuming GFX streaming")
+        elif size >= self._send_high_water:
+            self._send_paused = True
+            self._send_pause_count += 1
+            self._send_paused_since = time.monotonic()
+            logger.debug(f"Send buffer at {size} bytes, pausing GFX streaming")
+        
+        backlog_frames = int(size / self._frame_bytes_avg) if self._frame_bytes_avg > 0 else 0
+        state = (self._send_paused, backlog_frames)
+        if state != self._reported_backpressure and self._session and self._lib:
+            self._lib.rdp_set_send_backpressure(self._session, self._send_paused, backlog_frames)
+            self._reported_backpressure = state
+        
+        return self._send_paused
+    
+    def _log_time_to_first_frame(self):
+        self._record_connect_timing()
+        timing = self._connect_timing
+        phases = ', '.join(
+            f"{name[:-3]} {value}ms" for name, value in timing.items()
+            if value and name != 'first_frame_ms'
+        )
+        logger.info(f"Time to first frame: {timing.get('first_frame_ms', 0)}ms ({phases})")
+    
+    def _record_connect_timing(self):
+        timing = RdpConnectTiming()
+        if self._lib.rdp_get_connect_timing(self._session, ctypes.byref(timing)) == 0:
+            self._connect_timing = {
+                name: getattr(timing, name) for name, _ in RdpConnectTiming._fields_
+            }
+    
+    def get_connect_timing(self) -> dict:
+        """Connect-phase timings in ms (exposed on /metrics)
+        
+        GFX phases (gfx_ready_ms, gfx_caps_ms, first_frame_ms) complete after
+        connect() returns, so refresh until the first frame has been seen.
+        """
+        if self._session and self._lib and not self._connect_timing.get('first_frame_ms'):
+            self._record_connect_timing()
+        return dict(self._connect_timing)
+    
+    def get_flow_stats(self) -> dict:
+        """Send-buffer flow control state (exposed on /metrics)"""
+        paused_seconds = self._send_paused_total
+        if self._send_paused:
+            paused_seconds += time.monotonic() - self._send_paused_since
+        return {
+            'send_buffer_bytes': self._send_buffer_bytes,
+            'send_high_water': self._send_high_water,
+            'send_paused': self._send_paused,
+            'send_pause_count': self._send_pause_count,
+            'send_paused_seconds': round(paused_seconds, 3),
+            'send_backlog_frames': self._reported_backpressure[1],
+            'frame_bytes_avg': int(self._frame_bytes_avg),
+            'detached': self.detached,
+            'headless': self.headless,
+            'replay_bytes': self._replay.size if self._replay else 0,
+            'rdp_reconnects': self._lib.rdp_get_reconnect_count(self._session) if self._session and self._lib else 0,
+        }
+    
+    def can_resume(self) -> bool:
+        """True if the session may outlive its connection (grace or headless)"""
+        resumable = self._replay is not None or self.detached_timeout > 0
+        return bool(resumable and self.resume_token and self.running and self._session)
+    
+    def detach(self):
+        """The browser connection is gone: keep the RDP session, stop sending.
+        
+        Without a grace period the session goes headless right away.
+        """
+        self.detached = True
+        self.websocket = None
+        if self._replay is None:
+            self.enter_headless()
+        else:
+            logger.info(f"Session detached, awaiting resume for {self.reconnect_grace:g}s")
+    
+    def enter_headless(self):
+        """Keep a detached session running with no browser for detached_timeout.
+        
+        The native side stops decoding and encoding GFX output, acknowledges
+        frames itself and asks the server to suspend display updates. Nothing
+        held for replay is useful any more: the next browser gets a repaint.
+        """
+        if self.headless or not self._session or not self._lib:
+            return
+        self.headless = True
+        if self._replay:
+            # Frames the old browser never acknowledged would stay in flight
+            for frame_id in self._replay.unacknowledged():
+                self.send_frame_ack(frame_id, 0, RDP_GFX_QUEUE_DEPTH_SUSPEND)
+            self._replay.restart(self._replay.gfx_sent, self._replay.cursor_sent)
+        self._lib.rdp_set_headless(self._session, True)
+        logger.info(f"Session running headless for up to {self.detached_timeout:g}s")
+    
+    async def attach(self, websocket, gfx_received: int, cursor_received: int) -> bool:
+        """Continue a detached session on a new browser connection.
+        
+        Resends the messages the browser did not receive (it keeps its own
+        surfaces and caches), then streaming picks up where it paused. When
+        they are not held (headless session, reloaded page, replay budget
+        exceeded) the GFX state is sent again and the server repaints.
+        
+        Args:
+            websocket: The new connection
+            gfx_received: GFX messages the browser received on earlier connections
+            cursor_received: Cursor messages the browser received
+            
+        Returns:
+            False if the session can no longer be continued
+        """
+        if not self.running or not self._session or not self._lib:
+            return False
+        messages = None
+        if self._replay and not self.headless:
+            messages = self._replay.pending(gfx_received, cursor_received)
+        if messages is None:
+            return self._attach_with_repaint(websocket, gfx_received, cursor_received)
+        self.websocket = websocket
+        for message in messages:
+            await websocket.send(message)
+        self.detached = False
+        logger.info(f"Session resumed, replayed {len(messages)} messages")
+        return True
+    
+    def _attach_with_repaint(self, websocket, gfx_received: int, cursor_received: int) -> bool:
+        """Attach a browser that cannot be replayed to: resend the GFX state and repaint.
+        
+        Refused while the server may draw from GFX cache slots the browser
+        lacks: a repaint cannot rebuild them. Only a browser that received
+        everything sent before the session went headless keeps its cache.
+        """
+        cache_kept = bool(self.headless and self._replay and gfx_received == self._replay.gfx_sent)
+        if not self._lib.rdp_gfx_cache_resumable(self._session, not cache_kept):
+            logger.info("Session not resumed: the browser lacks GFX cache entries the server uses")
+            return False
+        if self.headless:
+            self.headless = False
+            self._lib.rdp_set_headless(self._session, False)
+        else:
+            if self._lib.rdp_request_refresh(self._session) != 0:
+                return False
+            if self._replay:
+                # A browser is attached, so report an empty queue, not suspend
+                for frame_id in self._replay.unacknowledged():
+                    self.send_frame_ack(frame_id, 0, 0)
+        if self._replay:
+            # Numbering continues from what this browser has counted
+            self._replay.restart(gfx_received, cursor_received)
+        self.websocket = websocket
+        self.detached = False
+        logger.info("Session resumed with a full repaint")
+        return True
+    
     async def _stream_frames(self):
         """Stream frames from native library - GFX event streaming with wire format"""
         logger.info("Starting frame streaming")
@@ -837,15 +1435,30 @@ class RDPBridge:
         # Track current frame ID for wire format tile messages
         current_frame_id = 0
         disconnect_reason = None
+        first_frame_pending = True
         
         while self.running:
             try:
+                send_paused = self._update_send_backpressure()
+                
                 # Poll for events (non-blocking)
                 result = await asyncio.get_event_loop().run_in_executor(
                     None, self._lib.rdp_poll, self._session, 16  # 16ms timeout
                 )
                 
                 poll_count += 1                
+                if result == RDP_POLL_TRANSPORT_LOST:
+                    # Reconnect handshakes block for seconds: run them on the
+                    # connect executor so they never hold the threads other
+                    # sessions poll on
+                    logger.warning("RDP transport lost, reconnecting")
+                    result = await asyncio.get_event_loop().run_in_executor(
+                        _get_connect_executor(), self._lib.rdp_reconnect, self._session
+                    )
+                    if result == 0:
+                        logger.info("RDP transport reconnected")
+                        continue
+                
                 if result < 0:
                     # Error or disconnected - capture reason and signal shutdown
                     error = self._lib.rdp_get_error(self._session)
@@ -868,11 +1481,19 @@ class RDPBridge:
                     logger.info(f"GFX pipeline active with codec: {codec_name}")
                     gfx_mode_logged = True
                 
+                # Client is not keeping up: leave events queued natively until
+                # the send buffer drains (rdp_poll still services the channels)
+                if send_paused:
+                    await asyncio.sleep(0.005)
+                    continue
+                
                 # WIRE-THROUGH MODE: Consume GFX events from queue.
                 # VIDEO_FRAME events (H.264/Progressive) are now in the GFX queue
                 # for strict ordering with other GFX commands.
                 events_sent = 0
                 frame_completed = False  # Stop after completing one frame
+                control_run = []
+                frame_messages = []  # One WebSocket message per drained frame
                 
                 while self._lib.rdp_gfx_has_events(self._session) > 0 and not frame_completed:
                     ret = self._lib.rdp_gfx_get_event(
@@ -884,17 +1505,37 @@ class RDPBridge:
                     # Send event (all types including VIDEO_FRAME are handled by _build_gfx_event_message)
                     msg = self._build_gfx_event_message(gfx_event)
                     if msg:
-                        await self.websocket.send(msg)
+                        if gfx_event.type in GFX_POINTER_EVENTS:
+                            await self._send_binary(msg)
+                        elif gfx_event.type in GFX_BATCHABLE_EVENTS:
+                            control_run.append(msg)
+                        elif gfx_event.type in GFX_SETUP_EVENTS:
+                            self._pack_control_run(control_run, frame_messages)
+                            frame_messages.append(msg)
+                            await self._send_frame_messages(frame_messages)
+                            frame_messages = []
+                        else:
+                            # Keep order: pending control events go first
+                            self._pack_control_run(control_run, frame_messages)
+                            frame_messages.append(msg)
                         events_sent += 1
                     
                     # Track frame boundaries
                     if gfx_event.type == RDP_GFX_EVENT_START_FRAME:
                         current_frame_id = gfx_event.frame_id
                     elif gfx_event.type == RDP_GFX_EVENT_END_FRAME:
+                        if first_frame_pending:
+                            first_frame_pending = False
+                            self._log_time_to_first_frame()
                         # Mark frame as completed - stop processing until next poll
                         # This ensures we don't send StartFrame(N+1) before all data is ready
                         frame_completed = True
                 
+                self._pack_control_run(control_run, frame_messages)
+                await self._send_frame_messages(frame_messages)
+                if frame_completed and self._replay:
+                    self._replay.mark_frame_end(current_frame_id)
+                
                 # Note: H264/Progressive frames are now in GFX queue as VIDEO_FRAME events,
                 # so no separate H264 queue draining is needed.
                 
@@ -1023,7 +1664,9 @@ class RDPBridge:
                         message.write(struct.pack('<H', frame_size))
                         message.write(ctypes.string_at(opus_buffer, frame_size))
                         
-                        await self.websocket.send(message.getvalue())
+                        # Audio is live only: drop it while detached
+                        if not self.detached:
+                            await self._send_binary(message.getvalue())
                         frames_sent += 1
                         frames_this_batch += 1
                         last_frame_time = asyncio.get_event_loop().time()
@@ -1164,6 +1807,32 @@ class RDPBridge:
         except Exception as e:
             logger.error(f"Mouse event error: {e}")
     
+    def send_input_batch(self, records) -> int:
+        """Queue a batch of pre-translated input records for the VM.
+        
+        Records come from the browser's INPT message and already carry RDP
+        pointer/keyboard flags. The native queue coalesces consecutive moves
+        and injects on the poll thread; order is preserved.
+        
+        Args:
+            records: List of (kind, flags, a, b) tuples from parse_input_batch
+            
+        Returns:
+            Number of records accepted
+        """
+        if not self.running or not self._session or not self._lib or not records:
+            return 0
+        
+        try:
+            batch = (RdpInputRecord * len(records))(*records)
+            accepted = self._lib.rdp_send_input_batch(self._session, batch, len(records))
+            if 0 <= accepted < len(records):
+                logger.warning(f"Input queue full, dropped {len(records) - accepted} records")
+            return max(accepted, 0)
+        except Exception as e:
+            logger.error(f"Input batch error: {e}")
+            return 0
+    
     async def send_key_event(
         self, action: str, key: str, code: str,
         key_code: int = 0, ctrl: bool = False,
@@ -7,6 +7,7 @@ import asyncio
 import json
 import logging
 import os
+import secrets
 from http import HTTPStatus
 from typing import Dict, Optional
 
@@ -15,8 +16,9 @@ from websockets.asyncio.server import serve, ServerConnection
 from websockets.http11 import Response
 from websockets.datastructures import Headers
 
-from rdp_bridge import RDPBridge, RDPConfig, NativeLibrary
-from wire_format import parse_frame_ack, get_message_type, Magic
+from rdp_bridge import RDPBridge, RDPConfig, NativeLibrary, get_connect_stats, get_send_water_marks, schedule_pool_refill
+from wire_format import parse_frame_ack, parse_input_batch, get_message_type, Magic
+from webtransport import serve_webtransport, AIOQUIC_AVAILABLE, WEBTRANSPORT_PATH
 
 # Load environment variables
 load_dotenv()
@@ -66,6 +68,12 @@ websockets_logger.addFilter(WebSocketErrorFilter())
 # Active sessions: websocket -> RDPBridge
 sessions: Dict[ServerConnection, RDPBridge] = {}
 
+# Sessions a reconnecting browser may resume: resume token -> RDPBridge.
+# Detached ones (no connection) go headless when their grace timer fires and
+# close when their detached timeout does.
+resumable_sessions: Dict[str, RDPBridge] = {}
+resume_timers: Dict[str, asyncio.TimerHandle] = {}
+
 # HTML response for non-WebSocket requests
 INFO_PAGE_HTML = """<!DOCTYPE html>
 <html lang="en">
@@ -91,6 +99,7 @@ INFO_PAGE_HTML = """<!DOCTYPE html>
     <h2>Endpoints</h2>
     <ul>
         <li><code>GET /health</code> - Health check (returns 200 OK)</li>
+        <li><code>GET /metrics</code> - Per-session streaming metrics (JSON)</li>
         <li><code>WebSocket /</code> - RDP streaming connection</li>
     </ul>
 </body>
@@ -109,6 +118,25 @@ def check_native_library() -> tuple[bool, str]:
         return False, str(e)
 
 
+def collect_metrics() -> dict:
+    """Snapshot of per-session streaming state for GET /metrics"""
+    session_stats = []
+    detached = [b for b in resumable_sessions.values() if b.detached]
+    # No target hosts or users: /metrics is unauthenticated on the public port
+    for bridge in list(sessions.values()) + detached:
+        stats = bridge.get_flow_stats()
+        stats['connect_timing'] = bridge.get_connect_timing()
+        session_stats.append(stats)
+    return {
+        'active_sessions': len(session_stats),
+        **get_connect_stats(),
+        'sessions_detached': len(detached),
+        'sessions_headless': sum(1 for b in detached if b.headless),
+        'sessions_send_paused': sum(1 for s in session_stats if s['send_paused'] and not s['detached']),
+        'sessions': session_stats,
+    }
+
+
 def process_request(connection, request):
     """
     Handle non-WebSocket HTTP requests.
@@ -146,6 +174,12 @@ def process_request(connection, request):
                 body
             )
     
+    # Metrics endpoint
+    if request.path == '/metrics':
+        headers = Headers([("Content-Type", "application/json")])
+        body = json.dumps(collect_metrics()).encode('utf-8')
+        return Response(HTTPStatus.OK.value, "OK", headers, body)
+    
     # Check if this is a WebSocket upgrade request
     upgrade_header = None
     for name, value in request.headers.raw_items():
@@ -171,7 +205,7 @@ def process_request(connection, request):
 
 
 async def handle_binary_message(data: bytes, rdp_bridge: Optional[RDPBridge], client_id: int):
-    """Handle binary backchannel messages from browser (FACK)
+    """Handle binary backchannel messages from browser (FACK, INPT)
     
     Args:
         data: Binary message data
@@ -208,14 +242,120 @@ async def handle_binary_message(data: bytes, rdp_bridge: Optional[RDPBridge], cl
         elif not rdp_bridge:
             logger.warning(f"Client {client_id}: Frame ACK received but no RDP bridge active")
             
+    elif msg_type == 'input':
+        # Mouse/keyboard records batched by the browser per animation frame.
+        # Flags are already RDP-encoded; records are applied in send order.
+        records = parse_input_batch(data)
+        if records is None:
+            logger.warning(f"Client {client_id}: Malformed input batch ({len(data)} bytes)")
+        elif rdp_bridge:
+            rdp_bridge.send_input_batch(records)
+            
     else:
         # Unknown binary message
         magic = data[:4].decode('latin-1', errors='replace')
         logger.warning(f"Client {client_id}: Unknown binary message type '{magic}'")
 
 
+def park_session(bridge: RDPBridge):
+    """Keep a session whose connection dropped until it is resumed or times out.
+    
+    It first waits reconnect_grace seconds with its output held for a replay,
+    then runs headless for detached_timeout seconds.
+    """
+    token = bridge.resume_token
+    bridge.detach()
+    if bridge.headless:
+        arm_resume_timer(token, bridge.detached_timeout, expire_session)
+    else:
+        arm_resume_timer(token, bridge.reconnect_grace, end_grace)
+
+
+def arm_resume_timer(token: str, delay: float, handler):
+    resume_timers[token] = asyncio.get_running_loop().call_later(
+        delay, lambda: asyncio.ensure_future(handler(token))
+    )
+
+
+async def end_grace(token: str):
+    resume_timers.pop(token, None)
+    bridge = resumable_sessions.get(token)
+    if not bridge or not bridge.detached:
+        return
+    if bridge.detached_timeout > 0:
+        bridge.enter_headless()
+        arm_resume_timer(token, bridge.detached_timeout, expire_session)
+    else:
+        logger.info(f"Resume grace expired, closing session to {bridge.config.host}")
+        await close_session(bridge)
+
+
+async def expire_session(token: str):
+    resume_timers.pop(token, None)
+    bridge = resumable_sessions.get(token)
+    if bridge and bridge.detached:
+        logger.info(f"Detached session timed out, closing session to {bridge.config.host}")
+        await close_session(bridge)
+
+
+async def close_session(bridge: RDPBridge):
+    """Disconnect a session for good (idempotent)"""
+    if bridge.resume_token:
+        resumable_sessions.pop(bridge.resume_token, None)
+        timer = resume_timers.pop(bridge.resume_token, None)
+        if timer:
+            timer.cancel()
+    await bridge.disconnect()
+
+
+async def resume_session(websocket, data: dict) -> Optional[RDPBridge]:
+    """Attach a new connection to the session named by data['token'].
+    
+    The browser reports how many GFX and cursor messages it received; only
+    the ones after that are resent, or the display is repainted if they are
+    gone (0/0 from a reloaded page). Returns None if the session cannot be
+    continued.
+    """
+    token = str(data.get('token', ''))
+    try:
+        gfx_received = int(data.get('gfxReceived', 0))
+        cursor_received = int(data.get('cursorReceived', 0))
+    except (TypeError, ValueError):
+        return None
+    if gfx_received < 0 or cursor_received < 0:
+        return None
+    bridge = resumable_sessions.get(token)
+    if not bridge:
+        return None
+    
+    timer = resume_timers.pop(token, None)
+    if timer:
+        timer.cancel()
+    if not bridge.detached:
+        # The old connection has not been noticed as dead yet: take over
+        stale = bridge.websocket
+        sessions.pop(stale, None)
+        bridge.detach()
+        asyncio.ensure_future(stale.close())
+    
+    try:
+        attached = await bridge.attach(websocket, gfx_received, cursor_received)
+    except Exception as e:
+        # The new connection died during the replay: wait for the next one
+        logger.warning(f"Resume failed: {e}")
+        if bridge.can_resume():
+            park_session(bridge)
+        else:
+            await close_session(bridge)
+        return None
+    if not attached:
+        await close_session(bridge)
+        return None
+    return bridge
+
+
 async def handle_client(websocket: ServerConnection):
-    """Handle a WebSocket client connection"""
+    """Handle a WebSocket client connection (or a WebTransportConnection, same interface)"""
     client_id = id(websocket)
     logger.info(f"Client {client_id} connected from {websocket.remote_address}")
     
@@ -258,11 +398,17 @@ async def handle_client(websocket: ServerConnection):
                     success = await rdp_bridge.connect()
                     
                     if success:
-                        await websocket.send(json.dumps({
+                        connected = {
                             'type': 'connected',
                             'width': config.width,
                             'height': config.height
-                        }))
+                        }
+                        if rdp_bridge.reconnect_grace > 0 or rdp_bridge.detached_timeout > 0:
+                            rdp_bridge.resume_token = secrets.token_urlsafe(24)
+                            resumable_sessions[rdp_bridge.resume_token] = rdp_bridge
+                            connected['resumeToken'] = rdp_bridge.resume_token
+                            connected['resumeGrace'] = rdp_bridge.reconnect_grace + rdp_bridge.detached_timeout
+                        await websocket.send(json.dumps(connected))
                         logger.info(f"Client {client_id} RDP session started to {config.host}")
                     else:
                         await websocket.send(json.dumps({
@@ -270,9 +416,25 @@ async def handle_client(websocket: ServerConnection):
                             'message': 'Failed to connect to RDP host'
                         }))
                 
+                elif msg_type == 'resume':
+                    bridge = await resume_session(websocket, data) if not rdp_bridge else None
+                    if bridge:
+                        rdp_bridge = bridge
+                        sessions[websocket] = bridge
+                        await websocket.send(json.dumps({
+                            'type': 'resumed',
+                            'width': bridge.config.width,
+                            'height': bridge.config.height,
+                            'resumeToken': bridge.resume_token,
+                            'resumeGrace': bridge.reconnect_grace + bridge.detached_timeout
+                        }))
+                        logger.info(f"Client {client_id} resumed session to {bridge.config.host}")
+                    else:
+                        await websocket.send(json.dumps({'type': 'resume_failed'}))
+                
                 elif msg_type == 'disconnect':
                     if rdp_bridge:
-                        await rdp_bridge.disconnect()
+                        await close_session(rdp_bridge)
                     await websocket.send(json.dumps({'type': 'disconnected'}))
                     break
                 
@@ -349,9 +511,15 @@ async def handle_client(websocket: ServerConnection):
         logger.error(f"Client {client_id} error: {e}")
     
     finally:
-        # Cleanup
-        if rdp_bridge:
-            await rdp_bridge.disconnect()
+        # Cleanup: a dropped connection (no 'disconnect') parks a resumable
+        # session; one taken over by a resume belongs to the new connection
+        if rdp_bridge and rdp_bridge.websocket is websocket:
+            if rdp_bridge.can_resume():
+                park_session(rdp_bridge)
+            else:
+                await close_session(rdp_bridge)
+        elif rdp_bridge and not rdp_bridge.can_resume():
+            await close_session(rdp_bridge)
         if websocket in sessions:
             del sessions[websocket]
         logger.info(f"Client {client_id} disconnected")
@@ -365,7 +533,38 @@ async def main():
     logger.info(f"Starting RDP WebSocket server on ws://{host}:{port}")
     logger.info("Health check available at: http://{}:{}/health".format(host, port))
     
-    async with serve(handle_client, host, port, process_request=process_request):
+    # Pre-warm session contexts so the first logins skip context setup
+    try:
+        schedule_pool_refill(NativeLibrary())
+    except RuntimeError as e:
+        logger.warning(f"Session pool not pre-warmed: {e}")
+    
+    # Both transports block send() at twice the high-water mark, so the bridge
+    # sees the backlog build up and pauses GFX draining first (32 KiB by
+    # default would drain every send before the buffer ever gets near the mark)
+    send_high, send_low = get_send_water_marks()
+    
+    # Optional WebTransport endpoint (HTTP/3 over UDP): audio and pointer
+    # positions as datagrams, GFX on its own stream
+    wt_port = os.getenv('WT_PORT', '')
+    if wt_port:
+        cert_path = os.getenv('WT_CERT_PATH', '/app/certs/webtransport.crt')
+        key_path = os.getenv('WT_KEY_PATH', '/app/certs/webtransport.key')
+        if not AIOQUIC_AVAILABLE:
+            logger.error("WT_PORT is set but aioquic is not installed - WebTransport disabled")
+        else:
+            try:
+                await serve_webtransport(host, int(wt_port), cert_path, key_path, handle_client,
+                                         write_limit=(2 * send_high, send_low))
+                logger.info(f"WebTransport endpoint on https://{host}:{wt_port}{WEBTRANSPORT_PATH.decode()}")
+            except Exception as e:
+                logger.error(f"Failed to start WebTransport endpoint: {e}")
+    
+    # permessage-deflate is disabled: codec payloads (H.264, WebP, Progressive,
+    # Opus) are already compressed, and the small control messages are batched
+    # and deflated per frame by the bridge instead (see wire_format.build_batch)
+    async with serve(handle_client, host, port, process_request=process_request,
+                     compression=None, write_limit=(2 * send_high, send_low)):
         logger.info("Server is running. Press Ctrl+C to stop.")
         await asyncio.Future()  # Run forever
 
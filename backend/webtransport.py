@@ -0,0 +1,370 @@
+"""
+WebTransport (HTTP/3) Endpoint
+Optional second transport next to the WebSocket server
+
+A browser session opens one WebTransport session and one bidirectional
+control stream. Traffic is split so that a lost packet in one class does not
+stall the others (no cross-stream head-of-line blocking):
+
+  - Datagrams (unreliable):  OPUS audio frames, PPOS pointer positions
+  - GFX stream (reliable):   one server-opened unidirectional stream that
+                             carries all GFX messages in order
+  - Control stream (reliable, bidirectional): JSON messages, input (INPT),
+                             frame acks (FACK), cursor shape changes and
+                             anything too large for a datagram
+
+Stream framing: kind(1) + length(4, LE) + payload, kind 0 = binary, 1 = text.
+Datagrams carry one bare wire message (the magic identifies it).
+
+The connection object mimics the parts of websockets' ServerConnection that
+server.handle_client and RDPBridge use, so the session code is shared.
+"""
+
+import asyncio
+import logging
+import struct
+from typing import Callable, Dict, Optional, Tuple, Union
+
+from wire_format import Magic
+
+try:
+    from aioquic.asyncio import QuicConnectionProtocol, serve
+    from aioquic.h3.connection import H3_ALPN, H3Connection
+    from aioquic.h3.events import (
+        DatagramReceived, H3Event, HeadersReceived, WebTransportStreamDataReceived
+    )
+    from aioquic.quic.configuration import QuicConfiguration
+    from aioquic.quic.events import ConnectionTerminated, ProtocolNegotiated, QuicEvent
+    AIOQUIC_AVAILABLE = True
+except ImportError:
+    QuicConnectionProtocol = object
+    AIOQUIC_AVAILABLE = False
+
+logger = logging.getLogger('rdp-webtransport')
+
+# Path of the WebTransport session endpoint (https://host:WT_PORT/rdp)
+WEBTRANSPORT_PATH = b'/rdp'
+
+# Stream frame kinds
+FRAME_BINARY = 0
+FRAME_TEXT = 1
+FRAME_HEADER_SIZE = 5
+
+# Keep datagrams below the smallest QUIC path MTU so they are never dropped
+# for size; larger messages fall back to the control stream
+MAX_DATAGRAM_SIZE = 1100
+
+# Messages that may be lost without leaving the client in a wrong state
+DATAGRAM_MAGICS = (Magic.OPUS, Magic.PPOS)
+
+# Default send buffer limits (high, low) in bytes; server.py passes the same
+# limits it gives the WebSocket server. A send() that finds more than `high`
+# queued waits until the peer has acknowledged down to `low`.
+DEFAULT_WRITE_LIMIT = (2 * 1024 * 1024, 512 * 1024)
+
+# A session whose send buffer does not drain within this many seconds is
+# closed instead of buffering without bound
+SEND_DRAIN_TIMEOUT = 30.0
+
+# Set once the missing aioquic internals have been reported
+_sender_internals_missing_logged = False
+
+# Messages the browser handles on the main thread (cursor state, audio);
+# everything else is GFX and goes on the GFX stream
+CONTROL_MAGICS = (Magic.OPUS, Magic.AUDI, Magic.PPOS, Magic.PSYS, Magic.PSET, Magic.PCUR)
+
+
+def frame_message(message: Union[bytes, str]) -> bytes:
+    """Frame one message for a WebTransport stream."""
+    if isinstance(message, str):
+        payload = message.encode('utf-8')
+        return struct.pack('<BI', FRAME_TEXT, len(payload)) + payload
+    return struct.pack('<BI', FRAME_BINARY, len(message)) + message
+
+
+class WebTransportConnection:
+    """One browser session, presented with a websocket-like interface.
+    
+    Supports `async for message in conn`, `await conn.send(msg)`,
+    `await conn.close(code, reason)`, `conn.remote_address` and
+    `conn.transport.get_write_buffer_size()`.
+    """
+
+    def __init__(self, protocol: 'WebTransportProtocol', session_id: int, remote_address,
+                 write_limit: Tuple[int, int] = DEFAULT_WRITE_LIMIT):
+        self._protocol = protocol
+        self.session_id = session_id
+        self.remote_address = remote_address
+        # RDPBridge reads the send backlog from websocket.transport; the
+        # connection answers get_write_buffer_size() itself
+        self.transport = self
+        self._write_high, self._write_low = write_limit
+        self._drained = asyncio.Event()
+        self._incoming: asyncio.Queue = asyncio.Queue()
+        self._control_stream_id: Optional[int] = None
+        self._control_buffer = bytearray()
+        self._gfx_stream_id: Optional[int] = None
+        self._pending_control: list = []  # Sent before the client opened its control stream
+        self.closed = False
+    
+    # ------------------------------------------------------------------
+    # websocket-compatible interface
+    # ------------------------------------------------------------------
+
+    def __aiter__(self):
+        return self
+
+    async def __anext__(self):
+        message = await self._incoming.get()
+        if message is None:
+            raise StopAsyncIteration
+        return message
+
+    async def send(self, message: Union[bytes, str]):
+        """Route a message to a datagram, the GFX stream or the control stream."""
+        if self.closed:
+            raise ConnectionError('WebTransport session closed')
+        
+        if isinstance(message, (bytes, bytearray)):
+            message = bytes(message)
+            magic = message[:4]
+            if magic in DATAGRAM_MAGICS and len(message) <= MAX_DATAGRAM_SIZE:
+                self._protocol.send_datagram(self.session_id, message)
+                return
+            if magic not in CONTROL_MAGICS:
+                if self._gfx_stream_id is None:
+                    self._gfx_stream_id = self._protocol.create_stream(self.session_id)
+                self._protocol.send_stream(self._gfx_stream_id, frame_message(message))
+                await self._drain()
+                return
+        
+        self._send_control(frame_message(message))
+        await self._drain()
+
+    def get_write_buffer_size(self) -> int:
+        """Bytes written to the reliable streams but not yet acknowledged by the peer."""
+        size = sum(len(framed) for framed in self._pending_control)
+        for stream_id in (self._gfx_stream_id, self._control_stream_id):
+            if stream_id is not None:
+                size += self._protocol.stream_buffer_size(stream_id)
+        return size
+
+    async def close(self, code: int = 1000, reason: str = ''):
+        if self.closed:
+            return
+        self.closed = True
+        self._protocol.close_session(self.session_id, code, reason)
+        self._incoming.put_nowait(None)
+        self._drained.set()
+    
+    async def _drain(self):
+        """Wait while the stream backlog is above the high limit (like websockets' drain).
+        
+        A peer that stops acknowledging would otherwise grow the QUIC send
+        buffers without bound; after SEND_DRAIN_TIMEOUT the session is closed.
+        """
+        if self.get_write_buffer_size() <= self._write_high:
+            return
+        self._drained.clear()
+        try:
+            await asyncio.wait_for(self._drained.wait(), SEND_DRAIN_TIMEOUT)
+        except asyncio.TimeoutError:
+            logger.warning(f"WebTransport session {self.session_id}: send buffer stuck at "
+                           f"{self.get_write_buffer_size()} bytes, closing")
+            await self.close(1011, 'send buffer overflow')
+        if self.closed:
+            raise ConnectionError('WebTransport session closed')
+
+    # ------------------------------------------------------------------
+    # Protocol callbacks
+    # ------------------------------------------------------------------
+
+    def ack_received(self):
+        """Peer packets were processed; wake a blocked send() once drained."""
+        if not self._drained.is_set() and self.get_write_buffer_size() <= self._write_low:
+            self._drained.set()
+
+    def _send_control(self, framed: bytes):
+        if self._control_stream_id is None:
+            self._pending_control.append(framed)
+            return
+        self._protocol.send_stream(self._control_stream_id, framed)
+
+    def stream_data_received(self, stream_id: int, data: bytes, stream_ended: bool):
+        """Data on a client-opened stream; the first one is the control stream."""
+        if self._control_stream_id is None:
+            self._control_stream_id = stream_id
+            for framed in self._pending_control:
+                self._protocol.send_stream(stream_id, framed)
+            self._pending_control.clear()
+        if stream_id != self._control_stream_id:
+            logger.debug(f"Ignoring data on unexpected stream {stream_id}")
+            return
+        
+        buf = self._control_buffer
+        buf.extend(data)
+        while len(buf) >= FRAME_HEADER_SIZE:
+            kind, length = struct.unpack_from('<BI', buf, 0)
+            if len(buf) < FRAME_HEADER_SIZE + length:
+                break
+            payload = bytes(buf[FRAME_HEADER_SIZE:FRAME_HEADER_SIZE + length])
+            del buf[:FRAME_HEADER_SIZE + length]
+            if kind == FRAME_TEXT:
+                self._incoming.put_nowait(payload.decode('utf-8', errors='replace'))
+            else:
+                self._incoming.put_nowait(payload)
+        
+        if stream_ended:
+            self.connection_lost()
+
+    def datagram_received(self, data: bytes):
+        # Client datagrams are not used; input needs reliable delivery
+        logger.debug(f"Ignoring {len(data)}-byte datagram from client")
+
+    def connection_lost(self):
+        if not self.closed:
+            self.closed = True
+            self._incoming.put_nowait(None)
+        self._drained.set()
+
+
+class WebTransportProtocol(QuicConnectionProtocol):
+    """HTTP/3 connection that accepts WebTransport sessions on WEBTRANSPORT_PATH."""
+
+    def __init__(self, *args, handler: Callable = None,
+                 write_limit: Tuple[int, int] = DEFAULT_WRITE_LIMIT, **kwargs):
+        super().__init__(*args, **kwargs)
+        self._http: Optional['H3Connection'] = None
+        self._handler = handler
+        self._write_limit = write_limit
+        self._sessions: Dict[int, WebTransportConnection] = {}
+
+    def datagram_received(self, data: bytes, addr):
+        # ACKs free send buffer space without raising a QUIC event
+        super().datagram_received(data, addr)
+        for conn in list(self._sessions.values()):
+            conn.ack_received()
+
+    def quic_event_received(self, event: 'QuicEvent'):
+        if isinstance(event, ProtocolNegotiated) and event.alpn_protocol in H3_ALPN:
+            self._http = H3Connection(self._quic, enable_webtransport=True)
+        elif isinstance(event, ConnectionTerminated):
+            for conn in self._sessions.values():
+                conn.connection_lost()
+            self._sessions.clear()
+        
+        if self._http is not None:
+            for http_event in self._http.handle_event(event):
+                self._h3_event_received(http_event)
+
+    def _h3_event_received(self, event: 'H3Event'):
+        if isinstance(event, HeadersReceived):
+            headers = dict(event.headers)
+            if (headers.get(b':method') == b'CONNECT' and
+                    headers.get(b':protocol') == b'webtransport' and
+                    headers.get(b':path') == WEBTRANSPORT_PATH):
+                self._accept_session(event.stream_id)
+            else:
+                self._http.send_headers(event.stream_id, [(b':status', b'404')], end_stream=True)
+                self.transmit()
+        elif isinstance(event, WebTransportStreamDataReceived):
+            conn = self._sessions.get(event.session_id)
+            if conn:
+                conn.stream_data_received(event.stream_id, event.data, event.stream_ended)
+        elif isinstance(event, DatagramReceived):
+            conn = self._sessions.get(event.stream_id)
+            if conn:
+                conn.datagram_received(event.data)
+
+    def _accept_session(self, session_id: int):
+        self._http.send_headers(session_id, [
+            (b':status', b'200'),
+            (b'sec-webtransport-http3-draft', b'draft02'),
+        ])
+        self.transmit()
+        
+        remote_address = self._transport.get_extra_info('peername') if self._transport else None
+        conn = WebTransportConnection(self, session_id, remote_address, self._write_limit)
+        self._sessions[session_id] = conn
+        asyncio.ensure_future(self._run_handler(conn))
+
+    async def _run_handler(self, conn: WebTransportConnection):
+        try:
+            await self._handler(conn)
+        finally:
+            await conn.close()
+            self._sessions.pop(conn.session_id, None)
+    
+    # ------------------------------------------------------------------
+    # Used by WebTransportConnection
+    # ------------------------------------------------------------------
+
+    def send_datagram(self, session_id: int, data: bytes):
+        self._http.send_datagram(session_id, data)
+        self.transmit()
+
+    def create_stream(self, session_id: int) -> int:
+        return self._http.create_webtransport_stream(session_id, is_unidirectional=True)
+
+    def send_stream(self, stream_id: int, data: bytes):
+        self._quic.send_stream_data(stream_id, data, end_stream=False)
+        self.transmit()
+
+    def stream_buffer_size(self, stream_id: int) -> int:
+        """Unacknowledged bytes held by aioquic's sender for a stream.
+        
+        aioquic has no public API for this, so it reads the stream sender's
+        buffer (checked against the versions requirements.txt allows).
+        """
+        global _sender_internals_missing_logged
+        streams = getattr(self._quic, '_streams', None)
+        stream = streams.get(stream_id) if streams is not None else None
+        if streams is not None and stream is None:
+            return 0  # Stream already finished and released
+        buffer = getattr(getattr(stream, 'sender', None), '_buffer', None)
+        if buffer is None:
+            if not _sender_internals_missing_logged:
+                _sender_internals_missing_logged = True
+                logger.error("aioquic stream sender internals not found - WebTransport "
+                             "send backpressure and drain timeout are disabled")
+            return 0
+        return len(buffer)
+
+    def close_session(self, session_id: int, code: int, reason: str):
+        # Ending the CONNECT stream closes the WebTransport session
+        try:
+            self._quic.send_stream_data(session_id, b'', end_stream=True)
+            self.transmit()
+        except Exception as e:
+            logger.debug(f"Closing WebTransport session {session_id}: {e}")
+
+
+async def serve_webtransport(host: str, port: int, cert_path: str, key_path: str,
+                             handler: Callable,
+                             write_limit: Tuple[int, int] = DEFAULT_WRITE_LIMIT):
+    """Start the WebTransport endpoint (UDP) and return the QUIC server.
+    
+    Args:
+        host: Bind address
+        port: UDP port
+        cert_path: PEM certificate (self-signed is fine with serverCertificateHashes)
+        key_path: PEM private key
+        handler: Coroutine taking a WebTransportConnection (server.handle_client)
+        write_limit: (high, low) send buffer limits per session in bytes
+    """
+    if not AIOQUIC_AVAILABLE:
+        raise RuntimeError('aioquic is not installed')
+    
+    configuration = QuicConfiguration(
+        alpn_protocols=H3_ALPN,
+        is_client=False,
+        max_datagram_frame_size=65536,
+    )
+    configuration.load_cert_chain(cert_path, key_path)
+    
+    return await serve(
+        host, port,
+        configuration=configuration,
+        create_protocol=lambda *args, **kwargs: WebTransportProtocol(
+            *args, handler=handler, write_limit=write_limit, **kwargs),
+    )
@@ -8,7 +8,8 @@ This module mirrors frontend/wire-format.js for consistent binary protocol.
 """
 
 import struct
-from typing import Optional
+import zlib
+from typing import List, Optional, Tuple
 
 # ============================================================================
 # Magic codes (4 bytes each)
@@ -46,6 +47,7 @@ class Magic:
     
     # Backchannel (browser → server)
     FACK = b'FACK'  # frameAck
+    INPT = b'INPT'  # input record batch
     
     # Audio
     OPUS = b'OPUS'  # Opus audio
@@ -57,7 +59,11 @@ class Magic:
     # Pointer/Cursor
     PPOS = b'PPOS'  # pointerPosition
     PSYS = b'PSYS'  # pointerSystem (null/default)
-    PSET = b'PSET'  # pointerSet (cursor bitmap)
+    PSET = b'PSET'  # pointerSet (cursor bitmap, stored in browser cursor cache)
+    PCUR = b'PCUR'  # pointerCached (show a cursor from browser cursor cache)
+    
+    # Container
+    BTCH = b'BTCH'  # batch of complete messages, optionally raw-deflated
 
 
 # ============================================================================
@@ -595,30 +601,90 @@ def build_pointer_system(ptr_type: int) -> bytes:
 
 
 def build_pointer_set(width: int, height: int, hotspot_x: int, hotspot_y: int,
-                      bgra_data: bytes) -> bytes:
+                      cache_id: int, bgra_data: bytes) -> bytes:
     """
     Build pointerSet message with cursor bitmap.
     
     Layout: PSET(4) + width(2) + height(2) + hotspotX(2) + hotspotY(2) + 
-            dataLen(4) + bgra_data(variable) = 16 + dataLen bytes
+            cacheId(2) + dataLen(4) + bgra_data(variable) = 18 + dataLen bytes
+    
+    The browser stores the cursor under cacheId (replacing any previous
+    entry) so later PCUR messages can reselect it without pixels.
     
     Args:
         width: Cursor width in pixels
         height: Cursor height in pixels
         hotspot_x: Hotspot X coordinate
         hotspot_y: Hotspot Y coordinate
+        cache_id: Browser cursor cache slot
         bgra_data: BGRA32 pixel data (width * height * 4 bytes)
     
     Returns:
         Binary message ready to send via WebSocket
     """
-    return struct.pack('<4sHHHHI',
+    return struct.pack('<4sHHHHHI',
                        Magic.PSET,
                        width, height,
                        hotspot_x, hotspot_y,
+                       cache_id,
                        len(bgra_data)) + bgra_data
 
 
+def build_pointer_cached(cache_id: int) -> bytes:
+    """
+    Build pointerCached message (show a cursor the browser already holds).
+    
+    Layout: PCUR(4) + cacheId(2) = 6 bytes
+    
+    Args:
+        cache_id: Browser cursor cache slot from an earlier PSET
+    
+    Returns:
+        Binary message ready to send via WebSocket
+    """
+    return struct.pack('<4sH', Magic.PCUR, cache_id)
+
+
+# Batch flags
+BATCH_FLAG_DEFLATE = 0x01  # payload is raw deflate (RFC 1951, no zlib header)
+
+# Payloads smaller than this are sent as-is; deflate cannot win much on them
+BATCH_COMPRESS_MIN_SIZE = 256
+
+
+def build_batch(messages: List[bytes], compress: bool = True) -> bytes:
+    """
+    Build a batch container holding several complete messages.
+    
+    Layout: BTCH(4) + flags(1) + count(2) + rawLen(4) + payload
+    Payload (after inflating when BATCH_FLAG_DEFLATE is set):
+        count x [len(4) + message(len)]
+    
+    Sub-messages are applied by the browser in order, exactly as if they had
+    arrived as separate WebSocket messages. A sub-message may itself be a
+    BTCH, so a whole frame can travel as one uncompressed container whose
+    control runs are inner, deflated batches. Compression uses deflate
+    level 1 and is only kept when it actually shrinks the payload.
+    
+    Args:
+        messages: Complete wire messages (each starting with its own magic)
+        compress: Try to raw-deflate the payload
+    
+    Returns:
+        Binary message ready to send via WebSocket
+    """
+    payload = b''.join(struct.pack('<I', len(m)) + m for m in messages)
+    flags = 0
+    body = payload
+    if compress and len(payload) >= BATCH_COMPRESS_MIN_SIZE:
+        deflater = zlib.compressobj(1, zlib.DEFLATED, -15)
+        packed = deflater.compress(payload) + deflater.flush()
+        if len(packed) < len(payload):
+            flags |= BATCH_FLAG_DEFLATE
+            body = packed
+    return struct.pack('<4sBHI', Magic.BTCH, flags, len(messages), len(payload)) + body
+
+
 def parse_frame_ack(data: bytes) -> Optional[dict]:
     """
     Parse frameAck message from browser (MS-RDPEGFX 2.2.3.3 compliant).
@@ -650,6 +716,56 @@ def parse_frame_ack(data: bytes) -> Optional[dict]:
     }
 
 
+# Input record kinds (kind byte fixes the record size)
+INPUT_MOUSE = 1      # kind(1) + pad(1) + pointerFlags(2) + x(2) + y(2) = 8 bytes
+INPUT_SCANCODE = 2   # kind(1) + pad(1) + kbdFlags(2) + scancode(2) = 6 bytes
+INPUT_UNICODE = 3    # kind(1) + pad(1) + kbdFlags(2) + codeUnit(2) = 6 bytes
+INPUT_MOUSE_REL = 4  # kind(1) + pad(1) + pointerFlags(2) + dx(2) + dy(2) = 8 bytes (int16 deltas)
+
+_INPUT_RECORD_SIZES = {INPUT_MOUSE: 8, INPUT_SCANCODE: 6, INPUT_UNICODE: 6, INPUT_MOUSE_REL: 8}
+
+
+def parse_input_batch(data: bytes) -> Optional[List[Tuple[int, int, int, int]]]:
+    """
+    Parse input batch message from browser.
+    
+    Layout: INPT(4) + records, each record sized by its kind byte:
+      MOUSE:            kind(1) + pad(1) + flags(2) + x(2) + y(2)   = 8 bytes
+      MOUSE_REL:        kind(1) + pad(1) + flags(2) + dx(2) + dy(2) = 8 bytes
+      SCANCODE/UNICODE: kind(1) + pad(1) + flags(2) + code(2)       = 6 bytes
+    
+    Flags are already RDP pointer/keyboard flags, so records can be handed
+    to the native input calls without further translation. Relative deltas
+    are left as raw 16-bit values; the native side reads them as int16.
+    
+    Args:
+        data: Binary message from WebSocket
+    
+    Returns:
+        List of (kind, flags, a, b) tuples in send order - (x, y) or (dx, dy)
+        for mouse records, (code, 0) for key records - or None if malformed
+    """
+    if len(data) < 4 or data[:4] != Magic.INPT:
+        return None
+    
+    records = []
+    offset = 4
+    end = len(data)
+    while offset < end:
+        kind = data[offset]
+        size = _INPUT_RECORD_SIZES.get(kind)
+        if size is None or offset + size > end:
+            return None
+        if size == 8:
+            flags, x, y = struct.unpack_from('<HHH', data, offset + 2)
+            records.append((kind, flags, x, y))
+        else:
+            flags, code = struct.unpack_from('<HH', data, offset + 2)
+            records.append((kind, flags, code, 0))
+        offset += size
+    return records
+
+
 def get_message_type(data: bytes) -> Optional[str]:
     """
     Get message type from magic header.
@@ -679,8 +795,10 @@ def get_message_type(data: bytes) -> Optional[str]:
         Magic.C2SF: 'cacheToSurface',
         Magic.H264: 'h264Frame',
         Magic.FACK: 'frameAck',
+        Magic.INPT: 'input',
         Magic.OPUS: 'opusAudio',
         Magic.AUDI: 'rawAudio',
+        Magic.BTCH: 'batch',
     }
     
     return type_map.get(magic)
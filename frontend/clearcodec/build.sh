@@ -1,5 +1,5 @@
 #!/bin/bash
-# Build script for ClearCodec decoder WASM module
+# Build script for ClearCodec decoder WASM module with pthread support
 # Requires Emscripten SDK (emsdk) to be activated
 
 set -e
@@ -8,7 +8,7 @@ SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 BUILD_DIR="$SCRIPT_DIR/build"
 OUTPUT_DIR="$SCRIPT_DIR"
 
-echo "=== Building ClearCodec Decoder WASM ==="
+echo "=== Building ClearCodec Decoder WASM with pthread support ==="
 
 # Check for emcc
 if ! command -v emcc &> /dev/null; then
@@ -29,12 +29,17 @@ emcmake cmake .. -DCMAKE_BUILD_TYPE=Release
 echo "Building..."
 emmake make -j$(nproc 2>/dev/null || echo 4)
 
-# Copy outputs
+# Copy outputs (including pthread worker)
 echo "Copying outputs to $OUTPUT_DIR..."
 cp clearcodec_decoder.js "$OUTPUT_DIR/"
 cp clearcodec_decoder.wasm "$OUTPUT_DIR/"
+if [ -f "clearcodec_decoder.worker.js" ]; then
+    cp clearcodec_decoder.worker.js "$OUTPUT_DIR/"
+    echo "  - pthread worker copied"
+fi
 
 echo "=== Build complete ==="
 echo "Output files:"
 echo "  - $OUTPUT_DIR/clearcodec_decoder.js"
 echo "  - $OUTPUT_DIR/clearcodec_decoder.wasm"
+echo "  - $OUTPUT_DIR/clearcodec_decoder.worker.js (pthread support)"
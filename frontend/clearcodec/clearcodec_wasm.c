@@ -12,11 +12,16 @@
  */
 
 #include <emscripten.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 /* ============================================================================
  * Constants matching FreeRDP clear.c
  * ============================================================================ */
@@ -29,6 +34,20 @@
 #define CLEARCODEC_VBAR_SHORT_SIZE  16384
 #define CLEARCODEC_GLYPH_CACHE_SIZE 4000
 
+/* Per spec a VBar is at most 52 pixels tall and a cached glyph covers at most
+ * 1024 pixels, so both caches are stored as fixed-stride slabs */
+#define CLEARCODEC_VBAR_MAX_HEIGHT  52
+#define CLEARCODEC_GLYPH_MAX_PIXELS 1024
+
+/* Maximum GFX surfaces tracked (matches RFX_MAX_SURFACES in progressive decoder) */
+#define CLEARCODEC_MAX_SURFACES     256
+
+/* Tiles that can be submitted to one clear_decode_frame() call */
+#define CLEARCODEC_MAX_FRAME_TILES  256
+
+/* Worker threads for parallel tile decoding (matches PTHREAD_POOL_SIZE) */
+#define MAX_WORKER_THREADS 4
+
 /* Log2 floor lookup table - matching FreeRDP exactly */
 static const uint32_t CLEAR_LOG2_FLOOR[256] = {
     0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
@@ -48,21 +67,106 @@ static const uint8_t CLEAR_8BIT_MASKS[9] = { 0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F,
 #define BYTES_PER_PIXEL 4
 
 /* ============================================================================
- * Cache structures - matching FreeRDP exactly
+ * Cache structures - same semantics as FreeRDP, compact storage
+ *
+ * Pixels don't live in the entries: VBars index a slab of
+ * CLEARCODEC_VBAR_MAX_HEIGHT pixels per slot, glyphs a pooled arena of
+ * CLEARCODEC_GLYPH_MAX_PIXELS per slot. Slots are addressed directly by
+ * cursor/index and overwritten in place, so no eviction bookkeeping is needed.
  * ============================================================================ */
 
 typedef struct {
-    uint32_t size;     /* Allocated size in pixels */
+    uint32_t size;     /* Capacity in use (pixels), 0 = slot never written */
     uint32_t count;    /* Current count of pixels */
-    uint32_t* pixels;  /* RGBA pixel data */
+    uint32_t* overflow; /* Heap storage for out-of-spec glyphs larger than a slot */
 } ClearGlyphEntry;
 
 typedef struct {
-    uint32_t size;     /* Allocated size in bytes */
-    uint32_t count;    /* Current count of pixels */
-    uint8_t* pixels;   /* RGBA pixel data (4 bytes per pixel) */
+    uint8_t size;      /* Highest pixel count used, 0 = slot never written */
+    uint8_t count;     /* Current count of pixels */
 } ClearVBarEntry;
 
+/* ============================================================================
+ * Surface framebuffer - decode target kept in WASM memory
+ * ============================================================================ */
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint8_t* data;     /* RGBA pixels, stride = width * 4 (allocated on first decode) */
+} ClearSurface;
+
+/* ============================================================================
+ * Tile jobs - a tile is decoded in two passes
+ *
+ * The ordered pass runs on the calling thread, in arrival order, and performs
+ * every step that touches session caches: sequence number, cache reset, glyph
+ * slot lookup and the VBar cache updates of the bands layer. VBars are
+ * resolved into ClearVBarRun snapshots, so the second pass - residual, VBar
+ * rendering, subcodecs and the glyph store - only reads the payload and
+ * writes the tile's own pixels, and can run on a worker thread.
+ * ============================================================================ */
+
+/* Per-thread scratch buffer (residual decoding) */
+typedef struct {
+    uint8_t* tempBuffer;
+    uint32_t tempSize;
+} ClearScratch;
+
+/* A VBar column resolved by the ordered pass (clipped to the destination) */
+typedef struct {
+    uint32_t x;        /* Destination column */
+    uint32_t y;        /* Destination row of the first pixel */
+    uint32_t count;    /* Visible pixels */
+    uint32_t offset;   /* First pixel in ClearContext.vBarRunPixels */
+} ClearVBarRun;
+
+typedef struct {
+    /* Destination */
+    uint8_t* pDstData;
+    uint32_t nDstStep;
+    uint32_t nXDst, nYDst;
+    uint32_t nWidth, nHeight;
+    uint32_t nDstWidth, nDstHeight;
+    bool clearRect;             /* Zero the tile rectangle before decoding */
+
+    /* Glyph cache slots resolved by the ordered pass */
+    int32_t glyphIndex;         /* Glyph slot used by this tile, -1 if none */
+    const uint32_t* glyphHit;   /* Cached glyph to copy into the tile */
+    uint8_t* glyphData;         /* Slot to store the decoded tile into */
+
+    /* Payload layers validated by the ordered pass (NULL = skip) */
+    const uint8_t* residual;
+    size_t residualSize;        /* Bytes available from residual onwards */
+    uint32_t residualByteCount;
+    const uint8_t* subcodecs;
+    size_t subcodecsSize;       /* Bytes available from subcodecs onwards */
+    uint32_t subcodecByteCount;
+    uint32_t firstRun;          /* VBar runs in ClearContext.vBarRuns */
+    uint32_t runCount;
+
+    /* Area written (tile rectangle plus VBars, which may extend past it) */
+    uint32_t left, top, right, bottom;
+
+    int32_t status;             /* Ordered pass result */
+    int32_t result;             /* Final result */
+} ClearTileJob;
+
+/* Tile descriptor written by JS for clear_decode_frame() (7 x u32) */
+typedef struct {
+    uint32_t surfaceId;
+    uint32_t srcOffset;         /* Payload offset in the input staging buffer */
+    uint32_t srcSize;
+    uint32_t x, y, width, height;
+} ClearFrameTile;
+
+/* Per-tile result read by JS after clear_decode_frame() (6 x u32) */
+typedef struct {
+    uint32_t surfaceId;
+    uint32_t x, y, width, height;  /* Surface area written (empty on error) */
+    int32_t result;                /* 0 on success, negative on error */
+} ClearDirtyRect;
+
 /* ============================================================================
  * ClearCodec context - session-level state
  * ============================================================================ */
@@ -70,23 +174,49 @@ typedef struct {
 typedef struct {
     /* Sequence number for ordering */
     uint32_t seqNumber;
-    
-    /* Temporary decode buffer */
-    uint8_t* tempBuffer;
-    uint32_t tempSize;
-    
+
+    /* Temporary decode buffer for tiles decoded on the calling thread */
+    ClearScratch scratch;
+
     /* Glyph cache (4000 entries per spec) */
     ClearGlyphEntry glyphCache[CLEARCODEC_GLYPH_CACHE_SIZE];
+    uint32_t* glyphArena;       /* GLYPH_CACHE_SIZE x GLYPH_MAX_PIXELS, allocated on first use */
     
     /* VBar storage (32768 entries) */
     uint32_t vBarStorageCursor;
     ClearVBarEntry vBarStorage[CLEARCODEC_VBAR_SIZE];
+    uint32_t* vBarPixels;       /* VBAR_SIZE x VBAR_MAX_HEIGHT slab */
     
     /* Short VBar storage (16384 entries) */
     uint32_t shortVBarStorageCursor;
     ClearVBarEntry shortVBarStorage[CLEARCODEC_VBAR_SHORT_SIZE];
+    uint32_t* shortVBarPixels;  /* VBAR_SHORT_SIZE x VBAR_MAX_HEIGHT slab */
+    
+    /* Reusable input staging buffer (JS copies tile payloads here) */
+    uint8_t* inputBuffer;
+    uint32_t inputSize;
+    
+    /* Per-surface framebuffers (decode targets) */
+    ClearSurface* surfaces[CLEARCODEC_MAX_SURFACES];
+
+    /* VBar snapshots taken by the ordered pass, replayed by tile jobs */
+    ClearVBarRun* vBarRuns;
+    uint32_t vBarRunCount;
+    uint32_t vBarRunCapacity;
+    uint32_t* vBarRunPixels;
+    uint32_t vBarRunPixelCount;
+    uint32_t vBarRunPixelCapacity;
+
+    /* Frame-level batch: tile descriptors in, dirty rects out */
+    ClearFrameTile frameTiles[CLEARCODEC_MAX_FRAME_TILES];
+    ClearDirtyRect dirtyRects[CLEARCODEC_MAX_FRAME_TILES];
+    ClearTileJob jobs[CLEARCODEC_MAX_FRAME_TILES];
 } ClearContext;
 
+/* Forward declarations */
+void clear_free(ClearContext* ctx);
+void clear_delete_surface(ClearContext* ctx, uint16_t surfaceId);
+
 /* ============================================================================
  * Stream reading utilities
  * ============================================================================ */
@@ -145,77 +275,155 @@ static inline uint32_t read_rgba_pixel(const uint8_t* src) {
            ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
 }
 
+/* Fill a run of pixels with one color (128-bit stores when SIMD is available) */
+static inline void fill_rgba_pixels(uint8_t* dst, uint32_t color, uint32_t count) {
+#ifdef __wasm_simd128__
+    /* WASM is little-endian, so the splatted word has R,G,B,A byte order */
+    const v128_t v = wasm_i32x4_splat((int32_t)color);
+    while (count >= 4) {
+        wasm_v128_store(dst, v);
+        dst += 4 * BYTES_PER_PIXEL;
+        count -= 4;
+    }
+#endif
+    while (count--) {
+        write_rgba_pixel(dst, color);
+        dst += BYTES_PER_PIXEL;
+    }
+}
+
 /* ============================================================================
  * Cache management - matching FreeRDP exactly
  * ============================================================================ */
 
 static void clear_reset_vbar_storage(ClearContext* ctx, bool freeMemory) {
     if (freeMemory) {
-        for (size_t i = 0; i < CLEARCODEC_VBAR_SIZE; i++) {
-            free(ctx->vBarStorage[i].pixels);
-            ctx->vBarStorage[i].pixels = NULL;
-            ctx->vBarStorage[i].size = 0;
-            ctx->vBarStorage[i].count = 0;
-        }
+        free(ctx->vBarPixels);
+        free(ctx->shortVBarPixels);
+        ctx->vBarPixels = NULL;
+        ctx->shortVBarPixels = NULL;
+        memset(ctx->vBarStorage, 0, sizeof(ctx->vBarStorage));
+        memset(ctx->shortVBarStorage, 0, sizeof(ctx->shortVBarStorage));
     }
     ctx->vBarStorageCursor = 0;
-    
-    if (freeMemory) {
-        for (size_t i = 0; i < CLEARCODEC_VBAR_SHORT_SIZE; i++) {
-            free(ctx->shortVBarStorage[i].pixels);
-            ctx->shortVBarStorage[i].pixels = NULL;
-            ctx->shortVBarStorage[i].size = 0;
-            ctx->shortVBarStorage[i].count = 0;
-        }
-    }
     ctx->shortVBarStorageCursor = 0;
 }
 
 static void clear_reset_glyph_cache(ClearContext* ctx) {
     for (size_t i = 0; i < CLEARCODEC_GLYPH_CACHE_SIZE; i++) {
-        free(ctx->glyphCache[i].pixels);
-        ctx->glyphCache[i].pixels = NULL;
+        free(ctx->glyphCache[i].overflow);
+        ctx->glyphCache[i].overflow = NULL;
         ctx->glyphCache[i].size = 0;
         ctx->glyphCache[i].count = 0;
     }
+    free(ctx->glyphArena);
+    ctx->glyphArena = NULL;
 }
 
-static bool resize_vbar_entry(ClearVBarEntry* entry) {
+static inline uint32_t* vbar_pixels(ClearContext* ctx, uint32_t index) {
+    return &ctx->vBarPixels[index * CLEARCODEC_VBAR_MAX_HEIGHT];
+}
+
+static inline uint32_t* short_vbar_pixels(ClearContext* ctx, uint32_t index) {
+    return &ctx->shortVBarPixels[index * CLEARCODEC_VBAR_MAX_HEIGHT];
+}
+
+/* Slab slots beyond an entry's size are never written and stay zeroed,
+ * so growing an entry only needs to raise its size */
+static inline void resize_vbar_entry(ClearVBarEntry* entry) {
     if (entry->count > entry->size) {
-        const uint32_t oldBytes = entry->size * BYTES_PER_PIXEL;
-        const uint32_t newBytes = entry->count * BYTES_PER_PIXEL;
-        
-        uint8_t* tmp = (uint8_t*)realloc(entry->pixels, newBytes);
-        if (!tmp) {
-            return false;
-        }
-        
-        /* Zero-init new memory */
-        memset(tmp + oldBytes, 0, newBytes - oldBytes);
-        entry->pixels = tmp;
         entry->size = entry->count;
     }
+}
+
+/**
+ * Get storage for a glyph slot able to hold pixelCount pixels
+ * Spec-sized glyphs use the slot in the pooled arena; larger ones (tolerated
+ * like FreeRDP does) move to a per-entry heap buffer, preserving contents.
+ */
+static uint32_t* glyph_entry_reserve(ClearContext* ctx, uint32_t glyphIndex, uint32_t pixelCount) {
+    ClearGlyphEntry* entry = &ctx->glyphCache[glyphIndex];
+    
+    if (!ctx->glyphArena) {
+        ctx->glyphArena = (uint32_t*)calloc(
+            (size_t)CLEARCODEC_GLYPH_CACHE_SIZE * CLEARCODEC_GLYPH_MAX_PIXELS, BYTES_PER_PIXEL);
+        if (!ctx->glyphArena) {
+            return NULL;
+        }
+    }
     
-    if (!entry->pixels && entry->size > 0) {
-        return false;
+    uint32_t* slot = &ctx->glyphArena[(size_t)glyphIndex * CLEARCODEC_GLYPH_MAX_PIXELS];
+    
+    if (pixelCount > entry->size) {
+        if (pixelCount > CLEARCODEC_GLYPH_MAX_PIXELS) {
+            uint32_t* tmp = (uint32_t*)realloc(entry->overflow, pixelCount * BYTES_PER_PIXEL);
+            if (!tmp) {
+                return NULL;
+            }
+            if (!entry->overflow) {
+                memcpy(tmp, slot, entry->size * BYTES_PER_PIXEL);
+            }
+            entry->overflow = tmp;
+        }
+        entry->size = pixelCount;
     }
     
-    return true;
+    return entry->overflow ? entry->overflow : slot;
 }
 
-static bool resize_temp_buffer(ClearContext* ctx, uint32_t width, uint32_t height) {
+static bool resize_temp_buffer(ClearScratch* scratch, uint32_t width, uint32_t height) {
     uint32_t size = (width + 16) * (height + 16) * BYTES_PER_PIXEL;
     
-    if (size > ctx->tempSize) {
-        uint8_t* tmp = (uint8_t*)realloc(ctx->tempBuffer, size);
+    if (size > scratch->tempSize) {
+        uint8_t* tmp = (uint8_t*)realloc(scratch->tempBuffer, size);
         if (!tmp) {
             return false;
         }
         memset(tmp, 0, size);
-        ctx->tempBuffer = tmp;
-        ctx->tempSize = size;
+        scratch->tempBuffer = tmp;
+        scratch->tempSize = size;
+    }
+    
+    return true;
+}
+
+/**
+ * Snapshot a VBar column for a tile job
+ * The job may run after later tiles have overwritten the cache slot.
+ */
+static bool clear_push_vbar_run(ClearContext* ctx, uint32_t x, uint32_t y,
+                                const uint32_t* pixels, uint32_t count) {
+    if (ctx->vBarRunCount >= ctx->vBarRunCapacity) {
+        uint32_t newCapacity = ctx->vBarRunCapacity ? ctx->vBarRunCapacity * 2 : 256;
+        ClearVBarRun* tmp = (ClearVBarRun*)realloc(ctx->vBarRuns, newCapacity * sizeof(ClearVBarRun));
+        if (!tmp) {
+            return false;
+        }
+        ctx->vBarRuns = tmp;
+        ctx->vBarRunCapacity = newCapacity;
+    }
+    
+    if (count > ctx->vBarRunPixelCapacity - ctx->vBarRunPixelCount) {
+        uint32_t newCapacity = ctx->vBarRunPixelCapacity ? ctx->vBarRunPixelCapacity : 4096;
+        while (newCapacity - ctx->vBarRunPixelCount < count) newCapacity *= 2;
+        
+        uint32_t* tmp = (uint32_t*)realloc(ctx->vBarRunPixels, newCapacity * BYTES_PER_PIXEL);
+        if (!tmp) {
+            return false;
+        }
+        ctx->vBarRunPixels = tmp;
+        ctx->vBarRunPixelCapacity = newCapacity;
     }
     
+    ClearVBarRun* run = &ctx->vBarRuns[ctx->vBarRunCount++];
+    run->x = x;
+    run->y = y;
+    run->count = count;
+    run->offset = ctx->vBarRunPixelCount;
+    
+    memcpy(&ctx->vBarRunPixels[ctx->vBarRunPixelCount], pixels, count * BYTES_PER_PIXEL);
+    ctx->vBarRunPixelCount += count;
+    
     return true;
 }
 
@@ -307,15 +515,27 @@ static bool clear_decompress_subcode_rlex(
             return false;
         }
         
-        /* Write run-length pixels */
-        for (uint32_t i = 0; i < runLengthFactor; i++) {
+        /* Write run-length pixels, one clipped row segment at a time */
+        uint32_t runRemaining = runLengthFactor;
+        while (runRemaining > 0) {
+            uint32_t segment = width - x;
+            if (segment > runRemaining) segment = runRemaining;
+            
             if ((nXDstRel + x < nDstWidth) && (nYDstRel + y < nDstHeight)) {
+                uint32_t visible = segment;
+                if (nXDstRel + x + visible > nDstWidth) {
+                    visible = nDstWidth - (nXDstRel + x);
+                }
+                
                 uint8_t* pTmpData = &pDstData[(nXDstRel + x) * BYTES_PER_PIXEL + 
                                               (nYDstRel + y) * nDstStep];
-                write_rgba_pixel(pTmpData, color);
+                fill_rgba_pixels(pTmpData, color, visible);
             }
             
-            if (++x >= width) {
+            x += segment;
+            runRemaining -= segment;
+            
+            if (x >= width) {
                 y++;
                 x = 0;
             }
@@ -360,10 +580,13 @@ static bool clear_decompress_subcode_rlex(
 
 /* ============================================================================
  * Residual data decoder - matching FreeRDP exactly
+ *
+ * With pDstData == NULL the runs are only parsed and checked, which lets the
+ * ordered pass advance the stream exactly as a full decode would.
  * ============================================================================ */
 
 static bool clear_decompress_residual_data(
-    ClearContext* ctx, Stream* s,
+    ClearScratch* scratch, Stream* s,
     uint32_t residualByteCount,
     uint32_t nWidth, uint32_t nHeight,
     uint8_t* pDstData, uint32_t nDstStep,
@@ -376,9 +599,9 @@ static bool clear_decompress_residual_data(
     
     if (!stream_check(s, residualByteCount)) return false;
     
-    if (!resize_temp_buffer(ctx, nWidth, nHeight)) return false;
+    if (pDstData && !resize_temp_buffer(scratch, nWidth, nHeight)) return false;
     
-    uint8_t* dstBuffer = ctx->tempBuffer;
+    uint8_t* dstBuffer = pDstData ? scratch->tempBuffer : NULL;
     
     while (suboffset < residualByteCount) {
         uint8_t b, g, r;
@@ -411,9 +634,9 @@ static bool clear_decompress_residual_data(
             return false;
         }
         
-        for (uint32_t i = 0; i < runLengthFactor; i++) {
-            write_rgba_pixel(dstBuffer, color);
-            dstBuffer += BYTES_PER_PIXEL;
+        if (dstBuffer) {
+            fill_rgba_pixels(dstBuffer, color, runLengthFactor);
+            dstBuffer += runLengthFactor * BYTES_PER_PIXEL;
         }
         
         pixelIndex += runLengthFactor;
@@ -423,6 +646,10 @@ static bool clear_decompress_residual_data(
         return false;
     }
     
+    if (!pDstData) {
+        return true;
+    }
+    
     /* Copy temp buffer to destination */
     uint32_t nSrcStep = nWidth * BYTES_PER_PIXEL;
     for (uint32_t y = 0; y < nHeight; y++) {
@@ -434,7 +661,7 @@ static bool clear_decompress_residual_data(
         }
         
         uint8_t* dst = &pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL];
-        uint8_t* src = &ctx->tempBuffer[y * nSrcStep];
+        uint8_t* src = &scratch->tempBuffer[y * nSrcStep];
         memcpy(dst, src, copyWidth * BYTES_PER_PIXEL);
     }
     
@@ -453,6 +680,34 @@ static bool clear_decompress_residual_data(
  *   - Plane data (may be RLE compressed if PlaneByteCount < original)
  * ============================================================================ */
 
+/**
+ * Count consecutive literal bytes starting at in[start] (a byte is a literal
+ * when the next byte differs from it), up to maxCount
+ */
+static inline size_t nsc_rle_literal_length(const uint8_t* in, size_t inSize,
+                                            size_t start, size_t maxCount) {
+    size_t n = 0;
+    
+#ifdef __wasm_simd128__
+    /* Compare 16 bytes against their successors at a time */
+    while (n + 16 <= maxCount && start + n + 16 < inSize) {
+        v128_t cur = wasm_v128_load(in + start + n);
+        v128_t next = wasm_v128_load(in + start + n + 1);
+        uint32_t eqMask = wasm_i8x16_bitmask(wasm_i8x16_eq(cur, next));
+        if (eqMask) {
+            return n + __builtin_ctz(eqMask);
+        }
+        n += 16;
+    }
+#endif
+    
+    while (n < maxCount && start + n + 1 < inSize && in[start + n] != in[start + n + 1]) {
+        n++;
+    }
+    
+    return n;
+}
+
 /* NSCodec RLE decompression */
 static bool nsc_rle_decode(const uint8_t* in, size_t inSize, uint8_t* out,
                            uint32_t outSize, uint32_t originalSize)
@@ -467,7 +722,19 @@ static bool nsc_rle_decode(const uint8_t* in, size_t inSize, uint8_t* out,
         uint8_t value = in[inPos++];
         uint32_t len = 0;
         
-        if (left == 5) {
+        if (left > 5 && inPos < inSize && value != in[inPos]) {
+            /* Literal - copy the whole stretch of literals up to the next run
+             * (or the left == 5 boundary) in one go instead of byte by byte */
+            size_t start = inPos - 1;
+            size_t n = nsc_rle_literal_length(in, inSize, start, left - 5);
+            
+            if (outPos + n > outSize) return false;
+            
+            memcpy(out + outPos, in + start, n);
+            inPos = start + n;
+            outPos += n;
+            left -= (uint32_t)n;
+        } else if (left == 5) {
             if (outPos >= outSize) return false;
             out[outPos++] = value;
             left--;
@@ -519,6 +786,88 @@ static inline int clamp_byte(int val) {
     return val;
 }
 
+/**
+ * Convert one row of YCoCg planes to RGBA
+ * With chroma subsampling each Co/Cg sample covers two horizontal pixels.
+ * Co/Cg are shifted left by the color loss level and sign-extended from 8 bits.
+ */
+static void nsc_ycocg_to_rgba_row(
+    uint8_t* dst,
+    const uint8_t* yplane, const uint8_t* coplane,
+    const uint8_t* cgplane, const uint8_t* aplane,
+    uint32_t width, uint8_t shift, bool subsampled)
+{
+    uint32_t x = 0;
+    
+#ifdef __wasm_simd128__
+    /* 8 pixels per iteration in 16-bit lanes; (v << (shift + 8)) >> 8 is the
+     * 16-bit equivalent of (int8_t)(v << shift) */
+    const uint32_t chromaShift = shift + 8;
+    
+    for (; x + 8 <= width; x += 8) {
+        v128_t yv = wasm_u16x8_load8x8(yplane + x);
+        v128_t av = wasm_u16x8_load8x8(aplane + x);
+        v128_t cov, cgv;
+        
+        if (subsampled) {
+            /* Supersample 4 chroma samples to 8 pixels */
+            v128_t co4 = wasm_v128_load32_zero(coplane + (x >> 1));
+            v128_t cg4 = wasm_v128_load32_zero(cgplane + (x >> 1));
+            cov = wasm_u16x8_extend_low_u8x16(
+                wasm_i8x16_shuffle(co4, co4, 0, 0, 1, 1, 2, 2, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0));
+            cgv = wasm_u16x8_extend_low_u8x16(
+                wasm_i8x16_shuffle(cg4, cg4, 0, 0, 1, 1, 2, 2, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0));
+        } else {
+            cov = wasm_u16x8_load8x8(coplane + x);
+            cgv = wasm_u16x8_load8x8(cgplane + x);
+        }
+        
+        cov = wasm_i16x8_shr(wasm_i16x8_shl(cov, chromaShift), 8);
+        cgv = wasm_i16x8_shr(wasm_i16x8_shl(cgv, chromaShift), 8);
+        
+        v128_t rv = wasm_i16x8_sub(wasm_i16x8_add(yv, cov), cgv);
+        v128_t gv = wasm_i16x8_add(yv, cgv);
+        v128_t bv = wasm_i16x8_sub(wasm_i16x8_sub(yv, cov), cgv);
+        
+        /* Saturating narrow clamps to 0..255 */
+        v128_t rg = wasm_u8x16_narrow_i16x8(rv, gv);
+        v128_t ba = wasm_u8x16_narrow_i16x8(bv, av);
+        
+        /* Interleave R,G,B,A */
+        v128_t lo = wasm_i8x16_shuffle(rg, ba, 0, 8, 16, 24, 1, 9, 17, 25,
+                                               2, 10, 18, 26, 3, 11, 19, 27);
+        v128_t hi = wasm_i8x16_shuffle(rg, ba, 4, 12, 20, 28, 5, 13, 21, 29,
+                                               6, 14, 22, 30, 7, 15, 23, 31);
+        wasm_v128_store(dst + x * BYTES_PER_PIXEL, lo);
+        wasm_v128_store(dst + x * BYTES_PER_PIXEL + 16, hi);
+    }
+#endif
+    
+    for (; x < width; x++) {
+        /* Read Y value directly */
+        int16_t y_val = (int16_t)yplane[x];
+        
+        /* For Co/Cg with chroma subsampling, use x >> 1 to get subsampled index */
+        uint32_t chromaX = subsampled ? (x >> 1) : x;
+        
+        /* Apply shift for color loss recovery - cast to int8_t for sign extension */
+        int16_t co_val = (int16_t)(int8_t)(((int16_t)coplane[chromaX]) << shift);
+        int16_t cg_val = (int16_t)(int8_t)(((int16_t)cgplane[chromaX]) << shift);
+        
+        /* YCoCg to RGB conversion */
+        int16_t r_val = y_val + co_val - cg_val;
+        int16_t g_val = y_val + cg_val;
+        int16_t b_val = y_val - co_val - cg_val;
+        
+        uint8_t r = (uint8_t)clamp_byte(r_val);
+        uint8_t g = (uint8_t)clamp_byte(g_val);
+        uint8_t b = (uint8_t)clamp_byte(b_val);
+        uint8_t a = aplane[x];
+        
+        write_rgba_pixel(&dst[x * BYTES_PER_PIXEL], make_rgba(r, g, b, a));
+    }
+}
+
 /* NSCodec decoder for ClearCodec subcodec */
 static bool clear_decompress_nscodec(
     Stream* s, uint32_t dataByteCount,
@@ -653,32 +1002,13 @@ static bool clear_decompress_nscodec(
             cgplane = planeBuffers[2] + y * width;
         }
         
-        for (uint32_t x = 0; x < width; x++) {
-            if (nXDstRel + x >= nDstWidth) break;
-            
-            /* Read Y value directly */
-            int16_t y_val = (int16_t)yplane[x];
-            
-            /* For Co/Cg with chroma subsampling, use x >> 1 to get subsampled index */
-            uint32_t chromaX = chromaSubsamplingLevel ? (x >> 1) : x;
-            
-            /* Apply shift for color loss recovery - cast to int8_t for sign extension */
-            int16_t co_val = (int16_t)(int8_t)(((int16_t)coplane[chromaX]) << shift);
-            int16_t cg_val = (int16_t)(int8_t)(((int16_t)cgplane[chromaX]) << shift);
-            
-            /* YCoCg to RGB conversion */
-            int16_t r_val = y_val + co_val - cg_val;
-            int16_t g_val = y_val + cg_val;
-            int16_t b_val = y_val - co_val - cg_val;
-            
-            uint8_t r = (uint8_t)clamp_byte(r_val);
-            uint8_t g = (uint8_t)clamp_byte(g_val);
-            uint8_t b = (uint8_t)clamp_byte(b_val);
-            uint8_t a = aplane[x];
-            
-            uint8_t* dst = &pDstData[(nYDstRel + y) * nDstStep + (nXDstRel + x) * BYTES_PER_PIXEL];
-            write_rgba_pixel(dst, make_rgba(r, g, b, a));
-        }
+        uint32_t rowWidth = width;
+        if (nXDstRel >= nDstWidth) break;
+        if (nXDstRel + rowWidth > nDstWidth) rowWidth = nDstWidth - nXDstRel;
+        
+        uint8_t* dst = &pDstData[(nYDstRel + y) * nDstStep + nXDstRel * BYTES_PER_PIXEL];
+        nsc_ycocg_to_rgba_row(dst, yplane, coplane, cgplane, aplane,
+                              rowWidth, shift, chromaSubsamplingLevel != 0);
     }
     
     /* Cleanup */
@@ -697,7 +1027,7 @@ static bool clear_decompress_nscodec(
  * ============================================================================ */
 
 static bool clear_decompress_subcodecs_data(
-    ClearContext* ctx, Stream* s,
+    ClearScratch* scratch, Stream* s,
     uint32_t subcodecByteCount,
     uint32_t nWidth, uint32_t nHeight,
     uint8_t* pDstData, uint32_t nDstStep,
@@ -736,7 +1066,7 @@ static bool clear_decompress_subcodecs_data(
             return false;
         }
         
-        if (!resize_temp_buffer(ctx, width, height)) return false;
+        if (!resize_temp_buffer(scratch, width, height)) return false;
         
         switch (subcodecId) {
             case 0: {
@@ -795,16 +1125,19 @@ static bool clear_decompress_subcodecs_data(
 
 /* ============================================================================
  * Bands data decoder - matching FreeRDP exactly
+ *
+ * Runs in the ordered pass: updates the VBar caches and records each rendered
+ * VBar as a ClearVBarRun, which the tile job writes to the destination.
  * ============================================================================ */
 
 static bool clear_decompress_bands_data(
     ClearContext* ctx, Stream* s,
     uint32_t bandsByteCount,
-    uint32_t nWidth, uint32_t nHeight,
-    uint8_t* pDstData, uint32_t nDstStep,
-    uint32_t nXDst, uint32_t nYDst,
-    uint32_t nDstWidth, uint32_t nDstHeight)
+    ClearTileJob* job)
 {
+    const uint32_t nWidth = job->nWidth, nHeight = job->nHeight;
+    const uint32_t nXDst = job->nXDst, nYDst = job->nYDst;
+    const uint32_t nDstWidth = job->nDstWidth, nDstHeight = job->nDstHeight;
     uint32_t suboffset = 0;
     
     if (!stream_check(s, bandsByteCount)) return false;
@@ -845,8 +1178,9 @@ static bool clear_decompress_bands_data(
         for (uint32_t i = 0; i < vBarCount; i++) {
             ClearVBarEntry* vBarEntry = NULL;
             ClearVBarEntry* vBarShortEntry = NULL;
+            uint32_t* vBarPixels = NULL;
+            const uint32_t* vBarShortPixels = NULL;
             bool vBarUpdate = false;
-            const uint8_t* cpSrcPixel;
             
             if (!stream_check(s, 2)) return false;
             
@@ -855,7 +1189,7 @@ static bool clear_decompress_bands_data(
             
             uint32_t vBarHeight = (yEnd - yStart + 1);
             
-            if (vBarHeight > 52) {
+            if (vBarHeight > CLEARCODEC_VBAR_MAX_HEIGHT) {
                 return false;
             }
             
@@ -868,6 +1202,7 @@ static bool clear_decompress_bands_data(
                 }
                 
                 vBarShortEntry = &ctx->shortVBarStorage[vBarIndex];
+                vBarShortPixels = short_vbar_pixels(ctx, vBarIndex);
                 
                 if (!stream_check(s, 1)) return false;
                 vBarYOn = stream_read_u8(s);
@@ -892,7 +1227,7 @@ static bool clear_decompress_bands_data(
                 
                 vBarShortPixelCount = vBarYOff - vBarYOn;
                 
-                if (vBarShortPixelCount > 52) {
+                if (vBarShortPixelCount > CLEARCODEC_VBAR_MAX_HEIGHT) {
                     return false;
                 }
                 
@@ -903,17 +1238,18 @@ static bool clear_decompress_bands_data(
                 }
                 
                 vBarShortEntry = &ctx->shortVBarStorage[ctx->shortVBarStorageCursor];
-                vBarShortEntry->count = vBarShortPixelCount;
+                vBarShortEntry->count = (uint8_t)vBarShortPixelCount;
+                resize_vbar_entry(vBarShortEntry);
                 
-                if (!resize_vbar_entry(vBarShortEntry)) return false;
+                uint32_t* dstPixels = short_vbar_pixels(ctx, ctx->shortVBarStorageCursor);
+                vBarShortPixels = dstPixels;
                 
                 for (uint32_t y = 0; y < vBarShortPixelCount; y++) {
                     uint8_t b = stream_read_u8(s);
                     uint8_t g = stream_read_u8(s);
                     uint8_t r = stream_read_u8(s);
                     
-                    uint32_t color = make_rgba(r, g, b, 0xFF);
-                    write_rgba_pixel(&vBarShortEntry->pixels[y * BYTES_PER_PIXEL], color);
+                    dstPixels[y] = make_rgba(r, g, b, 0xFF);
                 }
                 
                 suboffset += vBarShortPixelCount * 3;
@@ -930,11 +1266,12 @@ static bool clear_decompress_bands_data(
                 }
                 
                 vBarEntry = &ctx->vBarStorage[vBarIndex];
+                vBarPixels = vbar_pixels(ctx, vBarIndex);
                 
-                /* If cache was reset, fill with dummy data */
+                /* If cache was reset, the zeroed slot serves as dummy data */
                 if (vBarEntry->size == 0) {
-                    vBarEntry->count = vBarHeight;
-                    if (!resize_vbar_entry(vBarEntry)) return false;
+                    vBarEntry->count = (uint8_t)vBarHeight;
+                    resize_vbar_entry(vBarEntry);
                 }
             }
             else {
@@ -947,12 +1284,12 @@ static bool clear_decompress_bands_data(
                 }
                 
                 vBarEntry = &ctx->vBarStorage[ctx->vBarStorageCursor];
+                vBarPixels = vbar_pixels(ctx, ctx->vBarStorageCursor);
                 vBarPixelCount = vBarHeight;
-                vBarEntry->count = vBarPixelCount;
-                
-                if (!resize_vbar_entry(vBarEntry)) return false;
+                vBarEntry->count = (uint8_t)vBarPixelCount;
+                resize_vbar_entry(vBarEntry);
                 
-                uint8_t* dstBuffer = vBarEntry->pixels;
+                uint32_t* dstPixel = vBarPixels;
                 
                 /* If y < vBarYOn, use colorBkg */
                 uint32_t y = 0;
@@ -963,8 +1300,7 @@ static bool clear_decompress_bands_data(
                 }
                 
                 for (uint32_t c = 0; c < count; c++) {
-                    write_rgba_pixel(dstBuffer, colorBkg);
-                    dstBuffer += BYTES_PER_PIXEL;
+                    *dstPixel++ = colorBkg;
                 }
                 
                 /* If y >= vBarYOn && y < vBarYOn + vBarShortPixelCount, use short pixels */
@@ -975,15 +1311,9 @@ static bool clear_decompress_bands_data(
                     count = (vBarPixelCount > y) ? (vBarPixelCount - y) : 0;
                 }
                 
-                if (count > 0 && vBarShortEntry && vBarShortEntry->pixels) {
-                    for (uint32_t c = 0; c < count; c++) {
-                        uint32_t srcOffset = c * BYTES_PER_PIXEL;
-                        if (srcOffset < vBarShortEntry->count * BYTES_PER_PIXEL) {
-                            uint32_t color = read_rgba_pixel(&vBarShortEntry->pixels[srcOffset]);
-                            write_rgba_pixel(dstBuffer, color);
-                        }
-                        dstBuffer += BYTES_PER_PIXEL;
-                    }
+                if (count > 0) {
+                    memcpy(dstPixel, vBarShortPixels, count * BYTES_PER_PIXEL);
+                    dstPixel += count;
                 }
                 
                 /* If y >= vBarYOn + vBarShortPixelCount, use colorBkg */
@@ -991,41 +1321,40 @@ static bool clear_decompress_bands_data(
                 count = (vBarPixelCount > y) ? (vBarPixelCount - y) : 0;
                 
                 for (uint32_t c = 0; c < count; c++) {
-                    write_rgba_pixel(dstBuffer, colorBkg);
-                    dstBuffer += BYTES_PER_PIXEL;
+                    *dstPixel++ = colorBkg;
                 }
                 
-                vBarEntry->count = vBarPixelCount;
                 ctx->vBarStorageCursor = (ctx->vBarStorageCursor + 1) % CLEARCODEC_VBAR_SIZE;
             }
             
             if (vBarEntry->count != vBarHeight) {
-                vBarEntry->count = vBarHeight;
-                if (!resize_vbar_entry(vBarEntry)) return false;
+                vBarEntry->count = (uint8_t)vBarHeight;
+                resize_vbar_entry(vBarEntry);
             }
             
-            /* Render vBar to destination */
+            /* Record vBar for rendering to destination */
             uint32_t nXDstRel = nXDst + xStart;
             uint32_t nYDstRel = nYDst + yStart;
-            cpSrcPixel = vBarEntry->pixels;
             
             if (i < nWidth) {
                 uint32_t count = vBarEntry->count;
                 if (count > nHeight) count = nHeight;
                 
                 if (nXDstRel + i >= nDstWidth) continue;
+                if (nYDstRel >= nDstHeight) continue;
+                if (count > nDstHeight - nYDstRel) count = nDstHeight - nYDstRel;
+                if (count == 0) continue;
                 
-                for (uint32_t y = 0; y < count; y++) {
-                    if (nYDstRel + y >= nDstHeight) break;
-                    
-                    uint8_t* pDstPixel = &pDstData[(nYDstRel + y) * nDstStep +
-                                                    (nXDstRel + i) * BYTES_PER_PIXEL];
-                    
-                    uint32_t color = read_rgba_pixel(cpSrcPixel);
-                    write_rgba_pixel(pDstPixel, color);
-                    
-                    cpSrcPixel += BYTES_PER_PIXEL;
+                if (!clear_push_vbar_run(ctx, nXDstRel + i, nYDstRel, vBarPixels, count)) {
+                    return false;
                 }
+                job->runCount++;
+                
+                /* Bands aren't bounded by the tile, so track what they touch */
+                if (nXDstRel + i < job->left) job->left = nXDstRel + i;
+                if (nXDstRel + i + 1 > job->right) job->right = nXDstRel + i + 1;
+                if (nYDstRel < job->top) job->top = nYDstRel;
+                if (nYDstRel + count > job->bottom) job->bottom = nYDstRel + count;
             }
         }
     }
@@ -1035,21 +1364,19 @@ static bool clear_decompress_bands_data(
 
 /* ============================================================================
  * Glyph data decoder - matching FreeRDP exactly
+ *
+ * Runs in the ordered pass: resolves the glyph cache slot; copying a cached
+ * glyph into the tile is left to the tile job.
  * ============================================================================ */
 
 static bool clear_decompress_glyph_data(
     ClearContext* ctx, Stream* s,
     uint32_t glyphFlags,
-    uint32_t nWidth, uint32_t nHeight,
-    uint8_t* pDstData, uint32_t nDstStep,
-    uint32_t nXDst, uint32_t nYDst,
-    uint32_t nDstWidth, uint32_t nDstHeight,
-    uint8_t** ppGlyphData)
+    ClearTileJob* job)
 {
+    const uint32_t nWidth = job->nWidth, nHeight = job->nHeight;
     uint16_t glyphIndex;
     
-    if (ppGlyphData) *ppGlyphData = NULL;
-    
     if ((glyphFlags & CLEARCODEC_FLAG_GLYPH_HIT) && 
         !(glyphFlags & CLEARCODEC_FLAG_GLYPH_INDEX)) {
         return false;
@@ -1075,54 +1402,28 @@ static bool clear_decompress_glyph_data(
         /* Cache hit - render glyph from cache */
         ClearGlyphEntry* glyphEntry = &ctx->glyphCache[glyphIndex];
         
+        uint32_t pixelCount = nWidth * nHeight;
+        
         /* Handle empty cache entry by filling with opaque black for robustness */
-        if (!glyphEntry->pixels) {
-            uint32_t pixelCount = nWidth * nHeight;
-            glyphEntry->count = pixelCount;
-            glyphEntry->size = pixelCount;
-            glyphEntry->pixels = (uint32_t*)malloc(pixelCount * BYTES_PER_PIXEL);
-            if (!glyphEntry->pixels) {
-                return false;
-            }
-            uint32_t opaqueBlack = make_rgba(0, 0, 0, 0xFF);
-            for (uint32_t i = 0; i < pixelCount; i++) {
-                glyphEntry->pixels[i] = opaqueBlack;
-            }
+        if (glyphEntry->size == 0) {
+            glyphEntry->count = 0;
         }
         
-        if ((nWidth * nHeight) > glyphEntry->count) {
+        uint32_t* glyphPixels = glyph_entry_reserve(ctx, glyphIndex, pixelCount);
+        if (!glyphPixels) {
+            return false;
+        }
+        
+        if (pixelCount > glyphEntry->count) {
             /* Expand cache if requested size is larger */
-            uint32_t pixelCount = nWidth * nHeight;
-            uint32_t* tmp = (uint32_t*)realloc(glyphEntry->pixels, pixelCount * BYTES_PER_PIXEL);
-            if (!tmp) {
-                return false;
-            }
             uint32_t opaqueBlack = make_rgba(0, 0, 0, 0xFF);
             for (uint32_t i = glyphEntry->count; i < pixelCount; i++) {
-                tmp[i] = opaqueBlack;
+                glyphPixels[i] = opaqueBlack;
             }
-            glyphEntry->pixels = tmp;
             glyphEntry->count = pixelCount;
-            glyphEntry->size = pixelCount;
-        }
-        
-        /* Copy cached glyph to destination */
-        uint32_t nSrcStep = nWidth * BYTES_PER_PIXEL;
-        uint8_t* glyphData = (uint8_t*)glyphEntry->pixels;
-        
-        for (uint32_t y = 0; y < nHeight; y++) {
-            if (nYDst + y >= nDstHeight) break;
-            
-            uint32_t copyWidth = nWidth;
-            if (nXDst + copyWidth > nDstWidth) {
-                copyWidth = nDstWidth - nXDst;
-            }
-            
-            uint8_t* dst = &pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL];
-            uint8_t* src = &glyphData[y * nSrcStep];
-            memcpy(dst, src, copyWidth * BYTES_PER_PIXEL);
         }
         
+        job->glyphHit = glyphPixels;
         return true;
     }
     
@@ -1131,54 +1432,81 @@ static bool clear_decompress_glyph_data(
         ClearGlyphEntry* glyphEntry = &ctx->glyphCache[glyphIndex];
         glyphEntry->count = nWidth * nHeight;
         
-        if (glyphEntry->count > glyphEntry->size) {
-            uint32_t* tmp = (uint32_t*)realloc(glyphEntry->pixels, 
-                                                glyphEntry->count * BYTES_PER_PIXEL);
-            if (!tmp) {
-                return false;
-            }
-            
-            glyphEntry->size = glyphEntry->count;
-            glyphEntry->pixels = tmp;
-        }
-        
-        if (!glyphEntry->pixels) {
+        uint32_t* glyphPixels = glyph_entry_reserve(ctx, glyphIndex, glyphEntry->count);
+        if (!glyphPixels) {
             return false;
         }
         
-        if (ppGlyphData) {
-            *ppGlyphData = (uint8_t*)glyphEntry->pixels;
-        }
-        
+        job->glyphData = (uint8_t*)glyphPixels;
         return true;
     }
     
     return true;
 }
 
+/**
+ * Glyph slot a tile refers to, read from its header without decoding
+ * @return Glyph index, or -1 if the tile doesn't use the glyph cache
+ */
+static int32_t clear_peek_glyph_index(const uint8_t* pSrcData, uint32_t SrcSize) {
+    if (SrcSize < 4 || !(pSrcData[0] & CLEARCODEC_FLAG_GLYPH_INDEX)) {
+        return -1;
+    }
+    
+    uint16_t glyphIndex = pSrcData[2] | ((uint16_t)pSrcData[3] << 8);
+    return glyphIndex < CLEARCODEC_GLYPH_CACHE_SIZE ? glyphIndex : -1;
+}
+
 /* ============================================================================
  * Main ClearCodec decompress function - matching FreeRDP exactly
  * ============================================================================ */
 
-static int32_t clear_decompress_internal(
-    ClearContext* ctx,
-    const uint8_t* pSrcData, uint32_t SrcSize,
+static void clear_init_tile_job(
+    ClearTileJob* job,
     uint32_t nWidth, uint32_t nHeight,
     uint8_t* pDstData, uint32_t nDstStep,
     uint32_t nXDst, uint32_t nYDst,
     uint32_t nDstWidth, uint32_t nDstHeight)
+{
+    memset(job, 0, sizeof(*job));
+    job->pDstData = pDstData;
+    job->nDstStep = nDstStep;
+    job->nXDst = nXDst;
+    job->nYDst = nYDst;
+    job->nWidth = nWidth;
+    job->nHeight = nHeight;
+    job->nDstWidth = nDstWidth;
+    job->nDstHeight = nDstHeight;
+    job->glyphIndex = -1;
+    
+    /* Tile rectangle clipped to the destination */
+    job->left = nXDst;
+    job->top = nYDst;
+    job->right = (nXDst < nDstWidth && nWidth < nDstWidth - nXDst) ? nXDst + nWidth : nDstWidth;
+    job->bottom = (nYDst < nDstHeight && nHeight < nDstHeight - nYDst) ? nYDst + nHeight : nDstHeight;
+}
+
+/**
+ * Ordered pass - must run for tiles in arrival order
+ * Fills in the job with everything the tile job needs; job->status is the
+ * result a sequential decode would return.
+ */
+static void clear_prepare_tile(ClearContext* ctx, ClearTileJob* job,
+                               const uint8_t* pSrcData, uint32_t SrcSize)
 {
     Stream stream = { pSrcData, SrcSize, 0 };
     Stream* s = &stream;
     uint8_t seqNumber, glyphFlags;
     uint32_t residualByteCount, bandsByteCount, subcodecByteCount;
-    uint8_t* glyphData = NULL;
     
-    if (!pDstData) return -1002;
-    if (nDstWidth == 0 || nDstHeight == 0) return -1022;
-    if (nWidth > 0xFFFF || nHeight > 0xFFFF) return -1004;
+    job->firstRun = ctx->vBarRunCount;
+    job->status = -1;
+    
+    if (!job->pDstData) { job->status = -1002; return; }
+    if (job->nDstWidth == 0 || job->nDstHeight == 0) { job->status = -1022; return; }
+    if (job->nWidth > 0xFFFF || job->nHeight > 0xFFFF) { job->status = -1004; return; }
     
-    if (!stream_check(s, 2)) return -1;
+    if (!stream_check(s, 2)) return;
     
     glyphFlags = stream_read_u8(s);
     seqNumber = stream_read_u8(s);
@@ -1201,9 +1529,8 @@ static int32_t clear_decompress_internal(
     }
     
     /* Decompress glyph data */
-    if (!clear_decompress_glyph_data(ctx, s, glyphFlags, nWidth, nHeight,
-            pDstData, nDstStep, nXDst, nYDst, nDstWidth, nDstHeight, &glyphData)) {
-        return -1;
+    if (!clear_decompress_glyph_data(ctx, s, glyphFlags, job)) {
+        return;
     }
     
     /* Read composition payload header */
@@ -1211,54 +1538,316 @@ static int32_t clear_decompress_internal(
         const uint32_t mask = CLEARCODEC_FLAG_GLYPH_HIT | CLEARCODEC_FLAG_GLYPH_INDEX;
         if ((glyphFlags & mask) == mask) {
             /* Glyph hit with no payload - success */
-            return 0;
+            job->status = 0;
         }
-        return -1;
+        job->glyphData = NULL;
+        return;
     }
     
     residualByteCount = stream_read_u32(s);
     bandsByteCount = stream_read_u32(s);
     subcodecByteCount = stream_read_u32(s);
     
-    /* Decompress residual data */
+    /* Validate residual data (decoded by the tile job) */
     if (residualByteCount > 0) {
-        if (!clear_decompress_residual_data(ctx, s, residualByteCount,
-                nWidth, nHeight, pDstData, nDstStep,
-                nXDst, nYDst, nDstWidth, nDstHeight)) {
-            return -1;
+        const uint8_t* residual = s->data + s->pos;
+        size_t residualSize = stream_remaining(s);
+        
+        if (!clear_decompress_residual_data(NULL, s, residualByteCount,
+                job->nWidth, job->nHeight, NULL, 0, 0, 0, 0, 0)) {
+            job->glyphData = NULL;
+            return;
         }
+        
+        job->residual = residual;
+        job->residualSize = residualSize;
+        job->residualByteCount = residualByteCount;
     }
     
     /* Decompress bands data */
     if (bandsByteCount > 0) {
-        if (!clear_decompress_bands_data(ctx, s, bandsByteCount,
+        if (!clear_decompress_bands_data(ctx, s, bandsByteCount, job)) {
+            job->glyphData = NULL;
+            return;
+        }
+    }
+    
+    /* Subcodecs are only parsed by the tile job, they come last in the payload */
+    if (subcodecByteCount > 0) {
+        job->subcodecs = s->data + s->pos;
+        job->subcodecsSize = stream_remaining(s);
+        job->subcodecByteCount = subcodecByteCount;
+    }
+    
+    job->status = 0;
+}
+
+/**
+ * Tile job - writes only the job's area and its own glyph slot,
+ * so jobs with disjoint areas and glyph slots can run concurrently
+ */
+static void clear_execute_tile(const ClearContext* ctx, ClearTileJob* job,
+                               ClearScratch* scratch)
+{
+    uint8_t* pDstData = job->pDstData;
+    const uint32_t nDstStep = job->nDstStep;
+    const uint32_t nXDst = job->nXDst, nYDst = job->nYDst;
+    const uint32_t nWidth = job->nWidth, nHeight = job->nHeight;
+    const uint32_t nDstWidth = job->nDstWidth, nDstHeight = job->nDstHeight;
+    
+    job->result = job->status;
+    
+    if (job->clearRect) {
+        for (uint32_t y = 0; y < nHeight; y++) {
+            memset(&pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL], 0,
+                   nWidth * BYTES_PER_PIXEL);
+        }
+    }
+    
+    /* Copy cached glyph to destination */
+    if (job->glyphHit) {
+        uint32_t nSrcStep = nWidth * BYTES_PER_PIXEL;
+        const uint8_t* glyphData = (const uint8_t*)job->glyphHit;
+        
+        for (uint32_t y = 0; y < nHeight; y++) {
+            if (nYDst + y >= nDstHeight) break;
+            
+            uint32_t copyWidth = nWidth;
+            if (nXDst + copyWidth > nDstWidth) {
+                copyWidth = nDstWidth - nXDst;
+            }
+            
+            uint8_t* dst = &pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL];
+            const uint8_t* src = &glyphData[y * nSrcStep];
+            memcpy(dst, src, copyWidth * BYTES_PER_PIXEL);
+        }
+    }
+    
+    /* Decompress residual data */
+    if (job->residual) {
+        Stream stream = { job->residual, job->residualSize, 0 };
+        
+        if (!clear_decompress_residual_data(scratch, &stream, job->residualByteCount,
                 nWidth, nHeight, pDstData, nDstStep,
                 nXDst, nYDst, nDstWidth, nDstHeight)) {
-            return -1;
+            job->result = -1;
+            return;
         }
     }
     
+    /* Render bands data */
+    for (uint32_t r = 0; r < job->runCount; r++) {
+        const ClearVBarRun* run = &ctx->vBarRuns[job->firstRun + r];
+        const uint32_t* vBarPixels = &ctx->vBarRunPixels[run->offset];
+        uint8_t* pDstPixel = &pDstData[run->y * nDstStep + run->x * BYTES_PER_PIXEL];
+        
+        for (uint32_t y = 0; y < run->count; y++) {
+            write_rgba_pixel(pDstPixel, vBarPixels[y]);
+            pDstPixel += nDstStep;
+        }
+    }
+    
+    if (job->status < 0) {
+        return;
+    }
+    
     /* Decompress subcodecs data */
-    if (subcodecByteCount > 0) {
-        if (!clear_decompress_subcodecs_data(ctx, s, subcodecByteCount,
+    if (job->subcodecs) {
+        Stream stream = { job->subcodecs, job->subcodecsSize, 0 };
+        
+        if (!clear_decompress_subcodecs_data(scratch, &stream, job->subcodecByteCount,
                 nWidth, nHeight, pDstData, nDstStep,
                 nXDst, nYDst, nDstWidth, nDstHeight)) {
-            return -1;
+            job->result = -1;
+            return;
         }
     }
     
     /* Store decoded data in glyph cache if glyph index was set */
-    if (glyphData) {
+    if (job->glyphData) {
         uint32_t nSrcStep = nWidth * BYTES_PER_PIXEL;
         
         for (uint32_t y = 0; y < nHeight; y++) {
-            uint8_t* dst = &glyphData[y * nSrcStep];
-            uint8_t* src = &pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL];
-            memcpy(dst, src, nWidth * BYTES_PER_PIXEL);
+            if (nYDst + y >= nDstHeight) break;
+            
+            uint32_t copyWidth = nWidth;
+            if (nXDst + copyWidth > nDstWidth) {
+                copyWidth = nDstWidth - nXDst;
+            }
+            
+            uint8_t* dst = &job->glyphData[y * nSrcStep];
+            const uint8_t* src = &pDstData[(nYDst + y) * nDstStep + nXDst * BYTES_PER_PIXEL];
+            memcpy(dst, src, copyWidth * BYTES_PER_PIXEL);
         }
     }
+}
+
+static void clear_reset_vbar_runs(ClearContext* ctx) {
+    ctx->vBarRunCount = 0;
+    ctx->vBarRunPixelCount = 0;
+}
+
+/**
+ * Decode a single tile on the calling thread
+ */
+static int32_t clear_decompress_internal(
+    ClearContext* ctx,
+    const uint8_t* pSrcData, uint32_t SrcSize,
+    uint32_t nWidth, uint32_t nHeight,
+    uint8_t* pDstData, uint32_t nDstStep,
+    uint32_t nXDst, uint32_t nYDst,
+    uint32_t nDstWidth, uint32_t nDstHeight)
+{
+    ClearTileJob job;
     
-    return 0;
+    clear_init_tile_job(&job, nWidth, nHeight, pDstData, nDstStep,
+                        nXDst, nYDst, nDstWidth, nDstHeight);
+    clear_prepare_tile(ctx, &job, pSrcData, SrcSize);
+    clear_execute_tile(ctx, &job, &ctx->scratch);
+    clear_reset_vbar_runs(ctx);
+    
+    return job.result;
+}
+
+/* ============================================================================
+ * Parallel tile decoding with pthreads
+ *
+ * Frame tiles are prepared in order and grouped into waves: a tile joins the
+ * current wave unless its area overlaps, or its glyph slot matches, a tile
+ * already in it. Tiles of a wave are decoded concurrently, waves run one
+ * after another, so the result matches decoding tile by tile.
+ * ============================================================================ */
+
+/* Work queue for parallel tile decoding */
+typedef struct {
+    ClearTileJob* jobs[CLEARCODEC_MAX_FRAME_TILES];
+    const ClearContext* ctx;
+    int count;
+    int next;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    int active_workers;
+} ClearWorkQueue;
+
+static ClearWorkQueue work_queue = {
+    .count = 0,
+    .next = 0,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER,
+    .active_workers = 0
+};
+
+static pthread_t worker_threads[MAX_WORKER_THREADS];
+static int workers_started = 0;
+
+/**
+ * Worker thread function - decodes tile jobs from the queue
+ */
+static void* tile_worker_thread(void* arg) {
+    (void)arg;
+    
+    /* Scratch buffer lives as long as the thread */
+    ClearScratch scratch = { NULL, 0 };
+    
+    while (1) {
+        pthread_mutex_lock(&work_queue.lock);
+        
+        while (work_queue.next >= work_queue.count) {
+            pthread_cond_wait(&work_queue.work_ready, &work_queue.lock);
+        }
+        
+        ClearTileJob* job = work_queue.jobs[work_queue.next++];
+        const ClearContext* ctx = work_queue.ctx;
+        work_queue.active_workers++;
+        
+        pthread_mutex_unlock(&work_queue.lock);
+        
+        clear_execute_tile(ctx, job, &scratch);
+        
+        /* Signal completion */
+        pthread_mutex_lock(&work_queue.lock);
+        work_queue.active_workers--;
+        if (work_queue.next >= work_queue.count && work_queue.active_workers == 0) {
+            pthread_cond_signal(&work_queue.work_done);
+        }
+        pthread_mutex_unlock(&work_queue.lock);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Start worker threads (once) - falls back to the calling thread if none start
+ */
+static void start_worker_threads(void) {
+    static bool attempted = false;
+    if (attempted) return;
+    attempted = true;
+    
+    for (int i = 0; i < MAX_WORKER_THREADS; i++) {
+        if (pthread_create(&worker_threads[workers_started], NULL, tile_worker_thread, NULL) == 0) {
+            workers_started++;
+        }
+    }
+}
+
+/**
+ * Decode a wave of independent tile jobs and wait for all of them
+ */
+static void clear_run_wave(ClearContext* ctx, ClearTileJob** wave, int count) {
+    if (count == 0) return;
+    
+    if (count > 1) {
+        start_worker_threads();
+    }
+    
+    if (count == 1 || workers_started == 0) {
+        for (int i = 0; i < count; i++) {
+            clear_execute_tile(ctx, wave[i], &ctx->scratch);
+        }
+        return;
+    }
+    
+    pthread_mutex_lock(&work_queue.lock);
+    
+    memcpy(work_queue.jobs, wave, count * sizeof(ClearTileJob*));
+    work_queue.ctx = ctx;
+    work_queue.count = count;
+    work_queue.next = 0;
+    pthread_cond_broadcast(&work_queue.work_ready);
+    
+    /* Wait for all work to complete */
+    while (work_queue.next < work_queue.count || work_queue.active_workers > 0) {
+        pthread_cond_wait(&work_queue.work_done, &work_queue.lock);
+    }
+    
+    work_queue.count = 0;
+    work_queue.next = 0;
+    
+    pthread_mutex_unlock(&work_queue.lock);
+}
+
+/**
+ * Check whether a prepared job can join the current wave
+ */
+static bool clear_job_independent(const ClearTileJob* job, ClearTileJob** wave, int count) {
+    for (int i = 0; i < count; i++) {
+        const ClearTileJob* other = wave[i];
+        
+        if (job->glyphIndex >= 0 && job->glyphIndex == other->glyphIndex) {
+            return false;
+        }
+        
+        if (job->pDstData == other->pDstData &&
+            job->left < other->right && other->left < job->right &&
+            job->top < other->bottom && other->top < job->bottom) {
+            return false;
+        }
+    }
+    
+    return true;
 }
 
 /* ============================================================================
@@ -1274,11 +1863,21 @@ ClearContext* clear_create(void) {
     if (!ctx) return NULL;
     
     /* Initialize with a reasonable temp buffer size */
-    if (!resize_temp_buffer(ctx, 512, 512)) {
+    if (!resize_temp_buffer(&ctx->scratch, 512, 512)) {
         free(ctx);
         return NULL;
     }
     
+    /* VBar slabs are fixed size (~10 MB total), allocate them once up front */
+    ctx->vBarPixels = (uint32_t*)calloc(
+        (size_t)CLEARCODEC_VBAR_SIZE * CLEARCODEC_VBAR_MAX_HEIGHT, BYTES_PER_PIXEL);
+    ctx->shortVBarPixels = (uint32_t*)calloc(
+        (size_t)CLEARCODEC_VBAR_SHORT_SIZE * CLEARCODEC_VBAR_MAX_HEIGHT, BYTES_PER_PIXEL);
+    if (!ctx->vBarPixels || !ctx->shortVBarPixels) {
+        clear_free(ctx);
+        return NULL;
+    }
+    
     return ctx;
 }
 
@@ -1292,7 +1891,17 @@ void clear_free(ClearContext* ctx) {
     clear_reset_vbar_storage(ctx, true);
     clear_reset_glyph_cache(ctx);
     
-    free(ctx->tempBuffer);
+    for (int i = 0; i < CLEARCODEC_MAX_SURFACES; i++) {
+        if (ctx->surfaces[i]) {
+            free(ctx->surfaces[i]->data);
+            free(ctx->surfaces[i]);
+        }
+    }
+    
+    free(ctx->inputBuffer);
+    free(ctx->scratch.tempBuffer);
+    free(ctx->vBarRuns);
+    free(ctx->vBarRunPixels);
     free(ctx);
 }
 
@@ -1361,3 +1970,262 @@ EMSCRIPTEN_KEEPALIVE
 void clear_free_output(uint8_t* buffer) {
     free(buffer);
 }
+
+/* ============================================================================
+ * Surface framebuffer API
+ *
+ * Tiles are decoded straight into a per-surface RGBA framebuffer that lives in
+ * WASM memory. JS copies the payload into the reusable input staging buffer,
+ * calls clear_decompress_surface(), and uploads only the tile rectangle from a
+ * view of the framebuffer - no per-tile allocations or intermediate copies.
+ * ============================================================================ */
+
+/**
+ * Get the input staging buffer, growing it to at least size bytes
+ * 
+ * @return Pointer valid until the next call with a larger size, NULL on OOM
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t* clear_get_input_buffer(ClearContext* ctx, uint32_t size) {
+    if (!ctx) return NULL;
+    
+    if (size > ctx->inputSize) {
+        /* Grow geometrically so bursts of slightly larger tiles don't realloc each time */
+        uint32_t newSize = ctx->inputSize ? ctx->inputSize : 4096;
+        while (newSize < size) newSize *= 2;
+        
+        uint8_t* tmp = (uint8_t*)realloc(ctx->inputBuffer, newSize);
+        if (!tmp) {
+            return NULL;
+        }
+        ctx->inputBuffer = tmp;
+        ctx->inputSize = newSize;
+    }
+    
+    return ctx->inputBuffer;
+}
+
+/**
+ * Register a surface as a ClearCodec decode target
+ * The framebuffer itself is allocated on the first tile decoded into it,
+ * so surfaces that never receive ClearCodec data cost nothing.
+ */
+EMSCRIPTEN_KEEPALIVE
+int clear_create_surface(ClearContext* ctx, uint16_t surfaceId,
+                         uint32_t width, uint32_t height) {
+    if (!ctx || surfaceId >= CLEARCODEC_MAX_SURFACES) return -1;
+    if (width == 0 || height == 0) return -1;
+    
+    /* Delete existing surface if present */
+    if (ctx->surfaces[surfaceId]) {
+        clear_delete_surface(ctx, surfaceId);
+    }
+    
+    ClearSurface* surface = (ClearSurface*)calloc(1, sizeof(ClearSurface));
+    if (!surface) return -1;
+    
+    surface->width = width;
+    surface->height = height;
+    
+    ctx->surfaces[surfaceId] = surface;
+    return 0;
+}
+
+/**
+ * Delete a surface and release its framebuffer
+ */
+EMSCRIPTEN_KEEPALIVE
+void clear_delete_surface(ClearContext* ctx, uint16_t surfaceId) {
+    if (!ctx || surfaceId >= CLEARCODEC_MAX_SURFACES) return;
+    
+    ClearSurface* surface = ctx->surfaces[surfaceId];
+    if (!surface) return;
+    
+    free(surface->data);
+    free(surface);
+    ctx->surfaces[surfaceId] = NULL;
+}
+
+/**
+ * Get a surface's RGBA framebuffer (stride = width * 4)
+ * Returns NULL if the surface doesn't exist or nothing was decoded into it yet.
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t* clear_get_surface_data(ClearContext* ctx, uint16_t surfaceId) {
+    if (!ctx || surfaceId >= CLEARCODEC_MAX_SURFACES) return NULL;
+    
+    ClearSurface* surface = ctx->surfaces[surfaceId];
+    if (!surface) return NULL;
+    
+    return surface->data;
+}
+
+/**
+ * Set up a job decoding into a surface framebuffer
+ * @return false if the surface doesn't exist or the tile lies outside it
+ */
+static bool clear_init_surface_job(
+    ClearContext* ctx, ClearTileJob* job, uint16_t surfaceId,
+    uint32_t nXDst, uint32_t nYDst,
+    uint32_t nWidth, uint32_t nHeight)
+{
+    if (surfaceId >= CLEARCODEC_MAX_SURFACES) return false;
+    
+    ClearSurface* surface = ctx->surfaces[surfaceId];
+    if (!surface) return false;
+    
+    /* Reject tiles outside the surface (like FreeRDP's is_within_surface) */
+    if (nWidth == 0 || nHeight == 0) return false;
+    if (nXDst > surface->width || nWidth > surface->width - nXDst) return false;
+    if (nYDst > surface->height || nHeight > surface->height - nYDst) return false;
+    
+    if (!surface->data) {
+        surface->data = (uint8_t*)calloc((size_t)surface->width * surface->height, BYTES_PER_PIXEL);
+        if (!surface->data) return false;
+    }
+    
+    clear_init_tile_job(job, nWidth, nHeight,
+                        surface->data, surface->width * BYTES_PER_PIXEL,
+                        nXDst, nYDst, surface->width, surface->height);
+    job->clearRect = true;
+    return true;
+}
+
+/**
+ * Decompress the staged input into a surface framebuffer at (nXDst, nYDst)
+ * 
+ * The tile rectangle is cleared first, so pixels not covered by residual,
+ * bands or subcodec data come out as transparent black - the same result as
+ * decoding into a freshly allocated tile buffer.
+ * 
+ * @param ctx         ClearCodec context
+ * @param surfaceId   Target surface (see clear_create_surface)
+ * @param srcSize     Bytes of compressed data in the input staging buffer
+ * @param nXDst       Tile X position on the surface
+ * @param nYDst       Tile Y position on the surface
+ * @param nWidth      Tile width
+ * @param nHeight     Tile height
+ * 
+ * @return 0 on success, negative on error
+ */
+EMSCRIPTEN_KEEPALIVE
+int32_t clear_decompress_surface(
+    ClearContext* ctx, uint16_t surfaceId, uint32_t srcSize,
+    uint32_t nXDst, uint32_t nYDst,
+    uint32_t nWidth, uint32_t nHeight)
+{
+    ClearTileJob job;
+    
+    if (!ctx) return -1;
+    if (!ctx->inputBuffer || srcSize > ctx->inputSize) return -1;
+    
+    if (!clear_init_surface_job(ctx, &job, surfaceId, nXDst, nYDst, nWidth, nHeight)) {
+        return -1;
+    }
+    
+    clear_prepare_tile(ctx, &job, ctx->inputBuffer, srcSize);
+    clear_execute_tile(ctx, &job, &ctx->scratch);
+    clear_reset_vbar_runs(ctx);
+    
+    return job.result;
+}
+
+/* ============================================================================
+ * Frame-level batch API
+ *
+ * One call per batch of tiles instead of several per tile: JS appends each
+ * tile's payload to the input staging buffer and writes its descriptor into
+ * the array from clear_get_frame_tiles(), calls clear_decode_frame() once,
+ * then reads the packed results from clear_get_dirty_rects(). Both arrays live
+ * in the context, so their addresses never change. Tiles must be decoded
+ * before anything else draws to, or reads from, their surfaces.
+ * ============================================================================ */
+
+/**
+ * Get the tile descriptor array (CLEARCODEC_MAX_FRAME_TILES entries)
+ */
+EMSCRIPTEN_KEEPALIVE
+ClearFrameTile* clear_get_frame_tiles(ClearContext* ctx) {
+    return ctx ? ctx->frameTiles : NULL;
+}
+
+/**
+ * Get the dirty rect array filled by clear_decode_frame() (one entry per tile)
+ */
+EMSCRIPTEN_KEEPALIVE
+ClearDirtyRect* clear_get_dirty_rects(ClearContext* ctx) {
+    return ctx ? ctx->dirtyRects : NULL;
+}
+
+/**
+ * Decode the first tileCount frame tiles into their surfaces
+ * 
+ * @return Number of tiles decoded (one dirty rect each), -1 on bad arguments
+ */
+EMSCRIPTEN_KEEPALIVE
+int32_t clear_decode_frame(ClearContext* ctx, uint32_t tileCount) {
+    if (!ctx || tileCount > CLEARCODEC_MAX_FRAME_TILES) return -1;
+    
+    ClearTileJob* wave[CLEARCODEC_MAX_FRAME_TILES];
+    int waveCount = 0;
+    
+    for (uint32_t i = 0; i < tileCount; i++) {
+        const ClearFrameTile* tile = &ctx->frameTiles[i];
+        ClearTileJob* job = &ctx->jobs[i];
+        
+        if (!ctx->inputBuffer || tile->surfaceId > 0xFFFF ||
+            tile->srcOffset > ctx->inputSize ||
+            tile->srcSize > ctx->inputSize - tile->srcOffset ||
+            !clear_init_surface_job(ctx, job, (uint16_t)tile->surfaceId,
+                                    tile->x, tile->y, tile->width, tile->height)) {
+            memset(job, 0, sizeof(*job));
+            job->result = -1;
+            continue;
+        }
+        
+        const uint8_t* pSrcData = ctx->inputBuffer + tile->srcOffset;
+        job->glyphIndex = clear_peek_glyph_index(pSrcData, tile->srcSize);
+        
+        /* The ordered pass rewrites the glyph slot, so earlier users must finish first */
+        if (job->glyphIndex >= 0) {
+            for (int w = 0; w < waveCount; w++) {
+                if (wave[w]->glyphIndex == job->glyphIndex) {
+                    clear_run_wave(ctx, wave, waveCount);
+                    waveCount = 0;
+                    break;
+                }
+            }
+        }
+        
+        clear_prepare_tile(ctx, job, pSrcData, tile->srcSize);
+        
+        if (!clear_job_independent(job, wave, waveCount)) {
+            clear_run_wave(ctx, wave, waveCount);
+            waveCount = 0;
+        }
+        wave[waveCount++] = job;
+    }
+    
+    clear_run_wave(ctx, wave, waveCount);
+    clear_reset_vbar_runs(ctx);
+    
+    for (uint32_t i = 0; i < tileCount; i++) {
+        const ClearTileJob* job = &ctx->jobs[i];
+        ClearDirtyRect* rect = &ctx->dirtyRects[i];
+        
+        rect->surfaceId = ctx->frameTiles[i].surfaceId;
+        rect->result = job->result;
+        
+        if (job->result < 0 || job->right <= job->left || job->bottom <= job->top) {
+            rect->x = rect->y = rect->width = rect->height = 0;
+            continue;
+        }
+        
+        rect->x = job->left;
+        rect->y = job->top;
+        rect->width = job->right - job->left;
+        rect->height = job->bottom - job->top;
+    }
+    
+    return (int32_t)tileCount;
+}
@@ -0,0 +1,492 @@
+/**
+ * WebGL2 Compositor Backend for the GFX Worker
+ *
+ * Optional replacement for the 2D canvas surface operations:
+ * - Surfaces and cache entries are RGBA8 textures (surfaces also get an FBO)
+ * - Solid fills, surface/cache blits and output compositing are queued as
+ *   quads and drawn with one draw call per (target, source) pair
+ * - Decoded tiles are uploaded with texSubImage2D, straight from WASM memory
+ * - Self-overlapping SurfaceToSurface goes through a scratch texture on the
+ *   GPU, no getImageData readback
+ *
+ * All coordinates are in pixels with a top-left origin. Texture row 0 is the
+ * top row of a surface; only the default framebuffer (the output canvas) is
+ * flipped when drawing.
+ */
+
+const VERTEX_SHADER = `#version 300 es
+in vec2 a_pos;
+in vec2 a_tex;
+in vec4 a_color;
+uniform vec2 u_targetSize;
+uniform float u_flipY;
+out vec2 v_tex;
+out vec4 v_color;
+void main() {
+    vec2 clip = a_pos / u_targetSize * 2.0 - 1.0;
+    gl_Position = vec4(clip.x, clip.y * u_flipY, 0.0, 1.0);
+    v_tex = a_tex;
+    v_color = a_color;
+}`;
+
+// Quads with a_color.a == 0 sample the source texture 1:1 (texelFetch),
+// others are solid fills - so fills join any batch with the same target.
+const FRAGMENT_SHADER = `#version 300 es
+precision highp float;
+uniform sampler2D u_source;
+in vec2 v_tex;
+in vec4 v_color;
+out vec4 o_color;
+void main() {
+    if (v_color.a > 0.0) {
+        o_color = vec4(v_color.rgb, 1.0);
+    } else {
+        o_color = texelFetch(u_source, ivec2(v_tex), 0);
+    }
+}`;
+
+/** Floats per vertex: pos(2) + tex(2) + color(4) */
+const VERTEX_FLOATS = 8;
+
+/** Vertices per quad (two triangles, no index buffer) */
+const QUAD_VERTICES = 6;
+
+/** Initial quad capacity of the batch buffer (grows on demand) */
+const INITIAL_QUAD_CAPACITY = 1024;
+
+export class WebGLCompositor {
+    /**
+     * Create a compositor on the output canvas
+     * @param {OffscreenCanvas} canvas - Output canvas (no context created yet)
+     * @returns {WebGLCompositor|null} null if WebGL2 is unavailable
+     */
+    static create(canvas) {
+        let gl = null;
+        try {
+            gl = canvas.getContext('webgl2', {
+                alpha: false,
+                antialias: false,
+                depth: false,
+                stencil: false,
+                premultipliedAlpha: false,
+                // Only updated surfaces are composited per frame
+                preserveDrawingBuffer: true,
+            });
+        } catch (err) {
+            console.warn('[GFX WebGL] getContext failed:', err);
+        }
+        if (!gl) return null;
+
+        try {
+            return new WebGLCompositor(canvas, gl);
+        } catch (err) {
+            console.warn('[GFX WebGL] Initialization failed:', err);
+            return null;
+        }
+    }
+
+    /**
+     * @param {OffscreenCanvas} canvas
+     * @param {WebGL2RenderingContext} gl
+     */
+    constructor(canvas, gl) {
+        this.canvas = canvas;
+        this.gl = gl;
+        this.contextLost = false;
+        /** @type {Function|null} Called once the context is back; every surface and cache handle is stale */
+        this.onContextRestored = null;
+
+        this._initResources();
+
+        canvas.addEventListener('webglcontextlost', (event) => {
+            // preventDefault lets the browser restore the context later
+            event.preventDefault();
+            this.contextLost = true;
+            console.error('[GFX WebGL] Context lost - waiting for restore');
+        });
+
+        canvas.addEventListener('webglcontextrestored', () => {
+            try {
+                this._initResources();
+            } catch (err) {
+                console.error('[GFX WebGL] Re-initialization after context restore failed:', err);
+                return;
+            }
+            this.contextLost = false;
+            this.resize(canvas.width, canvas.height);
+            console.warn('[GFX WebGL] Context restored');
+            if (this.onContextRestored) {
+                this.onContextRestored();
+            }
+        });
+
+        this.resize(canvas.width, canvas.height);
+    }
+
+    // ========================================================================
+    // Resources
+    // ========================================================================
+
+    /**
+     * Create the program, batch buffers and helper textures. Runs again after
+     * a context restore, when every previous GL object is gone.
+     */
+    _initResources() {
+        const gl = this.gl;
+
+        this.program = this._createProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+        this.uTargetSize = gl.getUniformLocation(this.program, 'u_targetSize');
+        this.uFlipY = gl.getUniformLocation(this.program, 'u_flipY');
+        this.uSource = gl.getUniformLocation(this.program, 'u_source');
+
+        // Batch state: quads for one target, sampling at most one source
+        this.vertices = new Float32Array(INITIAL_QUAD_CAPACITY * QUAD_VERTICES * VERTEX_FLOATS);
+        this.quadCount = 0;
+        this.batchTarget = undefined;
+        this.batchSource = null;
+        this.vbo = gl.createBuffer();
+        this.vao = gl.createVertexArray();
+
+        gl.bindVertexArray(this.vao);
+        gl.bindBuffer(gl.ARRAY_BUFFER, this.vbo);
+        gl.bufferData(gl.ARRAY_BUFFER, this.vertices.byteLength, gl.DYNAMIC_DRAW);
+        this.vboBytes = this.vertices.byteLength;
+
+        const stride = VERTEX_FLOATS * 4;
+        const aPos = gl.getAttribLocation(this.program, 'a_pos');
+        const aTex = gl.getAttribLocation(this.program, 'a_tex');
+        const aColor = gl.getAttribLocation(this.program, 'a_color');
+        gl.enableVertexAttribArray(aPos);
+        gl.vertexAttribPointer(aPos, 2, gl.FLOAT, false, stride, 0);
+        gl.enableVertexAttribArray(aTex);
+        gl.vertexAttribPointer(aTex, 2, gl.FLOAT, false, stride, 8);
+        gl.enableVertexAttribArray(aColor);
+        gl.vertexAttribPointer(aColor, 4, gl.FLOAT, false, stride, 16);
+
+        gl.useProgram(this.program);
+        gl.uniform1i(this.uSource, 0);
+        gl.disable(gl.BLEND);
+        gl.disable(gl.DEPTH_TEST);
+        gl.pixelStorei(gl.UNPACK_ALIGNMENT, 1);
+
+        // Bound for fill-only batches (sampler must be complete)
+        this.dummyTexture = this._createTexture(1, 1);
+
+        // Scratch texture for self-overlapping copies (grows on demand)
+        this.scratch = null;
+    }
+
+    _createProgram(vsSource, fsSource) {
+        const gl = this.gl;
+        const compile = (type, source) => {
+            const shader = gl.createShader(type);
+            gl.shaderSource(shader, source);
+            gl.compileShader(shader);
+            if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) {
+                throw new Error(gl.getShaderInfoLog(shader));
+            }
+            return shader;
+        };
+
+        const program = gl.createProgram();
+        gl.attachShader(program, compile(gl.VERTEX_SHADER, vsSource));
+        gl.attachShader(program, compile(gl.FRAGMENT_SHADER, fsSource));
+        gl.linkProgram(program);
+        if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
+            throw new Error(gl.getProgramInfoLog(program));
+        }
+        return program;
+    }
+
+    _createTexture(width, height) {
+        const gl = this.gl;
+        const texture = gl.createTexture();
+        gl.bindTexture(gl.TEXTURE_2D, texture);
+        gl.texStorage2D(gl.TEXTURE_2D, 1, gl.RGBA8, width, height);
+        gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST);
+        gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MAG_FILTER, gl.NEAREST);
+        gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_S, gl.CLAMP_TO_EDGE);
+        gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_WRAP_T, gl.CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    _createFramebuffer(texture) {
+        const gl = this.gl;
+        const fbo = gl.createFramebuffer();
+        gl.bindFramebuffer(gl.FRAMEBUFFER, fbo);
+        gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0);
+        return fbo;
+    }
+
+    /**
+     * Create a surface texture, cleared to opaque black
+     * @returns {{texture: WebGLTexture, fbo: WebGLFramebuffer, width: number, height: number}}
+     */
+    createSurface(width, height) {
+        const gl = this.gl;
+        this.flush();
+
+        const texture = this._createTexture(width, height);
+        const fbo = this._createFramebuffer(texture);
+        gl.viewport(0, 0, width, height);
+        gl.clearColor(0, 0, 0, 1);
+        gl.clear(gl.COLOR_BUFFER_BIT);
+
+        return { texture, fbo, width, height };
+    }
+
+    /**
+     * Release a surface (or cache entry) created by this compositor
+     */
+    deleteSurface(handle) {
+        if (!handle) return;
+        this.flush();
+        if (handle.fbo) this.gl.deleteFramebuffer(handle.fbo);
+        this.gl.deleteTexture(handle.texture);
+        handle.texture = null;
+        handle.fbo = null;
+    }
+
+    /**
+     * Copy a surface rect into a new texture (SurfaceToCache)
+     * @returns {{texture: WebGLTexture, width: number, height: number}}
+     */
+    createCacheEntry(src, x, y, w, h) {
+        const gl = this.gl;
+        this.flush();
+
+        const texture = this._createTexture(w, h);
+        gl.bindFramebuffer(gl.READ_FRAMEBUFFER, src.fbo);
+        gl.copyTexSubImage2D(gl.TEXTURE_2D, 0, 0, 0, x, y, w, h);
+
+        return { texture, fbo: null, width: w, height: h };
+    }
+
+    // ========================================================================
+    // Batched drawing
+    // ========================================================================
+
+    /**
+     * Make the open batch draw into target sampling source, flushing if needed.
+     * @param {Object|null} target - Surface handle, or null for the output canvas
+     * @param {Object|null} source - Texture owner sampled by the quad, null for fills
+     */
+    _beginQuad(target, source) {
+        if (this.batchTarget !== target ||
+            (source && this.batchSource && this.batchSource !== source)) {
+            this.flush();
+            this.batchTarget = target;
+        }
+        if (source) {
+            this.batchSource = source;
+        }
+
+        if ((this.quadCount + 1) * QUAD_VERTICES * VERTEX_FLOATS > this.vertices.length) {
+            const grown = new Float32Array(this.vertices.length * 2);
+            grown.set(this.vertices);
+            this.vertices = grown;
+        }
+    }
+
+    _pushQuad(dx, dy, w, h, sx, sy, r, g, b, a) {
+        let i = this.quadCount * QUAD_VERTICES * VERTEX_FLOATS;
+        i = this._pushVertex(i, dx, dy, sx, sy, r, g, b, a);
+        i = this._pushVertex(i, dx + w, dy, sx + w, sy, r, g, b, a);
+        i = this._pushVertex(i, dx, dy + h, sx, sy + h, r, g, b, a);
+        i = this._pushVertex(i, dx, dy + h, sx, sy + h, r, g, b, a);
+        i = this._pushVertex(i, dx + w, dy, sx + w, sy, r, g, b, a);
+        this._pushVertex(i, dx + w, dy + h, sx + w, sy + h, r, g, b, a);
+        this.quadCount++;
+    }
+
+    _pushVertex(i, x, y, u, v, r, g, b, a) {
+        const out = this.vertices;
+        out[i] = x;
+        out[i + 1] = y;
+        out[i + 2] = u;
+        out[i + 3] = v;
+        out[i + 4] = r;
+        out[i + 5] = g;
+        out[i + 6] = b;
+        out[i + 7] = a;
+        return i + VERTEX_FLOATS;
+    }
+
+    /**
+     * Solid fill (SolidFill PDU); color components are 0-255
+     */
+    fillRect(dst, x, y, w, h, r, g, b) {
+        this._beginQuad(dst, null);
+        this._pushQuad(x, y, w, h, 0, 0, r / 255, g / 255, b / 255, 1);
+    }
+
+    /**
+     * Copy a rect between textures, to one or more destination points.
+     * Self-copies (possibly overlapping) go through the scratch texture so the
+     * draw never samples its own target; the source is read once for all points.
+     * @param {Array<{x: number, y: number}>} dstPoints
+     */
+    copyRect(src, sx, sy, w, h, dst, dstPoints) {
+        if (src === dst) {
+            const gl = this.gl;
+            this.flush();
+            this._ensureScratch(w, h);
+            gl.bindFramebuffer(gl.READ_FRAMEBUFFER, src.fbo);
+            gl.bindTexture(gl.TEXTURE_2D, this.scratch.texture);
+            gl.copyTexSubImage2D(gl.TEXTURE_2D, 0, 0, 0, sx, sy, w, h);
+            src = this.scratch;
+            sx = 0;
+            sy = 0;
+        }
+
+        for (const point of dstPoints) {
+            this._beginQuad(dst, src);
+            this._pushQuad(point.x, point.y, w, h, sx, sy, 0, 0, 0, 0);
+        }
+    }
+
+    _ensureScratch(w, h) {
+        if (this.scratch && this.scratch.width >= w && this.scratch.height >= h) {
+            return;
+        }
+        const width = Math.max(w, this.scratch ? this.scratch.width : 0);
+        const height = Math.max(h, this.scratch ? this.scratch.height : 0);
+        if (this.scratch) {
+            this.gl.deleteTexture(this.scratch.texture);
+        }
+        this.scratch = { texture: this._createTexture(width, height), fbo: null, width, height };
+    }
+
+    /**
+     * Draw a whole texture (cache entry or surface) into a target
+     * @param {Object|null} dst - Surface handle, or null for the output canvas
+     */
+    drawTexture(src, dst, dx, dy) {
+        this._beginQuad(dst, src);
+        this._pushQuad(dx, dy, src.width, src.height, 0, 0, 0, 0, 0, 0);
+    }
+
+    /**
+     * Submit the open batch as one draw call
+     */
+    flush() {
+        if (this.quadCount === 0) {
+            this.batchTarget = undefined;
+            this.batchSource = null;
+            return;
+        }
+
+        const gl = this.gl;
+        const target = this.batchTarget;
+        const width = target ? target.width : this.canvas.width;
+        const height = target ? target.height : this.canvas.height;
+
+        gl.bindFramebuffer(gl.FRAMEBUFFER, target ? target.fbo : null);
+        gl.viewport(0, 0, width, height);
+        gl.useProgram(this.program);
+        gl.uniform2f(this.uTargetSize, width, height);
+        gl.uniform1f(this.uFlipY, target ? 1 : -1);
+        gl.activeTexture(gl.TEXTURE0);
+        gl.bindTexture(gl.TEXTURE_2D, this.batchSource ? this.batchSource.texture : this.dummyTexture);
+
+        const floats = this.quadCount * QUAD_VERTICES * VERTEX_FLOATS;
+        gl.bindVertexArray(this.vao);
+        gl.bindBuffer(gl.ARRAY_BUFFER, this.vbo);
+        if (this.vertices.byteLength > this.vboBytes) {
+            gl.bufferData(gl.ARRAY_BUFFER, this.vertices.byteLength, gl.DYNAMIC_DRAW);
+            this.vboBytes = this.vertices.byteLength;
+        }
+        gl.bufferSubData(gl.ARRAY_BUFFER, 0, this.vertices, 0, floats);
+        gl.drawArrays(gl.TRIANGLES, 0, this.quadCount * QUAD_VERTICES);
+
+        this.quadCount = 0;
+        this.batchTarget = undefined;
+        this.batchSource = null;
+    }
+
+    // ========================================================================
+    // Uploads
+    // ========================================================================
+
+    /**
+     * Upload RGBA pixels from a byte array into a surface rect.
+     * rowLength/skipX/skipY select a sub-rect of a larger image, so decoder
+     * output in WASM memory is uploaded without an intermediate copy.
+     * @param {Uint8Array} pixels - Source bytes (may be a view of WASM memory)
+     * @param {number} offset - Byte offset of the source image in pixels
+     * @param {number} rowLength - Source image width in pixels (0 = w)
+     */
+    upload(dst, x, y, w, h, pixels, offset = 0, rowLength = 0, skipX = 0, skipY = 0) {
+        const gl = this.gl;
+
+        // texSubImage2D fails outright past the texture edge; putImageData clips
+        if (!rowLength) rowLength = w;
+        w = Math.min(w, dst.width - x);
+        h = Math.min(h, dst.height - y);
+        if (w <= 0 || h <= 0) return;
+
+        this.flush();
+
+        gl.bindTexture(gl.TEXTURE_2D, dst.texture);
+        gl.pixelStorei(gl.UNPACK_ROW_LENGTH, rowLength);
+        gl.pixelStorei(gl.UNPACK_SKIP_PIXELS, skipX);
+        gl.pixelStorei(gl.UNPACK_SKIP_ROWS, skipY);
+        gl.texSubImage2D(gl.TEXTURE_2D, 0, x, y, w, h, gl.RGBA, gl.UNSIGNED_BYTE, pixels, offset);
+        gl.pixelStorei(gl.UNPACK_ROW_LENGTH, 0);
+        gl.pixelStorei(gl.UNPACK_SKIP_PIXELS, 0);
+        gl.pixelStorei(gl.UNPACK_SKIP_ROWS, 0);
+    }
+
+    /**
+     * Upload a rect of an image source (ImageBitmap, VideoFrame) into a surface
+     * @param {number} sx - Source x of the rect within the image
+     * @param {number} sy - Source y of the rect within the image
+     */
+    uploadImage(dst, x, y, w, h, image, sx = 0, sy = 0) {
+        const gl = this.gl;
+        w = Math.min(w, dst.width - x);
+        h = Math.min(h, dst.height - y);
+        if (w <= 0 || h <= 0) return;
+
+        this.flush();
+
+        gl.bindTexture(gl.TEXTURE_2D, dst.texture);
+        gl.pixelStorei(gl.UNPACK_SKIP_PIXELS, sx);
+        gl.pixelStorei(gl.UNPACK_SKIP_ROWS, sy);
+        gl.texSubImage2D(gl.TEXTURE_2D, 0, x, y, w, h, gl.RGBA, gl.UNSIGNED_BYTE, image);
+        gl.pixelStorei(gl.UNPACK_SKIP_PIXELS, 0);
+        gl.pixelStorei(gl.UNPACK_SKIP_ROWS, 0);
+    }
+
+    // ========================================================================
+    // Output
+    // ========================================================================
+
+    /**
+     * Draw a surface (or a rect of it) onto the output canvas at its mapped position
+     */
+    composite(surface, outputX, outputY, x = 0, y = 0, w = surface.width, h = surface.height) {
+        this._beginQuad(null, surface);
+        this._pushQuad(outputX + x, outputY + y, w, h, x, y, 0, 0, 0, 0);
+    }
+
+    /**
+     * Submit everything queued for this frame
+     */
+    present() {
+        this.flush();
+    }
+
+    /**
+     * Clear the output canvas to black (after init/resize)
+     */
+    resize(width, height) {
+        const gl = this.gl;
+        this.flush();
+
+        gl.bindFramebuffer(gl.FRAMEBUFFER, null);
+        gl.viewport(0, 0, width, height);
+        gl.clearColor(0, 0, 0, 1);
+        gl.clear(gl.COLOR_BUFFER_BIT);
+    }
+}
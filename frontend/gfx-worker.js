@@ -5,7 +5,7 @@
  * - Progressive tile decoding via WASM (RFX Progressive codec)
  * - H.264 decoding via VideoDecoder API (AVC420/AVC444)
  * - WebP tile decoding via createImageBitmap
- * - Surface management and composition
+ * - Surface management and composition (2D canvas or optional WebGL2 backend)
  * - Frame lifecycle and acknowledgment
  * 
  * IMPORTANT: Strict message ordering is guaranteed by processing messages
@@ -17,9 +17,10 @@ const BUILD_VERSION = '__BUILD_TIME__';
 console.log(`[GFX Worker] ===== BUILD ${BUILD_VERSION} =====`);
 
 import {
-    Magic, matchMagic, parseMessage,
+    Magic, matchMagic, parseMessage, splitBatchPayload, BATCH_FLAG_DEFLATE,
     readU16LE, readU32LE, buildFrameAck
 } from './wire-format.js';
+import { WebGLCompositor } from './gfx-webgl.js';
 
 // ============================================================================
 // Message Queue for Strict Ordering
@@ -53,6 +54,92 @@ async function enqueueMessage(msg) {
     isProcessing = false;
 }
 
+// ============================================================================
+// Pipelined tile decodes
+// ============================================================================
+//
+// WebP tiles start decoding (createImageBitmap) as soon as they arrive, ahead
+// of the in-order queue, so decodes of a frame run concurrently and overlap
+// with compositing of earlier frames. Results are still applied in message
+// order when the queue reaches each tile. Uncompressed frame containers
+// (BTCH) are split once here so the tiles inside them are prefetched too.
+
+/** Max tile decodes in flight ahead of the queue */
+const MAX_PREFETCH_DECODES = 8;
+
+/** @type {number} Tile decodes currently in flight */
+let prefetchInFlight = 0;
+
+/** @type {Array<Object>} Decode jobs waiting for a slot, in arrival order */
+const prefetchWaiting = [];
+
+/**
+ * Start decoding a binary message early if it is a WebP tile.
+ * Attaches the parsed message and decode job to the queue entry.
+ */
+function prefetchBinaryMessage(entry) {
+    prefetchBytes(new Uint8Array(entry.data), entry);
+}
+
+/**
+ * Prefetch one message; for a frame container, each of its sub-messages.
+ * Sub-entries ({ data, parsed, decodeJob }) are kept on entry.batch.
+ */
+function prefetchBytes(bytes, entry) {
+    if (matchMagic(bytes, Magic.BTCH)) {
+        const msg = parseMessage(bytes);
+        if (!msg || (msg.flags & BATCH_FLAG_DEFLATE)) return;
+        const messages = splitBatchPayload(msg.payload, msg.count);
+        if (!messages) return;
+        
+        entry.parsed = msg;
+        entry.batch = messages.map((data) => {
+            const sub = { data };
+            prefetchBytes(data, sub);
+            return sub;
+        });
+        return;
+    }
+    if (!matchMagic(bytes, Magic.WEBP)) return;
+    
+    const msg = parseMessage(bytes);
+    if (!msg || msg.type !== 'tile' || msg.codec !== 'webp') return;
+    
+    const job = { payload: msg.payload, bitmap: null };
+    entry.parsed = msg;
+    entry.decodeJob = job;
+    
+    if (prefetchInFlight < MAX_PREFETCH_DECODES) {
+        startTileDecode(job);
+    } else {
+        prefetchWaiting.push(job);
+    }
+}
+
+function startTileDecode(job) {
+    prefetchInFlight++;
+    job.bitmap = createImageBitmap(new Blob([job.payload], { type: 'image/webp' }));
+    job.bitmap.catch(() => {}).finally(() => {
+        prefetchInFlight--;
+        while (prefetchInFlight < MAX_PREFETCH_DECODES && prefetchWaiting.length > 0) {
+            startTileDecode(prefetchWaiting.shift());
+        }
+    });
+}
+
+/**
+ * Get the decoded bitmap of a job, starting it now if it is still waiting
+ * @returns {Promise<ImageBitmap>}
+ */
+function takeTileDecode(job) {
+    if (!job.bitmap) {
+        const idx = prefetchWaiting.indexOf(job);
+        if (idx !== -1) prefetchWaiting.splice(idx, 1);
+        startTileDecode(job);
+    }
+    return job.bitmap;
+}
+
 // ============================================================================
 // State
 // ============================================================================
@@ -72,21 +159,83 @@ let clearCtx = null;
 /** @type {boolean} Whether ClearCodec WASM is ready */
 let clearWasmReady = false;
 
+/** @type {ImageData|null} Upload scratch for ClearCodec rects when WASM memory is shared */
+let clearUploadImageData = null;
+
+/** @type {ImageData|null} Upload scratch for one 64x64 Progressive tile */
+let progTileImageData = null;
+
+/**
+ * Consecutive SurfaceToSurface messages with the same source rect, applied
+ * together (one source read, one draw per destination point)
+ * @type {{src: Object, dst: Object, x: number, y: number, w: number, h: number,
+ *         points: Array<{x: number, y: number}>, sourceDirty: boolean}|null}
+ */
+let pendingSurfaceCopy = null;
+
+/** @type {{canvas: OffscreenCanvas, ctx: OffscreenCanvasRenderingContext2D}|null} Scratch for self-blits */
+let surfaceCopyScratch = null;
+
+/**
+ * Frame-level decode batches, one per WASM decoder.
+ * Consecutive tiles of a codec are staged in WASM memory (payloads plus packed
+ * descriptors) and decoded with a single call; any other message flushes first.
+ */
+const clearBatch = { count: 0, bytes: 0, capacity: 0, inputPtr: 0 };
+const progBatch = { count: 0, bytes: 0, capacity: 0, inputPtr: 0 };
+
+/** @type {number} WASM address of the ClearFrameTile descriptor array */
+let clearFrameTilesPtr = 0;
+
+/** @type {number} WASM address of the ClearDirtyRect result array */
+let clearDirtyRectsPtr = 0;
+
+/** @type {number} WASM address of the ProgFrameMessage descriptor array */
+let progFrameMessagesPtr = 0;
+
+/** Must match CLEARCODEC_MAX_FRAME_TILES in clearcodec_wasm.c */
+const CLEARCODEC_MAX_FRAME_TILES = 256;
+
+/** Must match PROG_MAX_FRAME_MESSAGES in progressive/rfx_types.h */
+const PROG_MAX_FRAME_MESSAGES = 64;
+
+/** Must match PROG_ERR_DIRTY_RECTS in progressive/rfx_types.h */
+const PROG_ERR_DIRTY_RECTS = -2;
+
 /** @type {Map<number, Surface>} Surface ID → surface state */
 const surfaces = new Map();
 
 /** 
  * Cache slot → cached bitmap entry (for SurfaceToCache/CacheToSurface)
- * Enhanced with source tracking for debugging cache corruption issues
+ * Enhanced with source tracking for debugging cache corruption issues.
+ * Entries stay on the GPU (ImageBitmap, or a texture with WebGL2); Map
+ * insertion order is kept as LRU order (CacheToSurface moves a slot to the end).
  */
 const bitmapCache = new Map();
 
+/** Bitmap cache size per MS-RDPEGFX: 100 MB, 16 MB with RDPGFX_CAPS_FLAG_SMALL_CACHE */
+const GFX_CACHE_BYTES = 100 * 1024 * 1024;
+const GFX_SMALL_CACHE_BYTES = 16 * 1024 * 1024;
+
+/** @type {number} Current cache budget (set from CapsConfirm flags) */
+let cacheBudgetBytes = GFX_CACHE_BYTES;
+
+/** @type {number} Bytes held by all cache entries (w * h * 4 each) */
+let cacheBytes = 0;
+
 /** @type {OffscreenCanvas|null} Primary render target */
 let primaryCanvas = null;
 
-/** @type {OffscreenCanvasRenderingContext2D|null} Primary 2D context */
+/** @type {OffscreenCanvasRenderingContext2D|null} Primary 2D context (2D backend only) */
 let primaryCtx = null;
 
+/**
+ * @type {WebGLCompositor|null} WebGL2 backend, null when using the 2D canvas backend.
+ * With WebGL2, surfaces and cache entries are textures (surface.gl / entry.gl)
+ * and surface.canvas / surface.ctx are null.
+ */
+let glCompositor = null;
+
 /** @type {number|null} Primary surface ID (mapped to output) - legacy, kept for compatibility */
 let primarySurfaceId = null;
 
@@ -104,8 +253,29 @@ let currentFrameId = null;
 /** @type {number|null} Last completed frame ID for skip detection */
 let lastCompletedFrameId = null;
 
-/** @type {Set<number>} Surfaces updated in the current frame */
-let frameUpdatedSurfaces = new Set();
+/**
+ * @type {Map<number, Array<{x: number, y: number, w: number, h: number}>>}
+ * Surface ID → rects damaged in the current frame (surface coordinates).
+ * endFrame composites only these rects to the primary canvas.
+ */
+const frameDamage = new Map();
+
+/** Damage rects kept per surface before they collapse into their bounding box */
+const MAX_DAMAGE_RECTS = 16;
+
+/**
+ * @type {Set<number>}
+ * Surface IDs whose whole area must be composited at the next endFrame:
+ * surfaces newly mapped to the output, or all mapped surfaces after the
+ * primary canvas was cleared. Survives startFrame, unlike frameDamage.
+ */
+const pendingFullDamage = new Set();
+
+/**
+ * Compositing metrics, reported with every frame ack
+ * (pixels copied to the primary canvas vs. full-surface compositing)
+ */
+const compositeMetrics = { damagedPixels: 0, surfacePixels: 0, damageRects: 0 };
 
 /** @type {boolean} Whether WASM is ready */
 let wasmReady = false;
@@ -214,14 +384,29 @@ function createSurface(surfaceId, width, height, pixelFormat = GFX_PIXEL_FORMAT.
         deleteSurface(surfaceId);
     }
     
+    if (glCompositor) {
+        surfaces.set(surfaceId, {
+            id: surfaceId,
+            width,
+            height,
+            pixelFormat,
+            canvas: null,
+            ctx: null,
+            gl: glCompositor.createSurface(width, height)
+        });
+        createSurfaceDecoderState(surfaceId, width, height);
+        return;
+    }
+    
     const canvas = new OffscreenCanvas(width, height);
     const ctx = canvas.getContext('2d', { 
         alpha: false,
         // NOTE: Do NOT use desynchronized:true on surfaces!
-        // It causes race conditions with getImageData() in S2S operations - 
+        // It causes race conditions with surface reads in S2S/S2C operations -
         // the async rendering pipeline may not have committed pixels yet,
         // resulting in reading stale/black data.
-        willReadFrequently: true  // Optimize for SurfaceToCache/S2S getImageData calls
+        // No willReadFrequently: surfaces are never read back to the CPU
+        // (S2S/S2C copy with drawImage/createImageBitmap), so keep them GPU-backed.
     });
     
     ctx.imageSmoothingEnabled = false;
@@ -236,9 +421,17 @@ function createSurface(surfaceId, width, height, pixelFormat = GFX_PIXEL_FORMAT.
         height,
         pixelFormat,  // Store for potential ClearCodec processing
         canvas,
-        ctx
+        ctx,
+        gl: null
     });
     
+    createSurfaceDecoderState(surfaceId, width, height);
+}
+
+/**
+ * Create the per-surface decoder state that lives in WASM
+ */
+function createSurfaceDecoderState(surfaceId, width, height) {
     // Always create fresh WASM Progressive state for new surfaces
     // Per RFX/GFX protocol: Surface lifecycle = Progressive codec lifecycle
     // The server will send fresh TILE_FIRST data, not UPGRADE tiles expecting old state
@@ -248,6 +441,11 @@ function createSurface(surfaceId, width, height, pixelFormat = GFX_PIXEL_FORMAT.
         wasmModule._prog_create_surface(progCtx, surfaceId, width, height);
     }
     
+    // Register ClearCodec decode target (framebuffer is allocated on first tile)
+    if (clearWasmReady && clearCtx) {
+        clearWasmModule._clear_create_surface(clearCtx, surfaceId, width, height);
+    }
+    
     // Clear the last deleted surface info (no longer needed for preservation logic)
     lastDeletedSurface = null;
 }
@@ -272,9 +470,13 @@ function deleteSurface(surfaceId) {
     
     // Delete JS surface cache
     surfaces.delete(surfaceId);
+    if (surface.gl) {
+        glCompositor.deleteSurface(surface.gl);
+    }
     
-    // Remove from frameUpdatedSurfaces tracking
-    frameUpdatedSurfaces.delete(surfaceId);
+    // Remove from damage tracking
+    frameDamage.delete(surfaceId);
+    pendingFullDamage.delete(surfaceId);
     
     // NOTE: Do NOT evict bitmap cache entries here!
     // The RDP bitmap cache is independent of surfaces. Cache entries survive
@@ -286,6 +488,11 @@ function deleteSurface(surfaceId) {
         wasmModule._prog_delete_surface(progCtx, surfaceId);
     }
     
+    // Release ClearCodec framebuffer for this surface
+    if (clearWasmReady && clearCtx) {
+        clearWasmModule._clear_delete_surface(clearCtx, surfaceId);
+    }
+    
     // Remove from output mapping
     mappedSurfaces.delete(surfaceId);
     
@@ -307,6 +514,9 @@ function mapSurfaceToOutput(surfaceId, outputX = 0, outputY = 0) {
     // Store mapping with position
     mappedSurfaces.set(surfaceId, { outputX, outputY });
     
+    // Existing surface content was never composited at this position
+    pendingFullDamage.add(surfaceId);
+    
     // Keep legacy primarySurfaceId updated for backward compatibility
     // (last mapped surface becomes primary)
     primarySurfaceId = surfaceId;
@@ -317,8 +527,6 @@ function mapSurfaceToOutput(surfaceId, outputX = 0, outputY = 0) {
 // ============================================================================
 
 /** @type {boolean} Whether parallel decompression is available */
-let parallelDecompressAvailable = false;
-
 /**
  * Initialize Progressive decoder WASM module
  * Supports pthreads for parallel tile decoding when available
@@ -358,8 +566,8 @@ async function initWasm() {
             throw new Error('Failed to create progressive decoder context');
         }
         
-        // Check if parallel decompress is available
-        parallelDecompressAvailable = typeof wasmModule._prog_decompress_parallel === 'function';
+        // Frame-level batch API: descriptor array lives in the context
+        progFrameMessagesPtr = wasmModule._prog_get_frame_messages(progCtx);
         
         // Create surfaces in WASM for any already-created surfaces
         for (const [id, surface] of surfaces) {
@@ -367,7 +575,7 @@ async function initWasm() {
         }
         
         wasmReady = true;
-        console.log(`[GFX Worker] Progressive WASM decoder initialized (parallel: ${parallelDecompressAvailable})`);
+        console.log('[GFX Worker] Progressive WASM decoder initialized');
         
     } catch (err) {
         console.warn('[GFX Worker] Progressive WASM not available:', err.message);
@@ -391,10 +599,13 @@ async function initClearCodecWasm() {
             throw new Error('ClearCodec WASM module factory not found in exports');
         }
         
-        // Initialize WASM
+        // Initialize WASM - pthreads require special locateFile for worker
         clearWasmModule = await ModuleFactory({
-            // Help Emscripten find the wasm file
+            // Help Emscripten find the wasm file and pthread worker script
             locateFile: (path) => {
+                if (path.endsWith('.worker.js')) {
+                    return './clearcodec/' + path;
+                }
                 if (path.endsWith('.wasm')) {
                     return './clearcodec/' + path;
                 }
@@ -411,6 +622,15 @@ async function initClearCodecWasm() {
             throw new Error('Failed to create ClearCodec decoder context');
         }
         
+        // Create surfaces in WASM for any already-created surfaces
+        for (const [id, surface] of surfaces) {
+            clearWasmModule._clear_create_surface(clearCtx, id, surface.width, surface.height);
+        }
+        
+        // Frame-level batch API: both arrays live in the context
+        clearFrameTilesPtr = clearWasmModule._clear_get_frame_tiles(clearCtx);
+        clearDirtyRectsPtr = clearWasmModule._clear_get_dirty_rects(clearCtx);
+        
         clearWasmReady = true;
         console.log('[GFX Worker] ClearCodec WASM decoder initialized');
         
@@ -426,8 +646,31 @@ async function initClearCodecWasm() {
 // ============================================================================
 
 /**
- * Decode and draw a progressive tile
- * Uses batch-oriented API: decodes all tiles, then renders after frame complete
+ * Copy a codec payload into a batch's WASM staging buffer.
+ * The buffer only grows (geometrically), so already staged payloads stay put.
+ * @returns {number} Offset of the payload in the staging buffer, -1 on OOM
+ */
+function stageBatchPayload(batch, module, getInputBuffer, payload) {
+    const offset = batch.bytes;
+    const needed = offset + payload.byteLength;
+    
+    if (needed > batch.capacity) {
+        const capacity = Math.max(needed, batch.capacity * 2);
+        const inputPtr = getInputBuffer(capacity);
+        if (!inputPtr) {
+            return -1;
+        }
+        batch.inputPtr = inputPtr;
+        batch.capacity = capacity;
+    }
+    
+    module.HEAPU8.set(payload, batch.inputPtr + offset);
+    batch.bytes = needed;
+    return offset;
+}
+
+/**
+ * Queue a progressive message for the next frame-level decode
  */
 function decodeProgressiveTile(msg) {
     if (!wasmReady || !progCtx) {
@@ -435,259 +678,388 @@ function decodeProgressiveTile(msg) {
         return;
     }
     
-    let surface = surfaces.get(msg.surfaceId);
-    let actualSurfaceId = msg.surfaceId;
-    
-    if (!surface) {
+    if (!surfaces.has(msg.surfaceId)) {
         // Surface was deleted - discard stale data for it
         // Do NOT apply to a different surface (would cause wrong content like login screen on desktop)
         console.warn(`[GFX Worker] Discarding Progressive data for deleted surface ${msg.surfaceId}`);
         return;
     }
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(actualSurfaceId);
-    
-    const payload = msg.payload;
-    
-    // Allocate WASM memory for input
-    const inputPtr = wasmModule._malloc(payload.byteLength);
-    wasmModule.HEAPU8.set(payload, inputPtr);
-    
-    // Use parallel decode if available (clipRect handling is in JS after decode)
-    let result;
-    if (parallelDecompressAvailable) {
-        result = wasmModule._prog_decompress_parallel(
-            progCtx, inputPtr, payload.byteLength, 
-            actualSurfaceId, msg.frameId
-        );
-    } else {
-        result = wasmModule._prog_decompress(
-            progCtx, inputPtr, payload.byteLength, 
-            actualSurfaceId, msg.frameId
-        );
+    if (progBatch.count >= PROG_MAX_FRAME_MESSAGES) {
+        flushProgressiveTiles();
     }
     
-    wasmModule._free(inputPtr);
-    
-    if (result !== 0) {
-        console.error(`[PROG-WASM] decompress FAILED: result=${result} surface=${actualSurfaceId} frame=${msg.frameId} bytes=${payload.byteLength}`);
+    const offset = stageBatchPayload(progBatch, wasmModule,
+        (size) => wasmModule._prog_get_input_buffer(progCtx, size), msg.payload);
+    if (offset < 0) {
+        console.error('[GFX Worker] Progressive: Failed to allocate input buffer');
         return;
     }
     
-    // Check frame state - only render when frame is complete
-    const frameComplete = wasmModule._prog_is_frame_complete(progCtx);
-    
-    // Use new batch tile tracking API for efficient iteration
-    const updatedCount = wasmModule._prog_get_updated_tile_count(progCtx);
+    // ProgFrameMessage: surfaceId, frameId, srcOffset, srcSize, result (u32 each)
+    const heap = wasmModule.HEAPU32;
+    const base = (progFrameMessagesPtr >> 2) + progBatch.count * 5;
+    heap[base] = msg.surfaceId;
+    heap[base + 1] = msg.frameId >>> 0;
+    heap[base + 2] = offset;
+    heap[base + 3] = msg.payload.byteLength;
+    heap[base + 4] = 0;
+    progBatch.count++;
+}
 
-    // Skip if no tiles were updated
-    if (updatedCount === 0) {
-        return;
+/**
+ * Decode all queued progressive messages and draw their dirty rects.
+ * prog_decode_frame() may stop early when a message would overwrite tiles
+ * the pending rects still point at - draw those, then continue.
+ */
+function flushProgressiveTiles() {
+    if (progBatch.count === 0) return;
+    
+    const total = progBatch.count;
+    progBatch.count = 0;
+    progBatch.bytes = 0;
+    
+    let first = 0;
+    while (first < total) {
+        const consumed = wasmModule._prog_decode_frame(progCtx, first, total - first);
+        if (consumed <= 0) {
+            console.error(`[PROG-WASM] decode_frame failed: ${consumed}`);
+            break;
+        }
+        
+        const heap = wasmModule.HEAPU32;
+        let rectsLostSurface = -1;
+        for (let i = first; i < first + consumed; i++) {
+            const base = (progFrameMessagesPtr >> 2) + i * 5;
+            const result = heap[base + 4] | 0;
+            if (result === PROG_ERR_DIRTY_RECTS) {
+                // Always the batch's last message, so its tiles are still the dirty ones
+                console.warn(`[PROG-WASM] dirty rect array full, drawing whole tiles: surface=${heap[base]} frame=${heap[base + 1]}`);
+                rectsLostSurface = heap[base];
+            } else if (result !== 0) {
+                console.error(`[PROG-WASM] decompress FAILED: result=${result} surface=${heap[base]} frame=${heap[base + 1]} bytes=${heap[base + 3]}`);
+            }
+        }
+        
+        drawProgressiveDirtyRects();
+        if (rectsLostSurface >= 0) {
+            drawProgressiveDirtyTiles(rectsLostSurface);
+        }
+        first += consumed;
     }
+}
 
-    let tilesDrawn = 0;
-
-    // Get surface grid dimensions for index-to-coordinates conversion
-    const gridWidth = Math.ceil(surface.width / 64);
+/**
+ * Draw the packed ProgDirtyRect array of the last prog_decode_frame() call.
+ * Rects are already clipped to the region clipRects in WASM; consecutive
+ * rects of the same tile share one copy into the scratch ImageData.
+ */
+function drawProgressiveDirtyRects() {
+    const count = wasmModule._prog_get_dirty_rect_count(progCtx);
+    if (count === 0) return;
     
-    try {
-        // Iterate using batch tile tracking (more efficient than scanning dirty flags)
-        for (let i = 0; i < updatedCount; i++) {
-            const tileIdx = wasmModule._prog_get_updated_tile_index(progCtx, i);
-            if (tileIdx === 0xFFFFFFFF) {
-                continue;
-            }
-            
-            // Convert grid index to coordinates
-            const xIdx = tileIdx % gridWidth;
-            const yIdx = Math.floor(tileIdx / gridWidth);
-            const tileX = xIdx * 64;
-            const tileY = yIdx * 64;
-
-            // Get tile pixel data
-            const tileDataPtr = wasmModule._prog_get_tile_data(progCtx, actualSurfaceId, xIdx, yIdx);
-            if (!tileDataPtr) {
-                continue;
-            }
-            
-            // Calculate actual tile dimensions (may be clipped at edges)
-            const tileW = Math.min(64, surface.width - tileX);
-            const tileH = Math.min(64, surface.height - tileY);
-            
-            // Create ImageData from WASM memory
-            // IMPORTANT: Use wasmModule.HEAPU8.buffer directly - Emscripten updates this after memory growth
-            // We must copy the data because WASM memory can be resized/detached
-            const tileSize = 64 * 64 * 4;
-            
-            // Safety check: ensure pointer is within WASM memory bounds
-            const wasmBuffer = wasmModule.HEAPU8.buffer;
-            if (tileDataPtr + tileSize > wasmBuffer.byteLength) {
-                console.error(`[GFX Worker] Tile data pointer out of bounds: ${tileDataPtr} + ${tileSize} > ${wasmBuffer.byteLength}`);
-                continue;
-            }
-            
-            // Create a fresh view and immediately copy to avoid stale buffer issues
-            const pixelData = new Uint8ClampedArray(wasmBuffer, tileDataPtr, tileSize);
-            const copiedData = new Uint8ClampedArray(tileSize);
-            copiedData.set(pixelData);
-            
-            const imageData = new ImageData(copiedData, 64, 64);
-
-            // Handle clipping based on per-tile clipRects
-            // Each tile has its own clipRects from when it was decoded (important for multi-region frames)
-            let tileWasDrawn = false;
-
-            // Get per-tile clipRect count (uses the clipRects from when this tile was decoded)
-            const tileClipRectCount = wasmModule._prog_get_tile_clip_rect_count ? 
-                wasmModule._prog_get_tile_clip_rect_count(progCtx, i) : 0;
-            
-            // If count is 0, > 16 (too many to store), or undefined, draw the full tile
-            // This ensures tiles from regions with many clipRects (like full-screen wallpaper) draw correctly
-            if (tileClipRectCount === 0 || tileClipRectCount > 16) {
-                // No clipRects or too many - draw the full tile
-                surface.ctx.putImageData(imageData, tileX, tileY, 0, 0, tileW, tileH);
-                tileWasDrawn = true;
-            } else {
-                // For each clipRect, compute intersection with this tile and draw that portion
-                // This matches FreeRDP's approach: region16_intersect_rect followed by loop over nbUpdateRects
-                // Each clipRect can produce a separate draw operation for this tile
-                for (let ci = 0; ci < tileClipRectCount; ci++) {
-                    const cx = wasmModule._prog_get_tile_clip_rect_x(progCtx, i, ci);
-                    const cy = wasmModule._prog_get_tile_clip_rect_y(progCtx, i, ci);
-                    const cw = wasmModule._prog_get_tile_clip_rect_width(progCtx, i, ci);
-                    const ch = wasmModule._prog_get_tile_clip_rect_height(progCtx, i, ci);
-                    const crRight = cx + cw;
-                    const crBottom = cy + ch;
-                    
-                    // Check if this clipRect intersects the tile
-                    if (tileX < crRight && tileX + tileW > cx &&
-                        tileY < crBottom && tileY + tileH > cy) {
-                        // Calculate intersection rectangle
-                        const intersectLeft = Math.max(tileX, cx);
-                        const intersectTop = Math.max(tileY, cy);
-                        const intersectRight = Math.min(tileX + tileW, crRight);
-                        const intersectBottom = Math.min(tileY + tileH, crBottom);
-                        
-                        if (intersectRight > intersectLeft && intersectBottom > intersectTop) {
-                            // Calculate dirty rect within the 64x64 tile imageData
-                            const dirtyX = intersectLeft - tileX;
-                            const dirtyY = intersectTop - tileY;
-                            const dirtyW = intersectRight - intersectLeft;
-                            const dirtyH = intersectBottom - intersectTop;
-                            
-                            // putImageData(imageData, dx, dy, dirtyX, dirtyY, dirtyWidth, dirtyHeight)
-                            surface.ctx.putImageData(imageData, tileX, tileY, dirtyX, dirtyY, dirtyW, dirtyH);
-                            tileWasDrawn = true;
-                        }
-                    }
-                }
-            }
-
-            if (tileWasDrawn) {
-                tilesDrawn++;
-            }
+    const rectsPtr = wasmModule._prog_get_dirty_rects(progCtx);
+    const heapU32 = wasmModule.HEAPU32;
+    const heapU8 = wasmModule.HEAPU8;
+    const tileSize = 64 * 64 * 4;
+    
+    if (!progTileImageData && !glCompositor) {
+        progTileImageData = new ImageData(64, 64);
+    }
+    
+    let loadedTilePtr = 0;
+    
+    // ProgDirtyRect: data, surfaceId, dstX, dstY, srcX, srcY, width, height (u32 each)
+    for (let i = 0; i < count; i++) {
+        const base = (rectsPtr >> 2) + i * 8;
+        const dataPtr = heapU32[base];
+        const surface = surfaces.get(heapU32[base + 1]);
+        if (!surface) continue;
+        
+        // Safety check: ensure pointer is within WASM memory bounds
+        if (dataPtr + tileSize > heapU8.byteLength) {
+            console.error(`[GFX Worker] Tile data pointer out of bounds: ${dataPtr} + ${tileSize} > ${heapU8.byteLength}`);
+            continue;
         }
-    } catch (e) {
-        console.error(`[GFX Worker] Progressive tile loop error at tile ${tilesDrawn}:`, e);
+        
+        const dstX = heapU32[base + 2];
+        const dstY = heapU32[base + 3];
+        const srcX = heapU32[base + 4];
+        const srcY = heapU32[base + 5];
+        addSurfaceDamage(surface, dstX, dstY, heapU32[base + 6], heapU32[base + 7]);
+        
+        if (!surface.gl && dataPtr !== loadedTilePtr) {
+            progTileImageData.data.set(heapU8.subarray(dataPtr, dataPtr + tileSize));
+            loadedTilePtr = dataPtr;
+        }
+        
+        if (surface.gl) {
+            // Upload the rect straight from the 64x64 tile in WASM memory
+            glCompositor.upload(surface.gl, dstX, dstY, heapU32[base + 6], heapU32[base + 7],
+                heapU8, dataPtr, 64, srcX, srcY);
+            continue;
+        }
+        
+        // putImageData(imageData, dx, dy, dirtyX, dirtyY, dirtyWidth, dirtyHeight)
+        surface.ctx.putImageData(progTileImageData, dstX - srcX, dstY - srcY,
+            srcX, srcY, heapU32[base + 6], heapU32[base + 7]);
     }
 }
 
 /**
- * Decode and draw a ClearCodec tile using WASM decoder
+ * Draw every dirty tile of a surface in full, ignoring its clip rects.
+ * Fallback for a message whose dirty rects did not fit in WASM memory.
  */
-function decodeClearCodecTile(msg) {
-    if (!clearWasmReady || !clearCtx) {
-        console.warn('[GFX Worker] ClearCodec decoder not ready, skipping tile');
-        return;
+function drawProgressiveDirtyTiles(surfaceId) {
+    const surface = surfaces.get(surfaceId);
+    if (!surface) return;
+    
+    const count = wasmModule._prog_get_dirty_tile_count(progCtx, surfaceId);
+    if (count === 0) return;
+    
+    // Out params: x, y, xIdx, yIdx (u16 each)
+    const infoPtr = wasmModule._malloc(8);
+    if (!infoPtr) return;
+    
+    const tileSize = 64 * 64 * 4;
+    if (!progTileImageData && !glCompositor) {
+        progTileImageData = new ImageData(64, 64);
     }
     
-    const surface = surfaces.get(msg.surfaceId);
-    if (!surface) {
-        console.warn(`[GFX Worker] ClearCodec: Unknown surface ${msg.surfaceId}`);
-        return;
+    for (let i = 0; i < count; i++) {
+        if (wasmModule._prog_get_dirty_tile_info(progCtx, surfaceId, i,
+                infoPtr, infoPtr + 2, infoPtr + 4, infoPtr + 6) !== 0) {
+            break;
+        }
+        const info = wasmModule.HEAPU16.subarray(infoPtr >> 1, (infoPtr >> 1) + 4);
+        const [x, y, xIdx, yIdx] = info;
+        const dataPtr = wasmModule._prog_get_tile_data(progCtx, surfaceId, xIdx, yIdx);
+        if (!dataPtr) continue;
+        
+        const w = Math.min(64, surface.width - x);
+        const h = Math.min(64, surface.height - y);
+        if (w <= 0 || h <= 0) continue;
+        addSurfaceDamage(surface, x, y, w, h);
+        
+        if (surface.gl) {
+            glCompositor.upload(surface.gl, x, y, w, h, wasmModule.HEAPU8, dataPtr, 64, 0, 0);
+        } else {
+            progTileImageData.data.set(wasmModule.HEAPU8.subarray(dataPtr, dataPtr + tileSize));
+            surface.ctx.putImageData(progTileImageData, x, y, 0, 0, w, h);
+        }
     }
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.surfaceId);
+    wasmModule._free(infoPtr);
+}
+
+/**
+ * Get an ImageData view over a surface's ClearCodec framebuffer in WASM memory.
+ * Cached per surface; rebuilt when WASM memory grows (old views are detached).
+ */
+function getClearSurfaceImageData(surface) {
+    const wasmBuffer = clearWasmModule.HEAPU8.buffer;
+    if (surface.clearImageData && surface.clearImageBuffer === wasmBuffer) {
+        return surface.clearImageData;
+    }
     
-    const payload = msg.payload;
-    const w = msg.w;
-    const h = msg.h;
+    const dataPtr = clearWasmModule._clear_get_surface_data(clearCtx, surface.id);
+    if (!dataPtr) return null;
     
-    // Allocate WASM memory for input
-    const inputPtr = clearWasmModule._malloc(payload.byteLength);
-    clearWasmModule.HEAPU8.set(payload, inputPtr);
+    const dataSize = surface.width * surface.height * 4;
+    if (dataPtr + dataSize > wasmBuffer.byteLength) {
+        console.error(`[GFX Worker] ClearCodec surface buffer out of bounds`);
+        return null;
+    }
     
-    // Allocate output buffer (RGBA = 4 bytes per pixel)
-    const outputSize = w * h * 4;
-    const outputPtr = clearWasmModule._clear_alloc_output(w, h);
+    surface.clearImageData = new ImageData(
+        new Uint8ClampedArray(wasmBuffer, dataPtr, dataSize),
+        surface.width, surface.height
+    );
+    surface.clearImageBuffer = wasmBuffer;
+    return surface.clearImageData;
+}
+
+/**
+ * Upload a rect of a surface's ClearCodec framebuffer to its canvas.
+ * ImageData can't wrap shared memory (pthread builds), so in that case the
+ * rect rows are copied into a reusable scratch ImageData first.
+ */
+function putClearRect(surface, x, y, w, h) {
+    const heap = clearWasmModule.HEAPU8;
+    
+    if (surface.gl) {
+        // texSubImage2D reads the rect in place, shared memory or not
+        const dataPtr = clearWasmModule._clear_get_surface_data(clearCtx, surface.id);
+        if (dataPtr) {
+            glCompositor.upload(surface.gl, x, y, w, h, heap, dataPtr, surface.width, x, y);
+        }
+        return;
+    }
     
-    if (!outputPtr) {
-        console.error('[GFX Worker] ClearCodec: Failed to allocate output buffer');
-        clearWasmModule._free(inputPtr);
+    if (!(typeof SharedArrayBuffer !== 'undefined' && heap.buffer instanceof SharedArrayBuffer)) {
+        const imageData = getClearSurfaceImageData(surface);
+        if (!imageData) return;
+        
+        // Upload only the dirty rect from the framebuffer view
+        surface.ctx.putImageData(imageData, 0, 0, x, y, w, h);
         return;
     }
     
-    // Decode ClearCodec to RGBA output
-    // clear_decompress(ctx, srcData, srcSize, nWidth, nHeight, dstData, dstStep, nXDst, nYDst, dstWidth, dstHeight)
-    const result = clearWasmModule._clear_decompress(
-        clearCtx,
-        inputPtr, payload.byteLength,
-        w, h,
-        outputPtr, w * 4,  // dstStep = width * 4
-        0, 0,              // decode at origin of output buffer
-        w, h               // output buffer dimensions = tile dimensions
-    );
+    const dataPtr = clearWasmModule._clear_get_surface_data(clearCtx, surface.id);
+    if (!dataPtr) return;
     
-    clearWasmModule._free(inputPtr);
+    if (!clearUploadImageData || clearUploadImageData.width < w || clearUploadImageData.height < h) {
+        clearUploadImageData = new ImageData(
+            Math.max(w, clearUploadImageData ? clearUploadImageData.width : 0),
+            Math.max(h, clearUploadImageData ? clearUploadImageData.height : 0)
+        );
+    }
     
-    if (result < 0) {
-        console.warn(`[GFX Worker] ClearCodec decode failed: ${result}`);
-        clearWasmModule._clear_free_output(outputPtr);
+    const srcStride = surface.width * 4;
+    const dstStride = clearUploadImageData.width * 4;
+    const rowBytes = w * 4;
+    const dst = clearUploadImageData.data;
+    let src = dataPtr + y * srcStride + x * 4;
+    for (let row = 0; row < h; row++) {
+        dst.set(heap.subarray(src, src + rowBytes), row * dstStride);
+        src += srcStride;
+    }
+    
+    surface.ctx.putImageData(clearUploadImageData, x, y, 0, 0, w, h);
+}
+
+/**
+ * Queue a ClearCodec tile for the next frame-level decode.
+ * Tiles decode straight into the surface's framebuffer in WASM memory;
+ * only the written rect is uploaded to the canvas.
+ */
+function decodeClearCodecTile(msg) {
+    if (!clearWasmReady || !clearCtx) {
+        console.warn('[GFX Worker] ClearCodec decoder not ready, skipping tile');
         return;
     }
     
-    // Copy decoded pixels from WASM memory
-    const wasmBuffer = clearWasmModule.HEAPU8.buffer;
-    if (outputPtr + outputSize > wasmBuffer.byteLength) {
-        console.error(`[GFX Worker] ClearCodec output pointer out of bounds`);
-        clearWasmModule._clear_free_output(outputPtr);
+    if (!surfaces.has(msg.surfaceId)) {
+        console.warn(`[GFX Worker] ClearCodec: Unknown surface ${msg.surfaceId}`);
         return;
     }
     
-    const pixelData = new Uint8ClampedArray(wasmBuffer, outputPtr, outputSize);
-    const copiedData = new Uint8ClampedArray(outputSize);
-    copiedData.set(pixelData);
+    if (clearBatch.count >= CLEARCODEC_MAX_FRAME_TILES) {
+        flushClearCodecTiles();
+    }
     
-    // Free WASM output buffer
-    clearWasmModule._clear_free_output(outputPtr);
+    const offset = stageBatchPayload(clearBatch, clearWasmModule,
+        (size) => clearWasmModule._clear_get_input_buffer(clearCtx, size), msg.payload);
+    if (offset < 0) {
+        console.error('[GFX Worker] ClearCodec: Failed to allocate input buffer');
+        return;
+    }
     
-    // Create ImageData and draw to surface
-    const imageData = new ImageData(copiedData, w, h);
-    surface.ctx.putImageData(imageData, msg.x, msg.y);
+    // ClearFrameTile: surfaceId, srcOffset, srcSize, x, y, width, height (u32 each)
+    const heap = clearWasmModule.HEAPU32;
+    const base = (clearFrameTilesPtr >> 2) + clearBatch.count * 7;
+    heap[base] = msg.surfaceId;
+    heap[base + 1] = offset;
+    heap[base + 2] = msg.payload.byteLength;
+    heap[base + 3] = msg.x;
+    heap[base + 4] = msg.y;
+    heap[base + 5] = msg.w;
+    heap[base + 6] = msg.h;
+    clearBatch.count++;
+}
+
+/**
+ * Decode all queued ClearCodec tiles (in parallel in WASM) and upload the
+ * packed ClearDirtyRect results.
+ */
+function flushClearCodecTiles() {
+    if (clearBatch.count === 0) return;
+    
+    const count = clearWasmModule._clear_decode_frame(clearCtx, clearBatch.count);
+    clearBatch.count = 0;
+    clearBatch.bytes = 0;
+    
+    // ClearDirtyRect: surfaceId, x, y, width, height, result (u32 each)
+    const heap = clearWasmModule.HEAPU32;
+    for (let i = 0; i < count; i++) {
+        const base = (clearDirtyRectsPtr >> 2) + i * 6;
+        const result = heap[base + 5] | 0;
+        
+        if (result < 0) {
+            console.warn(`[GFX Worker] ClearCodec decode failed: ${result}`);
+            continue;
+        }
+        
+        const surface = surfaces.get(heap[base]);
+        const w = heap[base + 3];
+        const h = heap[base + 4];
+        if (!surface || w === 0 || h === 0) continue;
+        
+        putClearRect(surface, heap[base + 1], heap[base + 2], w, h);
+        addSurfaceDamage(surface, heap[base + 1], heap[base + 2], w, h);
+    }
+}
+
+/**
+ * Apply everything batched so far (tile decodes and coalesced surface copies)
+ */
+function flushPendingBatches() {
+    flushClearCodecTiles();
+    flushProgressiveTiles();
+    flushSurfaceCopies();
+}
+
+/**
+ * Codec whose frame-level batch a message joins, or null
+ */
+function batchedTileCodec(msg) {
+    if (msg.type === 'tile' && (msg.codec === 'clearcodec' || msg.codec === 'progressive')) {
+        return msg.codec;
+    }
+    if (msg.type === 'videoFrame' &&
+        (msg.codecId === CODEC_ID.PROGRESSIVE || msg.codecId === CODEC_ID.PROGRESSIVE_V2)) {
+        return 'progressive';
+    }
+    return null;
 }
 
 /**
  * Decode and draw a WebP tile
  */
-async function decodeWebPTile(msg) {
+async function decodeWebPTile(msg, decodeJob = null) {
     const surface = surfaces.get(msg.surfaceId);
     if (!surface) {
         console.warn(`[GFX Worker] Unknown surface ${msg.surfaceId}`);
+        if (decodeJob) {
+            takeTileDecode(decodeJob).then((bitmap) => bitmap.close(), () => {});
+        }
         return;
     }
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.surfaceId);
+    // Track the damaged rect for endFrame compositing
+    addSurfaceDamage(surface, msg.x, msg.y, msg.w, msg.h);
     
     pendingOps++;
     
     try {
-        const blob = new Blob([msg.payload], { type: 'image/webp' });
-        const bitmap = await createImageBitmap(blob);
+        // Usually already decoded (started on arrival, see prefetchBinaryMessage)
+        let bitmap = decodeJob ?
+            await takeTileDecode(decodeJob) :
+            await createImageBitmap(new Blob([msg.payload], { type: 'image/webp' }));
         
-        surface.ctx.drawImage(bitmap, msg.x, msg.y, msg.w, msg.h);
+        if (surface.gl) {
+            // texSubImage2D copies 1:1; scale to the tile rect like drawImage does
+            if (bitmap.width !== msg.w || bitmap.height !== msg.h) {
+                const scaled = await createImageBitmap(bitmap, {
+                    resizeWidth: msg.w, resizeHeight: msg.h, resizeQuality: 'pixelated'
+                });
+                bitmap.close();
+                bitmap = scaled;
+            }
+            glCompositor.uploadImage(surface.gl, msg.x, msg.y, msg.w, msg.h, bitmap);
+        } else {
+            surface.ctx.drawImage(bitmap, msg.x, msg.y, msg.w, msg.h);
+        }
         bitmap.close();
         
     } catch (err) {
@@ -704,8 +1076,13 @@ function drawRawTile(msg) {
     const surface = surfaces.get(msg.surfaceId);
     if (!surface) return;
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.surfaceId);
+    // Track the damaged rect for endFrame compositing
+    addSurfaceDamage(surface, msg.x, msg.y, msg.w, msg.h);
+    
+    if (surface.gl) {
+        glCompositor.upload(surface.gl, msg.x, msg.y, msg.w, msg.h, msg.payload);
+        return;
+    }
     
     const imageData = new ImageData(
         new Uint8ClampedArray(msg.payload.buffer, msg.payload.byteOffset, msg.payload.byteLength),
@@ -751,12 +1128,18 @@ async function initH264(width, height) {
                     // Look up the target surface
                     const surface = surfaces.get(meta.surfaceId);
                     if (surface) {
-                        // Draw to the surface's OffscreenCanvas
-                        surface.ctx.drawImage(frame, 
-                            meta.destX, meta.destY, meta.destW, meta.destH,
-                            meta.destX, meta.destY, meta.destW, meta.destH);
-                        // Track that this surface was updated
-                        frameUpdatedSurfaces.add(meta.surfaceId);
+                        if (surface.gl) {
+                            glCompositor.uploadImage(surface.gl,
+                                meta.destX, meta.destY, meta.destW, meta.destH,
+                                frame, meta.destX, meta.destY);
+                        } else {
+                            // Draw to the surface's OffscreenCanvas
+                            surface.ctx.drawImage(frame, 
+                                meta.destX, meta.destY, meta.destW, meta.destH,
+                                meta.destX, meta.destY, meta.destW, meta.destH);
+                        }
+                        // Track the damaged rect for endFrame compositing
+                        addSurfaceDamage(surface, meta.destX, meta.destY, meta.destW, meta.destH);
                     } else {
                         console.warn(`[GFX Worker] H.264: Unknown surface ${meta.surfaceId}`);
                     }
@@ -804,8 +1187,8 @@ async function decodeH264Frame(msg) {
         return;
     }
     
-    const width = surface.canvas.width;
-    const height = surface.canvas.height;
+    const width = surface.width;
+    const height = surface.height;
     
     // Initialize decoder if needed
     if (!h264Initialized) {
@@ -898,22 +1281,27 @@ function applySolidFill(msg) {
     const surface = surfaces.get(msg.surfaceId);
     if (!surface) return;
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.surfaceId);
+    // Track the damaged rect for endFrame compositing
+    addSurfaceDamage(surface, msg.x, msg.y, msg.w, msg.h);
     
     // Extract BGRA components
     const b = (msg.color >> 0) & 0xFF;
     const g = (msg.color >> 8) & 0xFF;
     const r = (msg.color >> 16) & 0xFF;
     
+    if (surface.gl) {
+        glCompositor.fillRect(surface.gl, msg.x, msg.y, msg.w, msg.h, r, g, b);
+        return;
+    }
+    
     surface.ctx.fillStyle = `rgb(${r},${g},${b})`;
     surface.ctx.fillRect(msg.x, msg.y, msg.w, msg.h);
 }
 
 /**
  * Surface-to-surface blit (for scrolling/window moves)
- * IMPORTANT: Self-blits (src === dst) with overlapping regions need special handling
- * to avoid reading already-overwritten pixels.
+ * The server sends one message per destination point. Consecutive copies of
+ * the same source rect are coalesced and applied together by flushSurfaceCopies().
  */
 function applySurfaceToSurface(msg) {
     const srcSurface = surfaces.get(msg.srcSurfaceId);
@@ -923,23 +1311,91 @@ function applySurfaceToSurface(msg) {
         return;
     }
     
-    // Track that destination surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.dstSurfaceId);
+    const run = pendingSurfaceCopy;
+    if (!run || run.sourceDirty ||
+        run.src !== srcSurface || run.dst !== dstSurface ||
+        run.x !== msg.srcX || run.y !== msg.srcY || run.w !== msg.srcW || run.h !== msg.srcH) {
+        flushSurfaceCopies();
+        pendingSurfaceCopy = {
+            src: srcSurface,
+            dst: dstSurface,
+            x: msg.srcX,
+            y: msg.srcY,
+            w: msg.srcW,
+            h: msg.srcH,
+            points: [],
+            sourceDirty: false
+        };
+    }
+    
+    const copy = pendingSurfaceCopy;
+    copy.points.push({ x: msg.dstX, y: msg.dstY });
+    
+    // A destination over the source rect changes what the next copy must read
+    if (srcSurface === dstSurface &&
+        msg.dstX < copy.x + copy.w && copy.x < msg.dstX + copy.w &&
+        msg.dstY < copy.y + copy.h && copy.y < msg.dstY + copy.h) {
+        copy.sourceDirty = true;
+    }
+}
+
+/**
+ * Apply the pending surface-to-surface run: the source rect is read once and
+ * drawn at every destination point.
+ * Self-blits (src === dst) may overlap, so the source rect is first copied to a
+ * persistent scratch canvas on the GPU (no getImageData/putImageData readback).
+ */
+function flushSurfaceCopies() {
+    const copy = pendingSurfaceCopy;
+    if (!copy) return;
+    pendingSurfaceCopy = null;
+    
+    const { src, dst, x, y, w, h, points } = copy;
+    if (w === 0 || h === 0) return;
+    
+    if (dst.gl) {
+        // Self-blits go through a scratch texture inside copyRect
+        glCompositor.copyRect(src.gl, x, y, w, h, dst.gl, points);
+        for (const point of points) {
+            addSurfaceDamage(dst, point.x, point.y, w, h);
+        }
+        return;
+    }
+    
+    let source = src.canvas;
+    let sx = x;
+    let sy = y;
     
-    // Check for self-blit (same surface) with potentially overlapping regions
-    if (msg.srcSurfaceId === msg.dstSurfaceId) {
-        // For self-blits, we must use getImageData/putImageData to avoid
-        // reading from already-overwritten pixels during drawImage with 'copy' mode
-        const imageData = srcSurface.ctx.getImageData(msg.srcX, msg.srcY, msg.srcW, msg.srcH);
-        dstSurface.ctx.putImageData(imageData, msg.dstX, msg.dstY);
-    } else {
-        // Different surfaces - safe to use drawImage
-        dstSurface.ctx.drawImage(
-            srcSurface.canvas,
-            msg.srcX, msg.srcY, msg.srcW, msg.srcH,
-            msg.dstX, msg.dstY, msg.srcW, msg.srcH
+    if (src === dst) {
+        const scratch = getSurfaceCopyScratch(w, h);
+        scratch.ctx.drawImage(src.canvas, x, y, w, h, 0, 0, w, h);
+        source = scratch.canvas;
+        sx = 0;
+        sy = 0;
+    }
+    
+    for (const point of points) {
+        dst.ctx.drawImage(source, sx, sy, w, h, point.x, point.y, w, h);
+        addSurfaceDamage(dst, point.x, point.y, w, h);
+    }
+}
+
+/**
+ * Get the scratch canvas for self-blits, grown to at least w x h
+ */
+function getSurfaceCopyScratch(w, h) {
+    if (!surfaceCopyScratch || surfaceCopyScratch.canvas.width < w || surfaceCopyScratch.canvas.height < h) {
+        const canvas = new OffscreenCanvas(
+            Math.max(w, surfaceCopyScratch ? surfaceCopyScratch.canvas.width : 0),
+            Math.max(h, surfaceCopyScratch ? surfaceCopyScratch.canvas.height : 0)
         );
+        const ctx = canvas.getContext('2d', { alpha: false });
+        ctx.imageSmoothingEnabled = false;
+        // Replace, don't blend: the scratch only ever holds the last source rect
+        ctx.globalCompositeOperation = 'copy';
+        surfaceCopyScratch = { canvas, ctx };
     }
+    return surfaceCopyScratch;
 }
 
 /**
@@ -952,23 +1408,52 @@ function applySurfaceToCache(msg) {
         return;
     }
     
-    // Extract pixel data from surface
-    const imageData = surface.ctx.getImageData(msg.x, msg.y, msg.w, msg.h);
+    // Replacing a slot releases its bitmap/texture
+    removeCacheEntry(msg.cacheSlot);
+    
+    if (msg.w === 0 || msg.h === 0) return;
     
-    // Store in cache
     const entry = {
-        imageData: imageData,
+        bitmap: null,
+        pending: null,
+        gl: null,
+        bytes: msg.w * msg.h * 4,
         sourceSurface: msg.surfaceId,
         sourceRect: { x: msg.x, y: msg.y, w: msg.w, h: msg.h },
         frameId: currentFrameId
     };
+    
+    if (surface.gl) {
+        entry.gl = glCompositor.createCacheEntry(surface.gl, msg.x, msg.y, msg.w, msg.h);
+    } else {
+        // createImageBitmap copies the canvas rect synchronously (no readback to
+        // the CPU); the promise only hands over the bitmap, so later surface
+        // writes can't leak into the entry.
+        entry.pending = createImageBitmap(surface.canvas, msg.x, msg.y, msg.w, msg.h).then(
+            (bitmap) => {
+                entry.pending = null;
+                if (entry.released) {
+                    bitmap.close();
+                } else {
+                    entry.bitmap = bitmap;
+                }
+            },
+            (err) => {
+                entry.pending = null;
+                console.warn(`[CACHE] SurfaceToCache: createImageBitmap failed for slot ${msg.cacheSlot}:`, err);
+            }
+        );
+    }
+    
     bitmapCache.set(msg.cacheSlot, entry);
+    cacheBytes += entry.bytes;
+    trimCache();
 }
 
 /**
  * Cache-to-surface blit: retrieve cached bitmap and draw to surface
  */
-function applyCacheToSurface(msg) {
+async function applyCacheToSurface(msg) {
     const surface = surfaces.get(msg.surfaceId);
     if (!surface) {
         console.warn(`[CACHE] CacheToSurface: unknown surface ${msg.surfaceId}`);
@@ -981,11 +1466,68 @@ function applyCacheToSurface(msg) {
         return;
     }
     
-    // Track that this surface was updated in the current frame
-    frameUpdatedSurfaces.add(msg.surfaceId);
+    // Most recently used slots live at the end of the Map
+    bitmapCache.delete(msg.cacheSlot);
+    bitmapCache.set(msg.cacheSlot, entry);
+    
+    // Track the damaged rect for endFrame compositing
+    addSurfaceDamage(surface, msg.dstX, msg.dstY, entry.sourceRect.w, entry.sourceRect.h);
     
     // Draw cached bitmap to surface at destination position
-    surface.ctx.putImageData(entry.imageData, msg.dstX, msg.dstY);
+    if (surface.gl) {
+        if (entry.gl) {
+            glCompositor.drawTexture(entry.gl, surface.gl, msg.dstX, msg.dstY);
+        }
+        return;
+    }
+    
+    if (!entry.bitmap && entry.pending) {
+        // Only when the slot is used within the same task it was filled in
+        await entry.pending;
+    }
+    if (entry.bitmap) {
+        surface.ctx.drawImage(entry.bitmap, msg.dstX, msg.dstY);
+    }
+}
+
+/**
+ * Remove a cache slot and release the bitmap/texture it holds
+ */
+function removeCacheEntry(cacheSlot) {
+    const entry = bitmapCache.get(cacheSlot);
+    if (!entry) return;
+    
+    bitmapCache.delete(cacheSlot);
+    cacheBytes -= entry.bytes;
+    releaseCacheEntry(entry);
+}
+
+/**
+ * Release GPU resources held by a cache entry
+ */
+function releaseCacheEntry(entry) {
+    entry.released = true;
+    if (entry.bitmap) {
+        entry.bitmap.close();
+        entry.bitmap = null;
+    }
+    if (entry.gl) {
+        glCompositor.deleteSurface(entry.gl);
+        entry.gl = null;
+    }
+}
+
+/**
+ * Evict least recently used slots until the cache fits its budget.
+ * The server tracks the same budget and normally evicts first, so this
+ * only fires if the two disagree - log it, a later C2S to the slot will miss.
+ */
+function trimCache() {
+    for (const cacheSlot of bitmapCache.keys()) {
+        if (cacheBytes <= cacheBudgetBytes) break;
+        console.warn(`[CACHE] Over budget (${cacheBytes} > ${cacheBudgetBytes} bytes), evicting LRU slot ${cacheSlot}`);
+        removeCacheEntry(cacheSlot);
+    }
 }
 
 /**
@@ -994,7 +1536,7 @@ function applyCacheToSurface(msg) {
  * wants to invalidate a cache slot.
  */
 function applyEvictCache(msg) {
-    bitmapCache.delete(msg.cacheSlot);
+    removeCacheEntry(msg.cacheSlot);
 }
 
 /**
@@ -1002,12 +1544,33 @@ function applyEvictCache(msg) {
  */
 function resetCacheState() {
     const cacheSize = bitmapCache.size;
+    for (const entry of bitmapCache.values()) {
+        releaseCacheEntry(entry);
+    }
     bitmapCache.clear();
+    cacheBytes = 0;
     if (cacheSize > 0) {
         console.log(`[GFX Worker] Reset: cleared ${cacheSize} cache entries`);
     }
 }
 
+/**
+ * The WebGL context came back after a loss: every surface and cache texture
+ * is gone. Drop them all and let the main thread resync the session, which
+ * resends the GFX state (or reconnects when the server needs the cache).
+ */
+function handleGlContextRestored() {
+    resetCacheState();
+    for (const surfaceId of surfaces.keys()) {
+        deleteSurface(surfaceId);
+    }
+    mappedSurfaces.clear();
+    pendingFullDamage.clear();
+    currentFrameId = null;
+    frameDamage.clear();
+    self.postMessage({ type: 'contextRestored' });
+}
+
 /**
  * Handle resetGraphics from server
  * Reset surfaces and progressive state, but NOT the bitmap cache.
@@ -1028,7 +1591,7 @@ function applyResetGraphics(msg) {
     
     // Reset frame tracking
     currentFrameId = null;
-    frameUpdatedSurfaces.clear();
+    frameDamage.clear();
     
     // Reset H.264 decoder state
     if (videoDecoder && h264Initialized) {
@@ -1051,12 +1614,7 @@ function applyResetGraphics(msg) {
     if (primaryCanvas && (primaryCanvas.width !== msg.width || primaryCanvas.height !== msg.height)) {
         primaryCanvas.width = msg.width;
         primaryCanvas.height = msg.height;
-        
-        // Per MS-RDPEGFX spec: re-apply compositor settings after resize
-        // (canvas resize clears the context state)
-        primaryCtx.imageSmoothingEnabled = false;
-        primaryCtx.fillStyle = '#000000';
-        primaryCtx.fillRect(0, 0, msg.width, msg.height);
+        resetPrimaryCanvas();
     }    
 }
 
@@ -1144,6 +1702,10 @@ function applyCapsConfirm(msg) {
 └──────────────────────────────────────────────────────────────┘
 `);
     
+    // Match the cache budget the server manages for us
+    cacheBudgetBytes = (flags & RDPGFX_CAPS_FLAG.SMALL_CACHE) ? GFX_SMALL_CACHE_BYTES : GFX_CACHE_BYTES;
+    trimCache();
+    
     // Store for potential future use
     self.gfxCaps = { version, versionStr, flags, h264Supported, h264Available, progressiveSupported, clearCodecSupported };
 }
@@ -1212,13 +1774,106 @@ function applyInitSettings(msg) {
  * Used for Progressive frames that come via H264 queue (no StartFrame/EndFrame)
  */
 function compositeSurfaceToPrimary(surfaceId) {
-    if (!primaryCanvas || !primaryCtx) return;
+    if (!primaryCanvas || (!primaryCtx && !glCompositor)) return;
     
     const surface = surfaces.get(surfaceId);
     if (!surface) return;
     
     // Draw the surface to the primary canvas
-    primaryCtx.drawImage(surface.canvas, 0, 0);
+    drawSurfaceToPrimary(surface, 0, 0);
+}
+
+/**
+ * Draw a surface onto the primary canvas with the active backend
+ */
+function drawSurfaceToPrimary(surface, outputX, outputY) {
+    if (surface.gl) {
+        glCompositor.composite(surface.gl, outputX, outputY);
+    } else {
+        primaryCtx.drawImage(surface.canvas, outputX, outputY);
+    }
+}
+
+/**
+ * Record a rect of a surface as damaged in the current frame.
+ * Rects inside an existing one are dropped; past MAX_DAMAGE_RECTS the list
+ * collapses into its bounding box.
+ */
+function addSurfaceDamage(surface, x, y, w, h) {
+    const right = Math.min(x + w, surface.width);
+    const bottom = Math.min(y + h, surface.height);
+    x = Math.max(x, 0);
+    y = Math.max(y, 0);
+    if (right <= x || bottom <= y) return;
+    
+    const rect = { x, y, w: right - x, h: bottom - y };
+    const rects = frameDamage.get(surface.id);
+    if (!rects) {
+        frameDamage.set(surface.id, [rect]);
+        return;
+    }
+    
+    for (const r of rects) {
+        if (x >= r.x && y >= r.y && right <= r.x + r.w && bottom <= r.y + r.h) {
+            return;
+        }
+    }
+    
+    if (rects.length < MAX_DAMAGE_RECTS) {
+        rects.push(rect);
+        return;
+    }
+    
+    let left = x, top = y, maxRight = right, maxBottom = bottom;
+    for (const r of rects) {
+        left = Math.min(left, r.x);
+        top = Math.min(top, r.y);
+        maxRight = Math.max(maxRight, r.x + r.w);
+        maxBottom = Math.max(maxBottom, r.y + r.h);
+    }
+    rects.length = 1;
+    rects[0] = { x: left, y: top, w: maxRight - left, h: maxBottom - top };
+}
+
+/**
+ * Composite only the damaged rects of a surface onto the primary canvas
+ */
+function compositeSurfaceDamage(surface, outputX, outputY) {
+    const rects = frameDamage.get(surface.id);
+    if (!rects) return;
+    
+    for (const r of rects) {
+        if (surface.gl) {
+            glCompositor.composite(surface.gl, outputX, outputY, r.x, r.y, r.w, r.h);
+        } else {
+            primaryCtx.drawImage(surface.canvas, r.x, r.y, r.w, r.h,
+                outputX + r.x, outputY + r.y, r.w, r.h);
+        }
+        compositeMetrics.damagedPixels += r.w * r.h;
+    }
+    compositeMetrics.damageRects += rects.length;
+    compositeMetrics.surfacePixels += surface.width * surface.height;
+}
+
+/**
+ * Re-apply compositor settings and clear the primary canvas to black.
+ * Needed after init and after every resize (canvas resize clears the context state).
+ */
+function resetPrimaryCanvas() {
+    // The clear wipes every mapped surface, so the next frame redraws them whole
+    for (const surfaceId of mappedSurfaces.keys()) {
+        pendingFullDamage.add(surfaceId);
+    }
+    
+    if (glCompositor) {
+        glCompositor.resize(primaryCanvas.width, primaryCanvas.height);
+        return;
+    }
+    
+    // Per MS-RDPEGFX spec: compositor must use direct copy for final output
+    primaryCtx.imageSmoothingEnabled = false;
+    primaryCtx.fillStyle = '#000000';
+    primaryCtx.fillRect(0, 0, primaryCanvas.width, primaryCanvas.height);
 }
 
 /**
@@ -1226,7 +1881,7 @@ function compositeSurfaceToPrimary(surfaceId) {
  */
 function startFrame(frameId) {
     currentFrameId = frameId;
-    frameUpdatedSurfaces.clear();
+    frameDamage.clear();
 }
 
 /**
@@ -1237,13 +1892,25 @@ async function endFrame(frameId) {
         console.warn(`[GFX Worker] Frame mismatch: expected ${currentFrameId}, got ${frameId}`);
     }
 
-    // Composite all mapped surfaces that were updated in this frame to primary canvas
+    compositeMetrics.damagedPixels = 0;
+    compositeMetrics.surfacePixels = 0;
+    compositeMetrics.damageRects = 0;
+
+    for (const surfaceId of pendingFullDamage) {
+        const surface = surfaces.get(surfaceId);
+        if (surface) {
+            addSurfaceDamage(surface, 0, 0, surface.width, surface.height);
+        }
+    }
+    pendingFullDamage.clear();
+
+    // Composite the damaged rects of mapped surfaces updated in this frame to primary canvas
     // Per MS-RDPEGFX: Each mapped surface is drawn at its (outputX, outputY) position
-    if (primaryCanvas && primaryCtx) {
+    if (primaryCanvas && (primaryCtx || glCompositor)) {
         
         // Get all mapped surfaces that were updated, sorted by surface ID for consistent z-order
         const updatedMappedSurfaces = [];
-        for (const surfaceId of frameUpdatedSurfaces) {
+        for (const surfaceId of frameDamage.keys()) {
             if (mappedSurfaces.has(surfaceId)) {
                 updatedMappedSurfaces.push(surfaceId);
             }
@@ -1257,28 +1924,32 @@ async function endFrame(frameId) {
                 const surface = surfaces.get(surfaceId);
                 const mapping = mappedSurfaces.get(surfaceId);
                 if (surface && mapping) {
-                    // Draw surface at its mapped output position
-                    primaryCtx.drawImage(surface.canvas, mapping.outputX, mapping.outputY);
+                    // Draw damaged rects at the surface's mapped output position
+                    compositeSurfaceDamage(surface, mapping.outputX, mapping.outputY);
                 }
             }
-        } else if (frameUpdatedSurfaces.size > 0) {
+        } else if (frameDamage.size > 0) {
             // Fallback for unmapped surfaces: try primarySurfaceId or any updated surface at (0,0)
             // This handles edge cases where surfaces weren't explicitly mapped
-            if (primarySurfaceId !== null && frameUpdatedSurfaces.has(primarySurfaceId)) {
+            if (primarySurfaceId !== null && frameDamage.has(primarySurfaceId)) {
                 const surface = surfaces.get(primarySurfaceId);
                 if (surface) {
-                    primaryCtx.drawImage(surface.canvas, 0, 0);
+                    compositeSurfaceDamage(surface, 0, 0);
                 }
             } else {
-                const sortedSurfaces = Array.from(frameUpdatedSurfaces).sort((a, b) => a - b);
+                const sortedSurfaces = Array.from(frameDamage.keys()).sort((a, b) => a - b);
                 for (const surfaceId of sortedSurfaces) {
                     const surface = surfaces.get(surfaceId);
                     if (surface) {
-                        primaryCtx.drawImage(surface.canvas, 0, 0);
+                        compositeSurfaceDamage(surface, 0, 0);
                     }
                 }
             }
         }
+        
+        if (glCompositor) {
+            glCompositor.present();
+        }
     } else {
         console.warn(`[GFX Worker] EndFrame: No primary canvas! primaryCanvas=${!!primaryCanvas} primaryCtx=${!!primaryCtx}`);
     }
@@ -1287,26 +1958,72 @@ async function endFrame(frameId) {
     lastCompletedFrameId = frameId;
     
     currentFrameId = null;
-    frameUpdatedSurfaces.clear();
+    frameDamage.clear();
     
     // Increment decoded counter and send frame acknowledgment with queue depth
     // queueDepth = pendingOps (number of unprocessed decode operations)
     // Per MS-RDPEGFX 2.2.3.3, this enables server-side adaptive rate control
     totalFramesDecoded++;
     const ackMsg = buildFrameAck(frameId, totalFramesDecoded, pendingOps);
-    self.postMessage({ type: 'frameAck', frameId, totalFramesDecoded, queueDepth: pendingOps, data: ackMsg.buffer }, [ackMsg.buffer]);
+    self.postMessage({
+        type: 'frameAck', frameId, totalFramesDecoded, queueDepth: pendingOps,
+        metrics: {
+            damagedPixels: compositeMetrics.damagedPixels,
+            surfacePixels: compositeMetrics.surfacePixels,
+            damageRects: compositeMetrics.damageRects
+        },
+        data: ackMsg.buffer
+    }, [ackMsg.buffer]);
 }
 
 // ============================================================================
 // Message handling
 // ============================================================================
 
+/**
+ * Inflate a raw-deflate batch payload
+ * @returns {Promise<Uint8Array>}
+ */
+async function inflateBatchPayload(payload, rawLen) {
+    const stream = new Blob([payload]).stream().pipeThrough(new DecompressionStream('deflate-raw'));
+    const inflated = new Uint8Array(await new Response(stream).arrayBuffer());
+    if (inflated.length !== rawLen) {
+        console.warn(`[GFX Worker] Batch inflated to ${inflated.length} bytes, expected ${rawLen}`);
+    }
+    return inflated;
+}
+
+/**
+ * Apply the sub-messages of a BTCH container in order
+ */
+async function handleBatch(msg, entry) {
+    if (entry && entry.batch) {
+        for (const sub of entry.batch) {
+            await handleBinaryMessage(sub.data, sub);
+        }
+        return;
+    }
+    
+    const payload = (msg.flags & BATCH_FLAG_DEFLATE)
+        ? await inflateBatchPayload(msg.payload, msg.rawLen)
+        : msg.payload;
+    const messages = splitBatchPayload(payload, msg.count);
+    if (!messages) {
+        console.warn(`[GFX Worker] Truncated batch (${msg.count} messages, ${payload.length} bytes)`);
+        return;
+    }
+    for (const sub of messages) {
+        await handleBinaryMessage(sub);
+    }
+}
+
 /**
  * Handle binary message from main thread
+ * @param {ArrayBuffer|Uint8Array} data - Whole message (batch sub-messages are views)
  */
-async function handleBinaryMessage(data) {
-    const bytes = new Uint8Array(data);
-    const msg = parseMessage(bytes);
+async function handleBinaryMessage(data, entry = null) {
+    const bytes = data instanceof Uint8Array ? data : new Uint8Array(data);
+    const msg = (entry && entry.parsed) || parseMessage(bytes);
     
     if (!msg) {
         // Unknown message type - log for debugging
@@ -1315,6 +2032,18 @@ async function handleBinaryMessage(data) {
         return false;
     }
     
+    // Batched tiles and copies must land before anything else touches the surfaces
+    const batchCodec = batchedTileCodec(msg);
+    if (batchCodec !== 'clearcodec') {
+        flushClearCodecTiles();
+    }
+    if (batchCodec !== 'progressive') {
+        flushProgressiveTiles();
+    }
+    if (msg.type !== 'surfaceToSurface') {
+        flushSurfaceCopies();
+    }
+    
     switch (msg.type) {
         case 'createSurface':
             createSurface(msg.surfaceId, msg.width, msg.height, msg.format);
@@ -1341,7 +2070,7 @@ async function handleBinaryMessage(data) {
             if (msg.codec === 'progressive') {
                 decodeProgressiveTile(msg);
             } else if (msg.codec === 'webp') {
-                await decodeWebPTile(msg);
+                await decodeWebPTile(msg, entry && entry.decodeJob);
             } else if (msg.codec === 'raw') {
                 drawRawTile(msg);
             } else if (msg.codec === 'clearcodec') {
@@ -1364,7 +2093,7 @@ async function handleBinaryMessage(data) {
             break;
 
         case 'cacheToSurface':
-            applyCacheToSurface(msg);
+            await applyCacheToSurface(msg);
             break;
 
         case 'evictCache':
@@ -1383,6 +2112,10 @@ async function handleBinaryMessage(data) {
             applyInitSettings(msg);
             break;
 
+        case 'batch':
+            await handleBatch(msg, entry);
+            break;
+
         case 'videoFrame':
             // Execute immediately in arrival order (strict ordering like FreeRDP)
             if (msg.codecId === CODEC_ID.PROGRESSIVE || msg.codecId === CODEC_ID.PROGRESSIVE_V2) {
@@ -1395,7 +2128,6 @@ async function handleBinaryMessage(data) {
                     h: msg.destH,
                     payload: msg.nalData,
                 });
-                frameUpdatedSurfaces.add(msg.surfaceId);
                 currentFrameId = msg.frameId;
             } else {
                 await decodeH264Frame(msg);
@@ -1421,22 +2153,38 @@ async function handleBinaryMessage(data) {
 async function processMessage(event) {
     const { type, data } = event;
     
+    // Binary messages flush pending batches themselves (see handleBinaryMessage)
+    if (type !== 'binary') {
+        flushPendingBatches();
+    }
+    
     switch (type) {
         case 'init':
             // Initialize with primary canvas (sync, no queue needed)
             primaryCanvas = data.canvas;
-            primaryCtx = primaryCanvas.getContext('2d', { 
-                alpha: false,
-                desynchronized: false,    // slower performance, but no weird artifacts (could be enabled later)
-                willReadFrequently: true  // For getImageData operations
-            });
             
-            // Per MS-RDPEGFX spec: compositor must use direct copy for final output
-            primaryCtx.imageSmoothingEnabled = false;
+            // Optional WebGL2 backend; falls back to 2D if unavailable
+            if (data.renderer === 'webgl2') {
+                glCompositor = WebGLCompositor.create(primaryCanvas);
+                if (!glCompositor) {
+                    console.warn('[GFX Worker] WebGL2 unavailable, using 2D canvas backend');
+                } else {
+                    glCompositor.onContextRestored = handleGlContextRestored;
+                }
+            }
+            
+            if (!glCompositor) {
+                // No willReadFrequently: the primary canvas is only read back by
+                // screenshots (convertToBlob), so it stays GPU-backed
+                primaryCtx = primaryCanvas.getContext('2d', { 
+                    alpha: false,
+                    desynchronized: false     // slower performance, but no weird artifacts (could be enabled later)
+                });
+            }
             
             // Fill with black initially
-            primaryCtx.fillStyle = '#000000';
-            primaryCtx.fillRect(0, 0, primaryCanvas.width, primaryCanvas.height);
+            resetPrimaryCanvas();
+            console.log(`[GFX Worker] Compositor backend: ${glCompositor ? 'webgl2' : '2d'}`);
             
             // Don't pre-create surface 0 here - let the server create surfaces
             // via CreateSurface messages. Pre-creating causes conflicts when 
@@ -1444,13 +2192,13 @@ async function processMessage(event) {
             // primarySurfaceId will be set when server maps a surface to output.
             
             // WASM already loaded during worker startup
-            self.postMessage({ type: 'ready', wasmReady });
+            self.postMessage({ type: 'ready', wasmReady, renderer: glCompositor ? 'webgl2' : '2d' });
             break;
             
         case 'binary':
             // Binary message from WebSocket - process in order
             if (data instanceof ArrayBuffer) {
-                const handled = await handleBinaryMessage(data);
+                const handled = await handleBinaryMessage(data, event);
                 if (!handled) {
                     // Forward unhandled to main thread
                     self.postMessage({ type: 'unhandled', data }, [data]);
@@ -1465,19 +2213,14 @@ async function processMessage(event) {
                 if (primaryCanvas.width !== data.width || primaryCanvas.height !== data.height) {
                     primaryCanvas.width = data.width;
                     primaryCanvas.height = data.height;
-                    
-                    // Per MS-RDPEGFX spec: re-apply compositor settings after resize
-                    // (canvas resize clears the context state)
-                    primaryCtx.imageSmoothingEnabled = false;
-                    primaryCtx.fillStyle = '#000000';
-                    primaryCtx.fillRect(0, 0, data.width, data.height);
+                    resetPrimaryCanvas();
                     
                     console.log(`[GFX Worker] Primary canvas resized to ${data.width}x${data.height}`);
                 }
             }
             if (primarySurfaceId !== null) {
                 const existing = surfaces.get(primarySurfaceId);
-                if (!existing || existing.canvas.width !== data.width || existing.canvas.height !== data.height) {
+                if (!existing || existing.width !== data.width || existing.height !== data.height) {
                     createSurface(primarySurfaceId, data.width, data.height);
                 }
             }
@@ -1496,6 +2239,7 @@ async function processMessage(event) {
                 deleteSurface(surfaceId);
             }
             mappedSurfaces.clear();
+            pendingFullDamage.clear();
             console.log('[GFX Worker] Session reset complete');
             break;
             
@@ -1541,9 +2285,15 @@ async function processMessage(event) {
 /**
  * Worker onmessage handler - enqueues messages for strict sequential processing.
  * This ensures that async operations (H.264 decode, WebP decode) complete
- * before the next message is processed.
+ * before the next message is processed. WebP decodes are started earlier, on
+ * arrival (see prefetchBinaryMessage); only their results wait for the queue.
  */
 self.onmessage = (event) => {
+    // Kick off async tile decodes right away; they are applied in order
+    if (event.data.type === 'binary' && event.data.data instanceof ArrayBuffer) {
+        prefetchBinaryMessage(event.data);
+    }
+    
     // Enqueue message for sequential processing
     enqueueMessage(event.data);
 };
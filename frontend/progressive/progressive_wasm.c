@@ -156,6 +156,8 @@ void prog_free(ProgressiveContext* ctx) {
     free(ctx->cbBuffer);
     free(ctx->crBuffer);
     free(ctx->rlgrBuffer);
+    free(ctx->inputBuffer);
+    free(ctx->dirtyRects);
     free(ctx);
 }
 
@@ -445,7 +447,11 @@ static inline bool tile_intersects_clip(ProgressiveContext* ctx, uint16_t tileX,
  * multiple regions with different clipRects are in one frame).
  */
 static inline void add_updated_tile_with_cliprects(ProgressiveContext* ctx, uint32_t tileIdx) {
+    /* Called from worker threads during parallel decode */
+    pthread_mutex_lock(&queue_mutex);
+    
     if (ctx->numUpdatedTiles >= RFX_MAX_TILES_PER_SURFACE) {
+        pthread_mutex_unlock(&queue_mutex);
         return;
     }
     
@@ -479,6 +485,8 @@ static inline void add_updated_tile_with_cliprects(ProgressiveContext* ctx, uint
     }
     
     ctx->numUpdatedTiles++;
+    
+    pthread_mutex_unlock(&queue_mutex);
 }
 
 /**
@@ -1892,3 +1900,262 @@ int prog_decompress_parallel(ProgressiveContext* ctx, const uint8_t* srcData,
     
     return 0;
 }
+
+/* ============================================================================
+ * Frame-level batch API
+ *
+ * One call per batch of messages instead of a decode call plus per-tile
+ * getters: JS appends each message's payload to the input staging buffer,
+ * writes its descriptor into the array from prog_get_frame_messages(), calls
+ * prog_decode_frame(), then reads the packed ProgDirtyRect array.
+ *
+ * Dirty rects point at tile pixel data, so a message that would re-decode a
+ * tile (or SYNC-reset a surface) referenced by earlier rects ends the batch;
+ * JS draws what it has and calls again for the rest.
+ * ============================================================================ */
+
+/**
+ * Get the input staging buffer, growing it to at least size bytes
+ * 
+ * @return Pointer valid until the next call with a larger size, NULL on OOM
+ */
+EMSCRIPTEN_KEEPALIVE
+uint8_t* prog_get_input_buffer(ProgressiveContext* ctx, uint32_t size) {
+    if (!ctx) return NULL;
+    
+    if (size > ctx->inputSize) {
+        /* Grow geometrically so bursts of slightly larger messages don't realloc each time */
+        uint32_t newSize = ctx->inputSize ? ctx->inputSize : 65536;
+        while (newSize < size) newSize *= 2;
+        
+        uint8_t* tmp = (uint8_t*)realloc(ctx->inputBuffer, newSize);
+        if (!tmp) {
+            return NULL;
+        }
+        ctx->inputBuffer = tmp;
+        ctx->inputSize = newSize;
+    }
+    
+    return ctx->inputBuffer;
+}
+
+/**
+ * Get the message descriptor array (PROG_MAX_FRAME_MESSAGES entries)
+ */
+EMSCRIPTEN_KEEPALIVE
+ProgFrameMessage* prog_get_frame_messages(ProgressiveContext* ctx) {
+    return ctx ? ctx->frameMessages : NULL;
+}
+
+/**
+ * Get the dirty rects produced by the last prog_decode_frame() call
+ * The array may move between calls - fetch it again after each decode.
+ */
+EMSCRIPTEN_KEEPALIVE
+ProgDirtyRect* prog_get_dirty_rects(ProgressiveContext* ctx) {
+    return ctx ? ctx->dirtyRects : NULL;
+}
+
+/**
+ * Get the number of dirty rects produced by the last prog_decode_frame() call
+ */
+EMSCRIPTEN_KEEPALIVE
+uint32_t prog_get_dirty_rect_count(ProgressiveContext* ctx) {
+    return ctx ? ctx->numDirtyRects : 0;
+}
+
+static bool push_dirty_rect(ProgressiveContext* ctx, RfxTile* tile, uint16_t surfaceId,
+                            uint32_t dstX, uint32_t dstY, uint32_t width, uint32_t height) {
+    if (ctx->numDirtyRects >= ctx->dirtyRectCapacity) {
+        uint32_t newCapacity = ctx->dirtyRectCapacity ? ctx->dirtyRectCapacity * 2 : 256;
+        ProgDirtyRect* tmp = (ProgDirtyRect*)realloc(ctx->dirtyRects,
+                                                     newCapacity * sizeof(ProgDirtyRect));
+        if (!tmp) return false;
+        ctx->dirtyRects = tmp;
+        ctx->dirtyRectCapacity = newCapacity;
+    }
+    
+    ProgDirtyRect* rect = &ctx->dirtyRects[ctx->numDirtyRects++];
+    rect->data = tile->data;
+    rect->surfaceId = surfaceId;
+    rect->dstX = dstX;
+    rect->dstY = dstY;
+    rect->srcX = dstX - tile->x;
+    rect->srcY = dstY - tile->y;
+    rect->width = width;
+    rect->height = height;
+    return true;
+}
+
+/**
+ * Turn the updated tile list of the last decoded message into dirty rects
+ * Each tile is intersected with the clipRects active when it was decoded
+ * (FreeRDP: region16_intersect_rect per tile). Tiles decoded under no clipRects,
+ * or more than fit in the per-tile buffer, are drawn fully.
+ * 
+ * @return false if the dirty rect array could not grow (rects collected up
+ *         to that point are kept)
+ */
+static bool collect_dirty_rects(ProgressiveContext* ctx, RfxSurface* surface) {
+    for (uint32_t i = 0; i < ctx->numUpdatedTiles; i++) {
+        uint32_t tileIdx = ctx->updatedTileIndices[i];
+        if (tileIdx >= surface->gridSize) continue;
+        
+        RfxTile* tile = surface->tiles[tileIdx];
+        
+        /* Same rules as prog_get_tile_data */
+        if (!tile || !tile->dirty || !tile->valid) continue;
+        
+        uint32_t tileX = tile->x;
+        uint32_t tileY = tile->y;
+        if (tileX >= surface->width || tileY >= surface->height) continue;
+        
+        uint32_t tileRight = tileX + RFX_TILE_SIZE;
+        uint32_t tileBottom = tileY + RFX_TILE_SIZE;
+        if (tileRight > surface->width) tileRight = surface->width;
+        if (tileBottom > surface->height) tileBottom = surface->height;
+        
+        tile->batchMark = ctx->batchGen;
+        surface->batchMark = ctx->batchGen;
+        
+        uint16_t clipCount = ctx->tileClipRectCount[i];
+        if (clipCount == 0 || clipCount > 16) {
+            if (!push_dirty_rect(ctx, tile, surface->id, tileX, tileY,
+                                 tileRight - tileX, tileBottom - tileY)) {
+                return false;
+            }
+            continue;
+        }
+        
+        for (uint16_t ci = 0; ci < clipCount; ci++) {
+            const RfxRect* r = &ctx->perTileClipRects[ctx->tileClipRectStart[i] + ci];
+            uint32_t left = r->x > tileX ? r->x : tileX;
+            uint32_t top = r->y > tileY ? r->y : tileY;
+            uint32_t right = (uint32_t)r->x + r->width;
+            uint32_t bottom = (uint32_t)r->y + r->height;
+            if (right > tileRight) right = tileRight;
+            if (bottom > tileBottom) bottom = tileBottom;
+            
+            if (right > left && bottom > top &&
+                !push_dirty_rect(ctx, tile, surface->id, left, top, right - left, bottom - top)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Check whether a message would overwrite pixels referenced by this batch's
+ * dirty rects (re-decoding a referenced tile, or a SYNC reset of the surface)
+ */
+static bool message_conflicts_with_batch(const ProgressiveContext* ctx, const RfxSurface* surface,
+                                         const uint8_t* data, size_t size) {
+    if (surface->batchMark != ctx->batchGen) return false;
+    
+    size_t offset = 0;
+    while (offset + 6 <= size) {
+        uint16_t blockType = read_u16_le(data + offset);
+        uint32_t blockLen = read_u32_le(data + offset + 2);
+        
+        if (blockLen < 6 || offset + blockLen > size) break;
+        
+        const uint8_t* block = data + offset + 6;
+        size_t blockSize = blockLen - 6;
+        
+        if (blockType == PROGRESSIVE_WBT_SYNC) {
+            return true;
+        }
+        
+        if (blockType == PROGRESSIVE_WBT_REGION && blockSize >= 12) {
+            /* Same layout walk as decode_region, reading only tile positions */
+            uint16_t numRects = read_u16_le(block + 1);
+            uint8_t numQuant = block[3];
+            uint8_t numProgQuant = block[4];
+            uint16_t numTiles = read_u16_le(block + 6);
+            size_t pos = 12 + (size_t)numRects * 8 + (size_t)numQuant * 5 + (size_t)numProgQuant * 16;
+            
+            for (uint16_t t = 0; t < numTiles; t++) {
+                if (pos + 6 > blockSize) break;
+                
+                uint16_t tileType = read_u16_le(block + pos);
+                uint32_t tileLen = read_u32_le(block + pos + 2);
+                
+                if (tileLen < 6 || pos + tileLen > blockSize) break;
+                
+                if ((tileType == PROGRESSIVE_WBT_TILE_SIMPLE ||
+                     tileType == PROGRESSIVE_WBT_TILE_FIRST ||
+                     tileType == PROGRESSIVE_WBT_TILE_UPGRADE) && tileLen >= 6 + 7) {
+                    uint16_t xIdx = read_u16_le(block + pos + 6 + 3);
+                    uint16_t yIdx = read_u16_le(block + pos + 6 + 5);
+                    
+                    if (xIdx < surface->gridWidth && yIdx < surface->gridHeight) {
+                        const RfxTile* tile = surface->tiles[yIdx * surface->gridWidth + xIdx];
+                        if (tile && tile->batchMark == ctx->batchGen) {
+                            return true;
+                        }
+                    }
+                }
+                
+                pos += tileLen;
+            }
+        }
+        
+        offset += blockLen;
+    }
+    
+    return false;
+}
+
+/**
+ * Decode frame messages [first, first + count) in order
+ * 
+ * Per-message results are written to the descriptors, dirty rects of all
+ * decoded messages to the dirty rect array (replacing the previous batch).
+ * A message whose rects could not all be stored gets PROG_ERR_DIRTY_RECTS
+ * and ends the batch; its tiles are decoded but only partly drawn.
+ * 
+ * @return Number of messages consumed (fewer than count if the batch had to
+ *         end early, see above), -1 on bad arguments
+ */
+EMSCRIPTEN_KEEPALIVE
+int prog_decode_frame(ProgressiveContext* ctx, uint32_t first, uint32_t count) {
+    if (!ctx || first > PROG_MAX_FRAME_MESSAGES || count > PROG_MAX_FRAME_MESSAGES - first) {
+        return -1;
+    }
+    
+    /* New batch generation; 0 is never used so fresh tiles don't match */
+    if (++ctx->batchGen == 0) ctx->batchGen = 1;
+    ctx->numDirtyRects = 0;
+    
+    uint32_t consumed = 0;
+    for (; consumed < count; consumed++) {
+        ProgFrameMessage* msg = &ctx->frameMessages[first + consumed];
+        
+        if (!ctx->inputBuffer || msg->surfaceId >= RFX_MAX_SURFACES ||
+            msg->srcOffset > ctx->inputSize || msg->srcSize > ctx->inputSize - msg->srcOffset) {
+            msg->result = -1;
+            continue;
+        }
+        
+        const uint8_t* data = ctx->inputBuffer + msg->srcOffset;
+        RfxSurface* surface = ctx->surfaces[msg->surfaceId];
+        
+        if (surface && consumed > 0 && message_conflicts_with_batch(ctx, surface, data, msg->srcSize)) {
+            break;
+        }
+        
+        msg->result = prog_decompress_parallel(ctx, data, msg->srcSize,
+                                               (uint16_t)msg->surfaceId, msg->frameId);
+        
+        if (msg->result == 0 && surface && !collect_dirty_rects(ctx, surface)) {
+            /* Out of memory: end the batch so JS draws what was collected;
+             * the next call starts a fresh (already allocated) array */
+            msg->result = PROG_ERR_DIRTY_RECTS;
+            consumed++;
+            break;
+        }
+    }
+    
+    return (int)consumed;
+}
@@ -20,6 +20,12 @@
 #define RFX_MAX_SURFACES 256
 #define RFX_MAX_TILES_PER_SURFACE 16384
 
+/* Maximum messages per prog_decode_frame() call */
+#define PROG_MAX_FRAME_MESSAGES 64
+
+/* ProgFrameMessage.result: decoded, but the dirty rect array could not grow */
+#define PROG_ERR_DIRTY_RECTS -2
+
 /* Progressive block types */
 #define PROGRESSIVE_WBT_SYNC          0xCCC0
 #define PROGRESSIVE_WBT_FRAME_BEGIN   0xCCC1
@@ -118,6 +124,9 @@ typedef struct {
      * Set to true after TILE_FIRST decode, false after SYNC/CONTEXT reset.
      * TILE_UPGRADE should skip tiles with valid=false to avoid refining garbage. */
     bool valid;
+    
+    /* prog_decode_frame() batch whose dirty rects point at this tile's data */
+    uint32_t batchMark;
 } RfxTile;
 
 /* Surface context */
@@ -134,8 +143,30 @@ typedef struct {
     
     /* Last frame ID processed */
     uint32_t frameId;
+    
+    /* prog_decode_frame() batch with dirty rects on this surface */
+    uint32_t batchMark;
 } RfxSurface;
 
+/* Message descriptor written by JS for prog_decode_frame() (5 x u32) */
+typedef struct {
+    uint32_t surfaceId;
+    uint32_t frameId;
+    uint32_t srcOffset;   /* Payload offset in the input staging buffer */
+    uint32_t srcSize;
+    int32_t result;       /* Set by prog_decode_frame(): 0 ok, -1 error, PROG_ERR_DIRTY_RECTS */
+} ProgFrameMessage;
+
+/* Dirty rect produced by prog_decode_frame() (8 x u32 on wasm32)
+ * Already intersected with the clipRects active when the tile was decoded. */
+typedef struct {
+    uint8_t* data;        /* Tile RGBA pixels (64x64, stride 256) */
+    uint32_t surfaceId;
+    uint32_t dstX, dstY;  /* Rect position on the surface */
+    uint32_t srcX, srcY;  /* Rect position within the tile */
+    uint32_t width, height;
+} ProgDirtyRect;
+
 /* Block state tracking flags */
 #define FLAG_WBT_SYNC        0x01
 #define FLAG_WBT_CONTEXT     0x02
@@ -199,6 +230,15 @@ typedef struct {
     /* RLGR decode buffer */
     int16_t* rlgrBuffer;
     size_t rlgrBufferSize;
+    
+    /* Frame-level batch API: staged payloads and descriptors in, dirty rects out */
+    uint8_t* inputBuffer;
+    uint32_t inputSize;
+    ProgFrameMessage frameMessages[PROG_MAX_FRAME_MESSAGES];
+    ProgDirtyRect* dirtyRects;
+    uint32_t numDirtyRects;
+    uint32_t dirtyRectCapacity;
+    uint32_t batchGen;
 } ProgressiveContext;
 
 /* Inline utilities */
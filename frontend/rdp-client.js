@@ -29,14 +29,24 @@
  */
 
 import { resolveTheme, themeToCssVars, sanitizeTheme, fontsToCss, themes } from './rdp-themes.js';
-import { Magic, matchMagic, parsePointerPosition, parsePointerSystem, parsePointerSet } from './wire-format.js';
+import {
+    Magic, matchMagic, parsePointerPosition, parsePointerSystem, parsePointerSet, parsePointerCached,
+    encodeMouseInput, encodeKeyInput, buildInputBatch
+} from './wire-format.js';
 import { RDPSecurityPolicy } from './rdp-security.js';
+import { WebTransportSocket, isWebTransportSupported } from './rdp-transport.js';
 
 // ============================================================
 // BASE URL - Compute the directory containing this script for dynamic resource loading
 // ============================================================
 const RDP_CLIENT_BASE_URL = new URL('./', import.meta.url).href;
 
+// Predicted pointer positions remembered for matching server echoes (PPOS)
+const POINTER_ECHO_HISTORY = 32;
+
+// Converted cursors kept for PCUR reuse (server assigns at most 32 slots)
+const CURSOR_CACHE_MAX = 64;
+
 // ============================================================
 // STYLES - Shadow DOM isolated styles (uses CSS custom properties for theming)
 // ============================================================
@@ -264,6 +274,20 @@ const STYLES = `
     filter: drop-shadow(1px 1px 2px rgba(0, 0, 0, 0.7));
 }
 
+/* Local Cursor Overlay - remote cursor bitmap drawn at the predicted position
+   while the pointer is locked (the OS cursor is hidden) */
+.rdp-local-cursor {
+    position: absolute;
+    pointer-events: none;
+    z-index: 100;
+    display: none;
+    image-rendering: pixelated;
+}
+
+.rdp-local-cursor.visible {
+    display: block;
+}
+
 .rdp-loading {
     position: absolute;
     top: 50%;
@@ -548,6 +572,9 @@ const TEMPLATE = `
                 </svg>
             </div>
             
+            <!-- Local Cursor Overlay - remote cursor bitmap while pointer is locked -->
+            <img class="rdp-local-cursor" alt="" draggable="false">
+            
             <!-- Virtual Keyboard Overlay -->
             <div class="rdp-keyboard-overlay">
                 <div class="rdp-keyboard-titlebar">
@@ -708,13 +735,17 @@ export class RDPClient {
      * @param {HTMLElement} container - Container element to attach to
      * @param {Object} options - Configuration options
      * @param {string} [options.wsUrl='ws://localhost:8765'] - WebSocket server URL
+     * @param {'websocket'|'webtransport'} [options.transport='websocket'] - Transport ('webtransport' falls back to WebSocket if unsupported)
+     * @param {string} [options.webTransportUrl=null] - WebTransport endpoint, e.g. 'https://host:4433/rdp'
+     * @param {Array<{algorithm: string, value: BufferSource}>} [options.serverCertificateHashes=null] - Pin a self-signed WebTransport certificate
      * @param {boolean} [options.showTopBar=true] - Show top toolbar
      * @param {boolean} [options.showBottomBar=true] - Show bottom status bar
-     * @param {number} [options.reconnectDelay=3000] - Reconnection delay in ms
+     * @param {number} [options.reconnectDelay=3000] - Delay in ms between session resume attempts after the connection drops
      * @param {boolean} [options.keepConnectionModalOpen=false] - Keep connection modal open when disconnected (cannot be closed)
      * @param {boolean} [options.loadingSpinnerOpensModal=true] - Whether clicking the loading area opens the connection modal
      * @param {number} [options.minWidth=0] - Minimum canvas width in pixels (0 = no minimum, scrollbar appears if container is smaller)
      * @param {number} [options.minHeight=0] - Minimum canvas height in pixels (0 = no minimum, scrollbar appears if container is smaller)
+     * @param {'2d'|'webgl2'} [options.renderer='2d'] - GFX compositor backend ('webgl2' falls back to '2d' if unavailable)
      * @param {import('./rdp-themes.js').RDPTheme} [options.theme] - Theme configuration
      * @param {import('./rdp-security.js').SecurityPolicy} [options.securityPolicy] - Security policy for connection restrictions
      * @param {Object} [options.visibleTopBarButtons] - Control visibility of top bar buttons
@@ -732,6 +763,9 @@ export class RDPClient {
         
         this.options = {
             wsUrl: 'ws://localhost:8765',
+            transport: 'websocket',        // 'websocket' or 'webtransport'
+            webTransportUrl: null,         // https://host:port/rdp (required for 'webtransport')
+            serverCertificateHashes: null, // Self-signed WebTransport cert pinning
             showTopBar: true,
             showBottomBar: true,
             reconnectDelay: 3000,
@@ -741,6 +775,8 @@ export class RDPClient {
             loadingSpinnerOpensModal: true,
             minWidth: 0,    // Minimum canvas width (0 = no minimum, scrollbar appears if container is smaller)
             minHeight: 0,   // Minimum canvas height (0 = no minimum, scrollbar appears if container is smaller)
+            renderer: '2d', // GFX compositor backend: '2d' or 'webgl2'
+            pointerLock: false, // Lock the mouse to the canvas on click and send relative motion
             theme: null,
             visibleTopBarButtons: {
                 connect: true,
@@ -878,12 +914,29 @@ export class RDPClient {
         this._canvas = null;
         this._ctx = null;
         this._lastMouseSend = 0;
+        this._inputRecords = [];             // Pending INPT records (flushed per animation frame)
+        this._inputFlushFrame = null;        // requestAnimationFrame id for pending flush
+        this._pointerLocked = false;         // Pointer lock active (relative input)
+        this._pointerPos = { x: 0, y: 0 };   // Last absolute pointer position (remote pixels)
+        this._relRemainder = { x: 0, y: 0 }; // Sub-pixel motion carried between relative moves
+        this._cursorImage = null;            // Current remote cursor {url, width, height, hotspotX, hotspotY}
+        this._cursorCache = new Map();       // Cursor cache slot -> converted cursor (LRU order)
+        this._cursorHidden = false;          // Server set the NULL system pointer
+        this._recentPointerPositions = [];   // Predicted positions recently sent (echo suppression)
         this._pingStart = 0;
         this._lastLatency = null;
         this._resizeTimeout = null;
         this._lastRequestedWidth = 0;
         this._lastRequestedHeight = 0;
         
+        // Session resume after an unexpected close (see _scheduleResume)
+        this._resumeToken = null;            // From 'connected'; null when the server does not keep sessions
+        this._resumeGrace = 0;               // Seconds the server keeps a dropped session
+        this._resumeDeadline = 0;            // performance.now() deadline while resuming, 0 otherwise
+        this._resumeTimer = null;
+        this._resumeCounts = { gfx: 0, cursor: 0 }; // Binary messages received this session
+        this._unsentFrameAcks = [];          // FACKs produced while resuming
+        
         // Audio state - AudioWorklet low-latency system
         this._audioContext = null;
         this._audioGainNode = null;
@@ -911,6 +964,15 @@ export class RDPClient {
         this._pendingGfxMessages = [];
         this._wasmAvailable = false;  // Set by GFX worker on load
         
+        // GFX compositing metrics (accumulated from worker frame acks)
+        this._gfxMetrics = {
+            frames: 0,
+            damagedPixels: 0,
+            surfacePixels: 0,
+            lastFrameDamagedPixels: 0,
+            lastFrameDamageRects: 0
+        };
+        
         // Screenshot pending requests
         this._screenshotRequests = new Map();
         this._screenshotRequestId = 0;
@@ -975,6 +1037,7 @@ export class RDPClient {
             overflowDropdown: $('.rdp-overflow-dropdown'),
             // API cursor overlay
             apiCursor: $('.rdp-api-cursor'),
+            localCursor: $('.rdp-local-cursor'),
         };
         
         // Apply button visibility based on visibleTopBarButtons option
@@ -1370,7 +1433,7 @@ export class RDPClient {
                 
             case 'ready':
                 this._gfxWorkerReady = true;
-                console.log('[RDPClient] GFX Worker ready, WASM:', msg.wasmReady);
+                console.log('[RDPClient] GFX Worker ready, WASM:', msg.wasmReady, 'renderer:', msg.renderer);
                 // Flush pending messages
                 for (const pending of this._pendingGfxMessages) {
                     this._gfxWorker.postMessage(pending.msg, pending.transfer);
@@ -1379,10 +1442,28 @@ export class RDPClient {
                 break;
                 
             case 'frameAck':
-                // Send frame acknowledgment back to server
-                if (this._ws && this._ws.readyState === WebSocket.OPEN && msg.data) {
+                // Send frame acknowledgment back to server (held while resuming,
+                // the server must ack every frame the browser decoded)
+                if (msg.data && this._resumeDeadline) {
+                    this._unsentFrameAcks.push(msg.data);
+                    if (this._unsentFrameAcks.length > 64) this._unsentFrameAcks.shift();
+                } else if (this._ws && this._ws.readyState === WebSocket.OPEN && msg.data) {
                     this._ws.send(msg.data);
                 }
+                if (msg.metrics) {
+                    const m = this._gfxMetrics;
+                    m.frames++;
+                    m.damagedPixels += msg.metrics.damagedPixels;
+                    m.surfacePixels += msg.metrics.surfacePixels;
+                    m.lastFrameDamagedPixels = msg.metrics.damagedPixels;
+                    m.lastFrameDamageRects = msg.metrics.damageRects;
+                }
+                break;
+                
+            case 'contextRestored':
+                // WebGL context was lost and restored: the worker has no
+                // surfaces or cache left, so resync as if nothing was received
+                this._resyncGraphics();
                 break;
                 
             case 'unhandled':
@@ -1413,14 +1494,17 @@ export class RDPClient {
     
     /**
      * Set a custom cursor from server-provided BGRA bitmap data
-     * Uses CSS cursor with data URL for cursors up to 128x128 (browser limit)
+     * Uses CSS cursor with data URL for cursors up to 128x128 (browser limit).
+     * The converted cursor is kept under cacheId so a later PCUR message can
+     * reselect it without the server resending pixels.
      * @param {number} width - Cursor width in pixels
      * @param {number} height - Cursor height in pixels
      * @param {number} hotspotX - Hotspot X offset
      * @param {number} hotspotY - Hotspot Y offset
+     * @param {number} cacheId - Cursor cache slot assigned by the server
      * @param {Uint8Array} bgraData - BGRA pixel data (4 bytes per pixel)
      */
-    _setCustomCursor(width, height, hotspotX, hotspotY, bgraData) {
+    _setCustomCursor(width, height, hotspotX, hotspotY, cacheId, bgraData) {
         try {
             // Create temporary canvas to convert BGRA to image
             const cursorCanvas = document.createElement('canvas');
@@ -1449,15 +1533,47 @@ export class RDPClient {
             const hx = Math.max(0, Math.min(hotspotX, width - 1));
             const hy = Math.max(0, Math.min(hotspotY, height - 1));
             
-            // CSS cursor format: url(data:...), hotspot-x, hotspot-y, fallback
-            // Note: Some browsers limit cursor size to 128x128
-            this._canvas.style.cursor = `url(${dataUrl}) ${hx} ${hy}, auto`;
+            const cursor = { url: dataUrl, width, height, hotspotX: hx, hotspotY: hy };
+            this._cursorCache.delete(cacheId);
+            this._cursorCache.set(cacheId, cursor);
+            if (this._cursorCache.size > CURSOR_CACHE_MAX) {
+                this._cursorCache.delete(this._cursorCache.keys().next().value);
+            }
+            this._applyCursor(cursor);
         } catch (err) {
             console.warn('[RDPClient] Failed to set custom cursor:', err);
             this._canvas.style.cursor = 'default';
         }
     }
     
+    /**
+     * Switch to a cursor previously delivered by PSET
+     * @param {number} cacheId - Cursor cache slot
+     */
+    _useCachedCursor(cacheId) {
+        const cursor = this._cursorCache.get(cacheId);
+        if (!cursor) {
+            console.warn(`[RDPClient] Cursor cache miss for slot ${cacheId}`);
+            this._canvas.style.cursor = 'default';
+            return;
+        }
+        // Keep Map order as LRU
+        this._cursorCache.delete(cacheId);
+        this._cursorCache.set(cacheId, cursor);
+        this._applyCursor(cursor);
+    }
+    
+    _applyCursor(cursor) {
+        // CSS cursor format: url(data:...), hotspot-x, hotspot-y, fallback
+        // Note: Some browsers limit cursor size to 128x128
+        this._canvas.style.cursor = `url(${cursor.url}) ${cursor.hotspotX} ${cursor.hotspotY}, auto`;
+        this._cursorImage = cursor;
+        this._cursorHidden = false;
+        if (this._pointerLocked) {
+            this._showLocalCursor(this._pointerPos.x, this._pointerPos.y);
+        }
+    }
+    
     /**
      * Initialize GFX worker canvas when connected
      */
@@ -1474,7 +1590,7 @@ export class RDPClient {
             
             this._gfxWorker.postMessage({
                 type: 'init',
-                data: { canvas: offscreen, width, height }
+                data: { canvas: offscreen, width, height, renderer: this.options.renderer }
             }, [offscreen]);
             
             console.log('[RDPClient] Canvas transferred to GFX Worker');
@@ -1531,12 +1647,16 @@ export class RDPClient {
 
         // Canvas interactions
         this._canvas.setAttribute('tabindex', '0');
-        this._canvas.addEventListener('click', () => this._canvas.focus());
+        this._canvas.addEventListener('click', () => this._handleCanvasClick());
         this._canvas.addEventListener('mousemove', (e) => this._handleMouseMove(e));
         this._canvas.addEventListener('mousedown', (e) => this._handleMouseDown(e));
         this._canvas.addEventListener('mouseup', (e) => this._handleMouseUp(e));
         this._canvas.addEventListener('wheel', (e) => this._handleMouseWheel(e));
         this._canvas.addEventListener('contextmenu', (e) => e.preventDefault());
+        
+        // Pointer lock state is reported on the document
+        this._onPointerLockChange = () => this._handlePointerLockChange();
+        document.addEventListener('pointerlockchange', this._onPointerLockChange);
 
         // Keyboard - scoped to shadow root
         this._shadow.addEventListener('keydown', (e) => this._handleKeyDown(e));
@@ -1592,10 +1712,12 @@ export class RDPClient {
             }
 
             this._pendingConnect = { resolve, reject };
+            this._resumeCounts = { gfx: 0, cursor: 0 };
+            this._unsentFrameAcks = [];
             this._updateStatus('connecting', 'Connecting...');
             this._el.loading.querySelector('p').textContent = 'Connecting...';
 
-            this._ws = new WebSocket(this.options.wsUrl);
+            this._ws = this._createSocket();
             this._ws.binaryType = 'arraybuffer';
 
             this._ws.onopen = () => {
@@ -1626,10 +1748,195 @@ export class RDPClient {
                     this._pendingConnect = null;
                 }
             };
-            this._ws.onclose = () => this._handleDisconnect();
+            const ws = this._ws;
+            this._ws.onclose = () => this._handleSocketClose(ws);
         });
     }
 
+    /**
+     * Attach to a session the server kept running after its browser went
+     * away, e.g. across a page reload. The server resends the GFX state and
+     * repaints the whole desktop.
+     * @param {string} token - Value of getResumeToken() from the earlier page
+     * @returns {Promise<void>}
+     */
+    resume(token) {
+        return new Promise((resolve, reject) => {
+            if (this._ws && this._ws.readyState === WebSocket.OPEN) {
+                reject(new Error('Already connected'));
+                return;
+            }
+            if (!token) {
+                reject(new Error('Missing resume token'));
+                return;
+            }
+
+            if (this._el.modal.classList.contains('active')) {
+                this._el.modal.classList.remove('active');
+            }
+
+            this._pendingConnect = { resolve, reject };
+            this._resumeToken = token;
+            this._resumeCounts = { gfx: 0, cursor: 0 };
+            this._unsentFrameAcks = [];
+            this._updateStatus('connecting', 'Reconnecting...');
+            this._el.loading.querySelector('p').textContent = 'Reconnecting...';
+
+            this._resumeSession();
+            this._ws.onerror = () => {
+                this._updateStatus('error', 'Connection error');
+                if (this._pendingConnect) {
+                    this._pendingConnect.reject(new Error('WebSocket error'));
+                    this._pendingConnect = null;
+                }
+            };
+        });
+    }
+
+    /**
+     * Token that lets resume() attach to this session from another page load.
+     * Treat it like a credential: anyone holding it can take over the session.
+     * @returns {string|null} Token, or null if the server does not keep sessions
+     */
+    getResumeToken() {
+        return this._isConnected ? this._resumeToken : null;
+    }
+
+    /**
+     * The socket closed. Unless the user disconnected, a session the server
+     * keeps (it sent a resume token) stays on screen and is resumed on a new
+     * socket; otherwise the client is reset.
+     * @param {WebSocket|WebTransportSocket} ws - The socket that closed
+     */
+    _handleSocketClose(ws) {
+        if (this._ws && this._ws !== ws) return;  // Superseded socket
+        if (this._resumeToken && this._isConnected && !this._pendingDisconnect) {
+            this._scheduleResume();
+            return;
+        }
+        this._handleDisconnect();
+    }
+
+    /**
+     * Retry resuming until the server's grace period is over: the first
+     * attempt is immediate, then one every options.reconnectDelay.
+     */
+    _scheduleResume() {
+        this._ws = null;
+        const now = performance.now();
+        if (!this._resumeDeadline) {
+            this._resumeDeadline = now + this._resumeGrace * 1000;
+            this._updateStatus('connecting', 'Reconnecting...');
+            this._emit('reconnecting');
+            this._resumeSession();
+            return;
+        }
+        if (now >= this._resumeDeadline) {
+            console.warn('[RDPClient] Session resume timed out');
+            this._handleDisconnect();
+            return;
+        }
+        this._resumeTimer = setTimeout(() => {
+            this._resumeTimer = null;
+            this._resumeSession();
+        }, this.options.reconnectDelay);
+    }
+
+    /**
+     * Open a new socket and ask the server to continue the session. The GFX
+     * worker, canvas and cursor cache are kept; the server resends only the
+     * messages after the counts reported here.
+     */
+    _resumeSession() {
+        const ws = this._createSocket();
+        ws.binaryType = 'arraybuffer';
+        this._ws = ws;
+        ws.onopen = () => {
+            this._sendMessage({
+                type: 'resume',
+                token: this._resumeToken,
+                gfxReceived: this._resumeCounts.gfx,
+                cursorReceived: this._resumeCounts.cursor
+            });
+        };
+        ws.onmessage = (e) => this._handleMessage(e);
+        ws.onerror = () => {};  // onclose follows and schedules the next attempt
+        ws.onclose = () => this._handleSocketClose(ws);
+    }
+
+    /**
+     * Resume on a fresh socket reporting no GFX received, so the server
+     * resends the whole GFX state. It refuses (and the client disconnects)
+     * when the browser would need cache entries only a reconnect restores.
+     */
+    _resyncGraphics() {
+        if (!this._resumeToken || !this._isConnected || this._pendingDisconnect) {
+            console.warn('[RDPClient] Graphics lost and the session cannot be resumed');
+            this.disconnect();
+            return;
+        }
+        console.warn('[RDPClient] Graphics lost, resyncing session');
+        const ws = this._ws;
+        if (ws) {
+            ws.onclose = null;
+            ws.close();
+        }
+        this._resumeCounts.gfx = 0;
+        this._unsentFrameAcks = [];
+        this._scheduleResume();
+    }
+
+    _handleResumed(msg) {
+        console.log('[RDPClient] Session resumed');
+        this._resumeDeadline = 0;
+        if (!this._isConnected) {
+            // resume() from a new page: set up as for a new session
+            this._handleConnected(msg);
+            return;
+        }
+        this._updateStatus('connected', 'Connected');
+        for (const ack of this._unsentFrameAcks) {
+            this._ws.send(ack);
+        }
+        this._unsentFrameAcks = [];
+        this._emit('reconnected');
+    }
+
+    _handleResumeFailed() {
+        console.warn('[RDPClient] Session could not be resumed');
+        const ws = this._ws;
+        if (ws) {
+            ws.onclose = null;
+            ws.close();
+        }
+        if (this._pendingConnect) {
+            this._pendingConnect.reject(new Error('Session could not be resumed'));
+            this._pendingConnect = null;
+        }
+        this._handleDisconnect();
+    }
+
+    /**
+     * Open the configured transport. WebTransportSocket shares WebSocket's
+     * interface and readyState values, so the rest of the client is unchanged.
+     * @returns {WebSocket|WebTransportSocket}
+     */
+    _createSocket() {
+        if (this.options.transport === 'webtransport') {
+            if (!this.options.webTransportUrl) {
+                console.warn('[RDPClient] transport is webtransport but webTransportUrl is not set, using WebSocket');
+            } else if (!isWebTransportSupported()) {
+                console.warn('[RDPClient] WebTransport not supported by this browser, using WebSocket');
+            } else {
+                console.log('[RDPClient] Using WebTransport:', this.options.webTransportUrl);
+                return new WebTransportSocket(this.options.webTransportUrl, {
+                    serverCertificateHashes: this.options.serverCertificateHashes
+                });
+            }
+        }
+        return new WebSocket(this.options.wsUrl);
+    }
+
     /**
      * Disconnect from the RDP server
      * @returns {Promise<void>} Resolves when disconnection is complete
@@ -1947,6 +2254,48 @@ export class RDPClient {
         return this._lastLatency || null;
     }
 
+    /**
+     * Lock the mouse to the remote desktop and switch to relative input.
+     * Mouse motion is then sent as deltas (batched per animation frame) rather
+     * than absolute positions; press Escape to release. Must be called from a
+     * user gesture (e.g. a click handler).
+     * @returns {void}
+     * @throws {Error} If not connected
+     */
+    requestPointerLock() {
+        if (!this._isConnected) throw new Error('Not connected');
+        this._canvas.requestPointerLock();
+    }
+
+    /**
+     * Release pointer lock and return to absolute mouse input
+     * @returns {void}
+     */
+    exitPointerLock() {
+        if (this._pointerLocked) {
+            document.exitPointerLock();
+        }
+    }
+
+    /**
+     * Check if pointer lock (relative mouse mode) is active
+     * @returns {boolean} True if the mouse is locked to the remote desktop
+     */
+    isPointerLocked() {
+        return this._pointerLocked;
+    }
+
+    /**
+     * Get GFX compositing metrics since the client was created
+     * damagedPixels is what endFrame actually composited; surfacePixels is
+     * what full-surface compositing of the same frames would have copied.
+     * @returns {{frames: number, damagedPixels: number, surfacePixels: number,
+     *            lastFrameDamagedPixels: number, lastFrameDamageRects: number}}
+     */
+    getGfxMetrics() {
+        return { ...this._gfxMetrics };
+    }
+
     /**
      * Get the security policy configuration (read-only)
      * The returned object is frozen and cannot be modified
@@ -2075,6 +2424,7 @@ export class RDPClient {
      */
     async destroy() {
         await this.disconnect();
+        document.removeEventListener('pointerlockchange', this._onPointerLockChange);
         if (this._gfxWorker) {
             this._gfxWorker.terminate();
             this._gfxWorker = null;
@@ -2159,10 +2509,51 @@ export class RDPClient {
 
     _sendMessage(msg) {
         if (this._ws && this._ws.readyState === WebSocket.OPEN) {
+            if (msg.type === 'mouse' || msg.type === 'key') {
+                this._queueInput(msg);
+                return;
+            }
+            // Keep control messages ordered after any input already queued
+            this._flushInput();
             this._ws.send(JSON.stringify(msg));
         }
     }
 
+    /**
+     * Encode a mouse/key message into binary INPT records.
+     * Moves (absolute or relative) are batched until the next animation
+     * frame, relative deltas summing into one record; buttons, wheel and
+     * keys flush immediately (with any queued moves ahead of them) so
+     * discrete input never waits on a frame.
+     */
+    _queueInput(msg) {
+        if (msg.type === 'mouse') {
+            encodeMouseInput(this._inputRecords, msg);
+        } else {
+            encodeKeyInput(this._inputRecords, msg);
+        }
+        
+        if (msg.type === 'mouse' && (msg.action === 'move' || msg.action === 'relmove')) {
+            if (this._inputFlushFrame === null) {
+                this._inputFlushFrame = requestAnimationFrame(() => {
+                    this._inputFlushFrame = null;
+                    this._flushInput();
+                });
+            }
+            return;
+        }
+        this._flushInput();
+    }
+
+    _flushInput() {
+        if (this._inputRecords.length === 0) return;
+        const records = this._inputRecords;
+        this._inputRecords = [];
+        if (this._ws && this._ws.readyState === WebSocket.OPEN) {
+            this._ws.send(buildInputBatch(records));
+        }
+    }
+
     _handleMessage(event) {
         if (event.data instanceof ArrayBuffer) {
             const bytes = new Uint8Array(event.data);
@@ -2182,22 +2573,47 @@ export class RDPClient {
                 const msg = parsePointerPosition(bytes);
                 if (msg) {
                     // Server-side cursor positioning (shadow cursor mode)
-                    // Most browsers don't allow setting cursor position
+                    // Most browsers don't allow setting cursor position, but while
+                    // the pointer is locked the overlay cursor is ours to move
+                    if (this._pointerLocked) {
+                        this._reconcilePointerPosition(msg.x, msg.y);
+                    }
                 }
                 return;
             }
+            
+            // Counted for session resume (audio and pointer positions are not replayed)
+            if (matchMagic(bytes, Magic.PSYS) || matchMagic(bytes, Magic.PSET) || matchMagic(bytes, Magic.PCUR)) {
+                this._resumeCounts.cursor++;
+            } else {
+                this._resumeCounts.gfx++;
+            }
+            
             if (matchMagic(bytes, Magic.PSYS)) {
                 const msg = parsePointerSystem(bytes);
                 if (msg) {
                     // System pointer: 0=NULL (hide), 1=DEFAULT (arrow)
                     this._canvas.style.cursor = msg.ptrType === 0 ? 'none' : 'default';
+                    this._cursorImage = null;
+                    this._cursorHidden = msg.ptrType === 0;
+                    if (this._pointerLocked) {
+                        this._showLocalCursor(this._pointerPos.x, this._pointerPos.y);
+                    }
                 }
                 return;
             }
             if (matchMagic(bytes, Magic.PSET)) {
                 const msg = parsePointerSet(bytes);
                 if (msg) {
-                    this._setCustomCursor(msg.width, msg.height, msg.hotspotX, msg.hotspotY, msg.bgraData);
+                    this._setCustomCursor(msg.width, msg.height, msg.hotspotX, msg.hotspotY,
+                                          msg.cacheId, msg.bgraData);
+                }
+                return;
+            }
+            if (matchMagic(bytes, Magic.PCUR)) {
+                const msg = parsePointerCached(bytes);
+                if (msg) {
+                    this._useCachedCursor(msg.cacheId);
                 }
                 return;
             }
@@ -2229,6 +2645,12 @@ export class RDPClient {
                 case 'connected':
                     this._handleConnected(msg);
                     break;
+                case 'resumed':
+                    this._handleResumed(msg);
+                    break;
+                case 'resume_failed':
+                    this._handleResumeFailed();
+                    break;
                 case 'resize':
                     this._handleServerResize(msg.width, msg.height);
                     break;
@@ -2267,6 +2689,8 @@ export class RDPClient {
 
     _handleConnected(msg) {
         this._isConnected = true;
+        this._resumeToken = msg.resumeToken || null;
+        this._resumeGrace = msg.resumeGrace || 0;
         this._updateStatus('connected', 'Connected');
         this._el.canvas.style.display = 'block';
         this._el.loading.style.display = 'none';
@@ -2302,6 +2726,21 @@ export class RDPClient {
     _handleDisconnect() {
         this._isConnected = false;
         this._ws = null;
+        this._resumeToken = null;
+        this._resumeDeadline = 0;
+        this._unsentFrameAcks = [];
+        if (this._resumeTimer) {
+            clearTimeout(this._resumeTimer);
+            this._resumeTimer = null;
+        }
+        this._inputRecords = [];
+        if (this._inputFlushFrame !== null) {
+            cancelAnimationFrame(this._inputFlushFrame);
+            this._inputFlushFrame = null;
+        }
+        this.exitPointerLock();
+        this._cursorCache.clear();
+        this._cursorImage = null;
         this._lastRequestedWidth = 0;
         this._lastRequestedHeight = 0;
         this._updateStatus('disconnected', 'Disconnected');
@@ -2369,7 +2808,7 @@ export class RDPClient {
             // or _initGfxWorkerCanvas will acquire context if transfer fails
             
             // Re-attach event listeners to new canvas
-            this._canvas.addEventListener('click', () => this._canvas.focus());
+            this._canvas.addEventListener('click', () => this._handleCanvasClick());
             this._canvas.addEventListener('mousemove', (e) => this._handleMouseMove(e));
             this._canvas.addEventListener('mousedown', (e) => this._handleMouseDown(e));
             this._canvas.addEventListener('mouseup', (e) => this._handleMouseUp(e));
@@ -2831,9 +3270,91 @@ export class RDPClient {
         };
     }
 
+    /**
+     * Apply a server pointer position while locked. Positions we predicted
+     * recently are echoes of our own input (possibly stale, since newer
+     * motion is in flight) and are ignored; anything else is a server-side
+     * warp and replaces the prediction.
+     * @private
+     */
+    _reconcilePointerPosition(x, y) {
+        for (const p of this._recentPointerPositions) {
+            if (p.x === x && p.y === y) return;
+        }
+        this._pointerPos = { x, y };
+        this._recentPointerPositions = [];
+        this._showLocalCursor(x, y);
+    }
+
+    /**
+     * Draw the remote cursor bitmap at remote desktop coordinates, falling
+     * back to the API cursor arrow before the server has set a pointer
+     * @private
+     */
+    _showLocalCursor(x, y) {
+        const cursor = this._el.localCursor;
+        if (this._cursorHidden) {
+            cursor.classList.remove('visible');
+            this._hideApiCursor();
+            return;
+        }
+        if (!this._cursorImage) {
+            cursor.classList.remove('visible');
+            this._showApiCursor(x, y);
+            return;
+        }
+        this._hideApiCursor();
+        
+        const img = this._cursorImage;
+        const rect = this._canvas.getBoundingClientRect();
+        const scaleX = rect.width / this._canvas.width;
+        const scaleY = rect.height / this._canvas.height;
+        if (cursor.getAttribute('src') !== img.url) {
+            cursor.setAttribute('src', img.url);
+        }
+        cursor.style.width = `${img.width * scaleX}px`;
+        cursor.style.height = `${img.height * scaleY}px`;
+        cursor.style.left = `${(x - img.hotspotX) * scaleX}px`;
+        cursor.style.top = `${(y - img.hotspotY) * scaleY}px`;
+        cursor.classList.add('visible');
+    }
+
+    _hideLocalCursor() {
+        this._el.localCursor.classList.remove('visible');
+        this._hideApiCursor();
+    }
+
+    _handleCanvasClick() {
+        this._canvas.focus();
+        if (this.options.pointerLock && this._isConnected && !this._pointerLocked) {
+            this._canvas.requestPointerLock();
+        }
+    }
+
+    _handlePointerLockChange() {
+        const locked = this._shadow.pointerLockElement === this._canvas;
+        if (locked === this._pointerLocked) return;
+        
+        this._pointerLocked = locked;
+        this._relRemainder = { x: 0, y: 0 };
+        this._recentPointerPositions = [];
+        if (locked) {
+            // The OS cursor is hidden while locked; draw ours at the remote position
+            this._showLocalCursor(this._pointerPos.x, this._pointerPos.y);
+        } else {
+            this._hideLocalCursor();
+        }
+        this._emit('pointerLock', { locked });
+    }
+
     _handleMouseMove(e) {
         if (!this._isConnected) return;
         
+        if (this._pointerLocked) {
+            this._handleRelativeMove(e);
+            return;
+        }
+        
         // Hide API cursor when real mouse moves
         this._hideApiCursor();
         
@@ -2842,35 +3363,73 @@ export class RDPClient {
         this._lastMouseSend = now;
         
         const pos = this._getMousePos(e);
+        this._pointerPos = pos;
         this._sendMessage({ type: 'mouse', action: 'move', x: pos.x, y: pos.y });
     }
 
+    /**
+     * Pointer-locked motion: scale movementX/Y to remote pixels, keep the
+     * sub-pixel remainder, and queue a relative move. No throttling here -
+     * every event's delta counts and _queueInput sums them per frame.
+     * @private
+     */
+    _handleRelativeMove(e) {
+        const rect = this._canvas.getBoundingClientRect();
+        const fx = e.movementX * (this._canvas.width / rect.width) + this._relRemainder.x;
+        const fy = e.movementY * (this._canvas.height / rect.height) + this._relRemainder.y;
+        const dx = Math.trunc(fx);
+        const dy = Math.trunc(fy);
+        this._relRemainder = { x: fx - dx, y: fy - dy };
+        if (dx === 0 && dy === 0) return;
+        
+        // Predict locally: the overlay moves now, not when the server echoes
+        this._pointerPos = {
+            x: Math.max(0, Math.min(this._canvas.width - 1, this._pointerPos.x + dx)),
+            y: Math.max(0, Math.min(this._canvas.height - 1, this._pointerPos.y + dy))
+        };
+        this._recentPointerPositions.push(this._pointerPos);
+        if (this._recentPointerPositions.length > POINTER_ECHO_HISTORY) {
+            this._recentPointerPositions.shift();
+        }
+        this._showLocalCursor(this._pointerPos.x, this._pointerPos.y);
+        
+        this._sendMessage({ type: 'mouse', action: 'relmove', dx, dy });
+    }
+
     _handleMouseDown(e) {
         if (!this._isConnected) return;
         e.preventDefault();
         this._canvas.focus();
         
-        const pos = this._getMousePos(e);
-        this._sendMessage({ type: 'mouse', action: 'down', button: e.button, x: pos.x, y: pos.y });
+        const pos = this._pointerLocked ? this._pointerPos : this._getMousePos(e);
+        this._sendMessage({
+            type: 'mouse', action: 'down', button: e.button,
+            x: pos.x, y: pos.y, relative: this._pointerLocked
+        });
     }
 
     _handleMouseUp(e) {
         if (!this._isConnected) return;
         e.preventDefault();
         
-        const pos = this._getMousePos(e);
-        this._sendMessage({ type: 'mouse', action: 'up', button: e.button, x: pos.x, y: pos.y });
+        const pos = this._pointerLocked ? this._pointerPos : this._getMousePos(e);
+        this._sendMessage({
+            type: 'mouse', action: 'up', button: e.button,
+            x: pos.x, y: pos.y, relative: this._pointerLocked
+        });
     }
 
     _handleMouseWheel(e) {
         if (!this._isConnected) return;
         e.preventDefault();
         
-        const pos = this._getMousePos(e);
+        // Locked wheel events carry no position: an absolute one would warp
+        // the server pointer to our estimate of where it is
+        const pos = this._pointerLocked ? this._pointerPos : this._getMousePos(e);
         this._sendMessage({ 
             type: 'mouse', action: 'wheel', 
             deltaX: e.deltaX, deltaY: e.deltaY, 
-            x: pos.x, y: pos.y 
+            x: pos.x, y: pos.y, relative: this._pointerLocked
         });
     }
 
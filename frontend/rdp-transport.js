@@ -0,0 +1,236 @@
+/**
+ * WebTransport socket - WebSocket-compatible wrapper over an HTTP/3 session
+ *
+ * Mirrors backend/webtransport.py. The server splits traffic so one lost
+ * packet cannot stall unrelated messages:
+ *   - Datagrams (unreliable): OPUS audio frames, PPOS pointer positions
+ *   - GFX stream (server-opened, unidirectional, reliable): all GFX messages
+ *   - Control stream (client-opened, bidirectional, reliable): JSON, input,
+ *     frame acks, cursor shape changes and anything too large for a datagram
+ *
+ * Stream framing: kind(1) + length(4, LE) + payload, kind 0 = binary, 1 = text.
+ *
+ * Exposes the subset of the WebSocket API that RDPClient uses (readyState,
+ * send, close, onopen/onmessage/onerror/onclose) so it is a drop-in swap.
+ */
+
+const FRAME_BINARY = 0;
+const FRAME_TEXT = 1;
+const FRAME_HEADER_SIZE = 5;
+
+const textEncoder = new TextEncoder();
+const textDecoder = new TextDecoder();
+
+/**
+ * Check whether the browser supports WebTransport
+ * @returns {boolean}
+ */
+export function isWebTransportSupported() {
+    return typeof WebTransport !== 'undefined';
+}
+
+/**
+ * Frame one message for a WebTransport stream
+ * @param {string|ArrayBuffer|Uint8Array} message
+ * @returns {Uint8Array}
+ */
+export function frameMessage(message) {
+    let kind = FRAME_BINARY;
+    let payload;
+    if (typeof message === 'string') {
+        kind = FRAME_TEXT;
+        payload = textEncoder.encode(message);
+    } else if (message instanceof Uint8Array) {
+        payload = message;
+    } else {
+        payload = new Uint8Array(message);
+    }
+
+    const framed = new Uint8Array(FRAME_HEADER_SIZE + payload.length);
+    const view = new DataView(framed.buffer);
+    view.setUint8(0, kind);
+    view.setUint32(1, payload.length, true);
+    framed.set(payload, FRAME_HEADER_SIZE);
+    return framed;
+}
+
+export class WebTransportSocket {
+    static CONNECTING = 0;
+    static OPEN = 1;
+    static CLOSING = 2;
+    static CLOSED = 3;
+
+    /**
+     * @param {string} url - https:// URL of the backend WebTransport endpoint
+     * @param {Object} [options]
+     * @param {Array<{algorithm: string, value: BufferSource}>} [options.serverCertificateHashes]
+     *        Pin a self-signed certificate (ECDSA, valid for at most 14 days)
+     */
+    constructor(url, options = {}) {
+        this.readyState = WebTransportSocket.CONNECTING;
+        this.binaryType = 'arraybuffer';
+        this.onopen = null;
+        this.onmessage = null;
+        this.onerror = null;
+        this.onclose = null;
+        
+        this._writer = null;
+        this._closeNotified = false;
+        
+        const transportOptions = {};
+        if (options.serverCertificateHashes && options.serverCertificateHashes.length > 0) {
+            transportOptions.serverCertificateHashes = options.serverCertificateHashes;
+        }
+        
+        this._transport = new WebTransport(url, transportOptions);
+        this._transport.closed
+            .catch(() => {})
+            .finally(() => this._notifyClose());
+        this._open();
+    }
+
+    async _open() {
+        try {
+            await this._transport.ready;
+            const control = await this._transport.createBidirectionalStream();
+            this._writer = control.writable.getWriter();
+            
+            this.readyState = WebTransportSocket.OPEN;
+            this._readFramedStream(control.readable);
+            this._readIncomingStreams();
+            this._readDatagrams();
+            if (this.onopen) this.onopen({ type: 'open' });
+        } catch (e) {
+            console.error('[WebTransport] Connection failed:', e);
+            if (this.onerror) this.onerror({ type: 'error', error: e });
+            this._notifyClose();
+        }
+    }
+
+    /**
+     * Send a text or binary message on the control stream
+     * @param {string|ArrayBuffer|Uint8Array} message
+     */
+    send(message) {
+        if (this.readyState !== WebTransportSocket.OPEN) return;
+        this._writer.write(frameMessage(message)).catch((e) => {
+            console.warn('[WebTransport] Send failed:', e);
+        });
+    }
+
+    close() {
+        if (this.readyState >= WebTransportSocket.CLOSING) return;
+        this.readyState = WebTransportSocket.CLOSING;
+        try {
+            this._transport.close();
+        } catch (e) {
+            this._notifyClose();
+        }
+    }
+
+    _notifyClose() {
+        if (this._closeNotified) return;
+        this._closeNotified = true;
+        this.readyState = WebTransportSocket.CLOSED;
+        if (this.onclose) this.onclose({ type: 'close' });
+    }
+
+    _dispatch(data) {
+        if (this.onmessage && this.readyState === WebTransportSocket.OPEN) {
+            this.onmessage({ data });
+        }
+    }
+
+    /**
+     * Read server-opened unidirectional streams (GFX)
+     */
+    async _readIncomingStreams() {
+        const reader = this._transport.incomingUnidirectionalStreams.getReader();
+        try {
+            for (;;) {
+                const { value: stream, done } = await reader.read();
+                if (done) break;
+                this._readFramedStream(stream);
+            }
+        } catch (e) {
+            // Session closed
+        }
+    }
+
+    /**
+     * Split a stream into framed messages and dispatch each one.
+     * Chunks are queued as they arrive and each byte is copied once, when
+     * the frame it belongs to is complete (large GFX batches arrive in many
+     * small QUIC chunks).
+     * @param {ReadableStream<Uint8Array>} stream
+     */
+    async _readFramedStream(stream) {
+        const reader = stream.getReader();
+        const chunks = [];
+        let pending = 0;
+        let kind = -1;      // Kind of the frame whose header was read, -1 while waiting for one
+        let length = 0;
+        
+        // Move the next n queued bytes into a new array
+        const take = (n) => {
+            const out = new Uint8Array(n);
+            let filled = 0;
+            while (filled < n) {
+                const chunk = chunks[0];
+                const count = Math.min(chunk.length, n - filled);
+                out.set(chunk.subarray(0, count), filled);
+                filled += count;
+                if (count === chunk.length) {
+                    chunks.shift();
+                } else {
+                    chunks[0] = chunk.subarray(count);
+                }
+            }
+            pending -= n;
+            return out;
+        };
+        
+        try {
+            for (;;) {
+                const { value, done } = await reader.read();
+                if (done) break;
+                if (value.length === 0) continue;
+                chunks.push(value);
+                pending += value.length;
+                
+                for (;;) {
+                    if (kind < 0) {
+                        if (pending < FRAME_HEADER_SIZE) break;
+                        const header = new DataView(take(FRAME_HEADER_SIZE).buffer);
+                        kind = header.getUint8(0);
+                        length = header.getUint32(1, true);
+                    }
+                    if (pending < length) break;
+                    
+                    // A fresh array per message, so each one owns a transferable ArrayBuffer
+                    const payload = take(length);
+                    this._dispatch(kind === FRAME_TEXT ? textDecoder.decode(payload) : payload.buffer);
+                    kind = -1;
+                }
+            }
+        } catch (e) {
+            // Stream reset or session closed
+        }
+    }
+
+    /**
+     * Read unreliable datagrams (audio, pointer position)
+     */
+    async _readDatagrams() {
+        const reader = this._transport.datagrams.readable.getReader();
+        try {
+            for (;;) {
+                const { value, done } = await reader.read();
+                if (done) break;
+                this._dispatch(value.slice().buffer);
+            }
+        } catch (e) {
+            // Session closed
+        }
+    }
+}
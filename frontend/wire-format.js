@@ -39,6 +39,7 @@ export const Magic = {
     
     // Backchannel (browser → server)
     FACK: new Uint8Array([0x46, 0x41, 0x43, 0x4B]),  // "FACK" - frameAck
+    INPT: new Uint8Array([0x49, 0x4E, 0x50, 0x54]),  // "INPT" - input record batch
     
     // Audio
     OPUS: new Uint8Array([0x4F, 0x50, 0x55, 0x53]),  // "OPUS" - Opus audio
@@ -50,9 +51,16 @@ export const Magic = {
     // Pointer/Cursor
     PPOS: new Uint8Array([0x50, 0x50, 0x4F, 0x53]),  // "PPOS" - pointerPosition
     PSYS: new Uint8Array([0x50, 0x53, 0x59, 0x53]),  // "PSYS" - pointerSystem
-    PSET: new Uint8Array([0x50, 0x53, 0x45, 0x54]),  // "PSET" - pointerSet
+    PSET: new Uint8Array([0x50, 0x53, 0x45, 0x54]),  // "PSET" - pointerSet (stored in cursor cache)
+    PCUR: new Uint8Array([0x50, 0x43, 0x55, 0x52]),  // "PCUR" - pointerCached (cursor cache hit)
+    
+    // Container
+    BTCH: new Uint8Array([0x42, 0x54, 0x43, 0x48]),  // "BTCH" - batch of messages
 };
 
+// Batch flags
+export const BATCH_FLAG_DEFLATE = 0x01;  // payload is raw deflate (no zlib header)
+
 // ============================================================================
 // Message type detection
 // ============================================================================
@@ -475,17 +483,18 @@ export function parsePointerSystem(data) {
 /**
  * Parse pointerSet message
  * Layout: PSET(4) + width(2) + height(2) + hotspotX(2) + hotspotY(2) + 
- *         dataLen(4) + bgra_data(variable) = 16 + dataLen bytes
+ *         cacheId(2) + dataLen(4) + bgra_data(variable) = 18 + dataLen bytes
  */
 export function parsePointerSet(data) {
-    if (data.length < 16) return null;
+    if (data.length < 18) return null;
     const width = readU16LE(data, 4);
     const height = readU16LE(data, 6);
     const hotspotX = readU16LE(data, 8);
     const hotspotY = readU16LE(data, 10);
-    const dataLen = readU32LE(data, 12);
+    const cacheId = readU16LE(data, 12);
+    const dataLen = readU32LE(data, 14) >>> 0;
     
-    if (data.length < 16 + dataLen) return null;
+    if (data.length < 18 + dataLen) return null;
     
     return {
         type: 'pointerSet',
@@ -493,10 +502,59 @@ export function parsePointerSet(data) {
         height,
         hotspotX,
         hotspotY,
-        bgraData: data.subarray(16, 16 + dataLen)
+        cacheId,
+        bgraData: data.subarray(18, 18 + dataLen)
     };
 }
 
+/**
+ * Parse pointerCached message
+ * Layout: PCUR(4) + cacheId(2) = 6 bytes
+ */
+export function parsePointerCached(data) {
+    if (data.length < 6) return null;
+    return {
+        type: 'pointerCached',
+        cacheId: readU16LE(data, 4)
+    };
+}
+
+/**
+ * Parse batch container header
+ * Layout: BTCH(4) + flags(1) + count(2) + rawLen(4) + payload
+ * The payload (raw-deflated when BATCH_FLAG_DEFLATE is set) holds
+ * count x [len(4) + message]; split it with splitBatchPayload().
+ */
+export function parseBatch(data) {
+    if (data.length < 11) return null;
+    return {
+        type: 'batch',
+        flags: data[4],
+        count: readU16LE(data, 5),
+        rawLen: readU32LE(data, 7),
+        payload: data.subarray(11)
+    };
+}
+
+/**
+ * Split an (inflated) batch payload into its sub-messages
+ * @param {Uint8Array} payload - count x [len(4) + message]
+ * @returns {Uint8Array[]|null} Views into payload, or null if truncated
+ */
+export function splitBatchPayload(payload, count) {
+    const messages = [];
+    let offset = 0;
+    for (let i = 0; i < count; i++) {
+        if (offset + 4 > payload.length) return null;
+        const len = readU32LE(payload, offset);
+        offset += 4;
+        if (offset + len > payload.length) return null;
+        messages.push(payload.subarray(offset, offset + len));
+        offset += len;
+    }
+    return messages;
+}
+
 /**
  * Parse H.264 video frame (legacy format from existing implementation)
  * Layout: H264(4) + frameId(4) + surfaceId(2) + codecId(2) + frameType(1) + 
@@ -547,6 +605,234 @@ export function buildFrameAck(frameId, totalFramesDecoded, queueDepth = 0) {
     return data;
 }
 
+// ============================================================================
+// Input records (browser → server)
+// ============================================================================
+
+/**
+ * Input record kinds. The kind byte also fixes the record size, so the
+ * server walks a batch without per-record length fields.
+ */
+export const InputRecord = {
+    MOUSE: 1,       // 8 bytes: kind(1) + pad(1) + pointerFlags(2) + x(2) + y(2)
+    SCANCODE: 2,    // 6 bytes: kind(1) + pad(1) + kbdFlags(2) + scancode(2)
+    UNICODE: 3,     // 6 bytes: kind(1) + pad(1) + kbdFlags(2) + codeUnit(2)
+    MOUSE_REL: 4,   // 8 bytes: kind(1) + pad(1) + pointerFlags(2) + dx(2) + dy(2), int16 deltas
+};
+
+export const INPUT_MOUSE_RECORD_SIZE = 8;
+export const INPUT_KEY_RECORD_SIZE = 6;
+
+// RDP pointer/keyboard flags (MS-RDPBCGR 2.2.8.1.1.3.1.1.3 / .1)
+const PTR_FLAGS_HWHEEL = 0x0400;
+const PTR_FLAGS_WHEEL = 0x0200;
+const PTR_FLAGS_MOVE = 0x0800;
+const PTR_FLAGS_DOWN = 0x8000;
+const PTR_FLAGS_BUTTON1 = 0x1000;  // Left
+const PTR_FLAGS_BUTTON2 = 0x2000;  // Right
+const PTR_FLAGS_BUTTON3 = 0x4000;  // Middle
+const KBD_FLAGS_EXTENDED = 0x0100;
+const KBD_FLAGS_RELEASE = 0x8000;
+
+// DOM MouseEvent.button -> RDP button flag
+const POINTER_BUTTONS = [PTR_FLAGS_BUTTON1, PTR_FLAGS_BUTTON3, PTR_FLAGS_BUTTON2];
+
+/**
+ * DOM KeyboardEvent.code -> RDP scancode.
+ * Mirrors SCANCODE_MAP in backend/rdp_bridge.py.
+ */
+const SCANCODES = {
+    Escape: 0x01, Digit1: 0x02, Digit2: 0x03, Digit3: 0x04,
+    Digit4: 0x05, Digit5: 0x06, Digit6: 0x07, Digit7: 0x08,
+    Digit8: 0x09, Digit9: 0x0A, Digit0: 0x0B, Minus: 0x0C,
+    Equal: 0x0D, Backspace: 0x0E, Tab: 0x0F, KeyQ: 0x10,
+    KeyW: 0x11, KeyE: 0x12, KeyR: 0x13, KeyT: 0x14,
+    KeyY: 0x15, KeyU: 0x16, KeyI: 0x17, KeyO: 0x18,
+    KeyP: 0x19, BracketLeft: 0x1A, BracketRight: 0x1B,
+    Enter: 0x1C, ControlLeft: 0x1D, KeyA: 0x1E, KeyS: 0x1F,
+    KeyD: 0x20, KeyF: 0x21, KeyG: 0x22, KeyH: 0x23,
+    KeyJ: 0x24, KeyK: 0x25, KeyL: 0x26, Semicolon: 0x27,
+    Quote: 0x28, Backquote: 0x29, ShiftLeft: 0x2A,
+    Backslash: 0x2B, KeyZ: 0x2C, KeyX: 0x2D, KeyC: 0x2E,
+    KeyV: 0x2F, KeyB: 0x30, KeyN: 0x31, KeyM: 0x32,
+    Comma: 0x33, Period: 0x34, Slash: 0x35, ShiftRight: 0x36,
+    NumpadMultiply: 0x37, AltLeft: 0x38, Space: 0x39,
+    CapsLock: 0x3A, F1: 0x3B, F2: 0x3C, F3: 0x3D,
+    F4: 0x3E, F5: 0x3F, F6: 0x40, F7: 0x41, F8: 0x42,
+    F9: 0x43, F10: 0x44, NumLock: 0x45, ScrollLock: 0x46,
+    Numpad7: 0x47, Numpad8: 0x48, Numpad9: 0x49,
+    NumpadSubtract: 0x4A, Numpad4: 0x4B, Numpad5: 0x4C,
+    Numpad6: 0x4D, NumpadAdd: 0x4E, Numpad1: 0x4F,
+    Numpad2: 0x50, Numpad3: 0x51, Numpad0: 0x52,
+    NumpadDecimal: 0x53, F11: 0x57, F12: 0x58,
+    // Extended keys (need EXTENDED flag)
+    NumpadEnter: 0x1C, ControlRight: 0x1D, NumpadDivide: 0x35,
+    PrintScreen: 0x37, AltRight: 0x38, Home: 0x47,
+    ArrowUp: 0x48, PageUp: 0x49, ArrowLeft: 0x4B,
+    ArrowRight: 0x4D, End: 0x4F, ArrowDown: 0x50,
+    PageDown: 0x51, Insert: 0x52, Delete: 0x53,
+    MetaLeft: 0x5B, MetaRight: 0x5C, ContextMenu: 0x5D,
+};
+
+const EXTENDED_KEYS = new Set([
+    'NumpadEnter', 'ControlRight', 'NumpadDivide', 'PrintScreen',
+    'AltRight', 'Home', 'ArrowUp', 'PageUp', 'ArrowLeft',
+    'ArrowRight', 'End', 'ArrowDown', 'PageDown', 'Insert', 'Delete',
+    'MetaLeft', 'MetaRight', 'ContextMenu',
+]);
+
+// Printable-looking keys that must still go out as scancodes
+const SCANCODE_ONLY_KEYS = new Set([
+    'Tab', 'Enter', 'Backspace', 'Escape', 'Space',
+    'CapsLock', 'NumLock', 'ScrollLock',
+]);
+
+/**
+ * Clamp a browser wheel delta into the 9-bit two's complement rotation field.
+ * Browser: positive = down/right. RDP: positive = up/left, so the delta is negated.
+ */
+function wheelRotationBits(delta) {
+    const rotation = Math.max(-256, Math.min(255, -Math.trunc(delta)));
+    return rotation & 0x1FF;
+}
+
+/**
+ * Append the RDP pointer record(s) for a JSON-style mouse message.
+ * Same mapping as RDPBridge.send_mouse_event: a wheel message with both
+ * deltas yields two records (vertical first).
+ * 
+ * Relative input (pointer lock): action 'relmove' carries dx/dy and is
+ * summed into a directly preceding relative move, so a frame's worth of
+ * motion becomes one record; 'down'/'up'/'wheel' with relative set become
+ * zero-delta relative records.
+ * @param {Array} records - Output list of {kind, flags, x, y}
+ * @param {Object} msg - {action, x, y, dx, dy, button, relative, deltaX, deltaY}
+ */
+export function encodeMouseInput(records, msg) {
+    if (msg.action === 'relmove') {
+        const dx = Math.trunc(msg.dx || 0);
+        const dy = Math.trunc(msg.dy || 0);
+        if (dx === 0 && dy === 0) return;
+        
+        const last = records[records.length - 1];
+        if (last && last.kind === InputRecord.MOUSE_REL && last.flags === PTR_FLAGS_MOVE) {
+            const sx = last.x + dx;
+            const sy = last.y + dy;
+            if (sx >= -0x8000 && sx <= 0x7FFF && sy >= -0x8000 && sy <= 0x7FFF) {
+                last.x = sx;
+                last.y = sy;
+                return;
+            }
+        }
+        records.push({
+            kind: InputRecord.MOUSE_REL, flags: PTR_FLAGS_MOVE,
+            x: Math.max(-0x8000, Math.min(0x7FFF, dx)),
+            y: Math.max(-0x8000, Math.min(0x7FFF, dy))
+        });
+        return;
+    }
+    
+    const x = Math.max(0, Math.min(0xFFFF, msg.x | 0));
+    const y = Math.max(0, Math.min(0xFFFF, msg.y | 0));
+    
+    switch (msg.action) {
+        case 'move':
+            records.push({ kind: InputRecord.MOUSE, flags: PTR_FLAGS_MOVE, x, y });
+            break;
+        case 'down':
+        case 'up': {
+            const button = POINTER_BUTTONS[msg.button] || PTR_FLAGS_BUTTON1;
+            const flags = msg.action === 'down' ? button | PTR_FLAGS_DOWN : button;
+            if (msg.relative) {
+                records.push({ kind: InputRecord.MOUSE_REL, flags, x: 0, y: 0 });
+            } else {
+                records.push({ kind: InputRecord.MOUSE, flags, x, y });
+            }
+            break;
+        }
+        case 'wheel': {
+            // Relative wheel records carry no position: the bridge rotates
+            // the wheel wherever the server pointer already is
+            const kind = msg.relative ? InputRecord.MOUSE_REL : InputRecord.MOUSE;
+            const px = msg.relative ? 0 : x;
+            const py = msg.relative ? 0 : y;
+            const dy = Math.trunc(msg.deltaY || 0);
+            const dx = Math.trunc(msg.deltaX || 0);
+            if (dy !== 0) {
+                records.push({ kind, flags: PTR_FLAGS_WHEEL | wheelRotationBits(dy), x: px, y: py });
+            }
+            if (dx !== 0) {
+                records.push({ kind, flags: PTR_FLAGS_HWHEEL | wheelRotationBits(dx), x: px, y: py });
+            }
+            break;
+        }
+    }
+}
+
+function isPointerRecord(rec) {
+    return rec.kind === InputRecord.MOUSE || rec.kind === InputRecord.MOUSE_REL;
+}
+
+/**
+ * Append the RDP keyboard record for a JSON-style key message.
+ * Same decision as RDPBridge.send_key_event: single printable characters
+ * without Ctrl/Alt/Meta go out as Unicode, everything else as a scancode.
+ * Keys with no scancode are dropped, as on the server.
+ * @param {Array} records - Output list of {kind, flags, code}
+ * @param {Object} msg - {action, key, code, ctrlKey, altKey, metaKey}
+ */
+export function encodeKeyInput(records, msg) {
+    const key = msg.key || '';
+    const code = msg.code || '';
+    let flags = msg.action === 'down' ? 0 : KBD_FLAGS_RELEASE;
+    
+    const useUnicode = key.length === 1 &&
+        !msg.ctrlKey && !msg.altKey && !msg.metaKey &&
+        !EXTENDED_KEYS.has(code) && !SCANCODE_ONLY_KEYS.has(code);
+    
+    if (useUnicode) {
+        records.push({ kind: InputRecord.UNICODE, flags, code: key.charCodeAt(0) });
+        return;
+    }
+    
+    const scancode = SCANCODES[code];
+    if (scancode === undefined) return;
+    if (EXTENDED_KEYS.has(code)) flags |= KBD_FLAGS_EXTENDED;
+    records.push({ kind: InputRecord.SCANCODE, flags, code: scancode });
+}
+
+/**
+ * Build input batch message
+ * Layout: INPT(4) + records, each record sized by its kind byte
+ *   MOUSE:            kind(1) + pad(1) + flags(2) + x(2) + y(2)     = 8 bytes
+ *   MOUSE_REL:        kind(1) + pad(1) + flags(2) + dx(2) + dy(2)   = 8 bytes
+ *   SCANCODE/UNICODE: kind(1) + pad(1) + flags(2) + code(2)         = 6 bytes
+ * Records are applied by the server in order.
+ */
+export function buildInputBatch(records) {
+    let size = 4;
+    for (const rec of records) {
+        size += isPointerRecord(rec) ? INPUT_MOUSE_RECORD_SIZE : INPUT_KEY_RECORD_SIZE;
+    }
+    
+    const data = new Uint8Array(size);
+    data.set(Magic.INPT, 0);
+    let offset = 4;
+    for (const rec of records) {
+        data[offset] = rec.kind;
+        writeU16LE(data, offset + 2, rec.flags);
+        if (isPointerRecord(rec)) {
+            writeU16LE(data, offset + 4, rec.x);
+            writeU16LE(data, offset + 6, rec.y);
+            offset += INPUT_MOUSE_RECORD_SIZE;
+        } else {
+            writeU16LE(data, offset + 4, rec.code);
+            offset += INPUT_KEY_RECORD_SIZE;
+        }
+    }
+    return data;
+}
+
 // ============================================================================
 // Unified message parser
 // ============================================================================
@@ -581,6 +867,8 @@ export function parseMessage(data) {
         case 'PPOS': return parsePointerPosition(data);
         case 'PSYS': return parsePointerSystem(data);
         case 'PSET': return parsePointerSet(data);
+        case 'PCUR': return parsePointerCached(data);
+        case 'BTCH': return parseBatch(data);
         default: return null;
     }
 }